@@ -0,0 +1,33 @@
+#ifndef DCT_STATS_H
+#define DCT_STATS_H
+
+#include <cstdint>
+#include <vector>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+
+// 直接由 DCT 系数得到的图像统计，不做逆 DCT 和颜色转换
+struct DctImageStats {
+    uint64_t perceptualHash = 0;          // 64 位 DCT 感知哈希
+    double mean[3] = {0, 0, 0};           // Y、Cb、Cr 均值（由各块 DC 系数得到，0~255）
+    double meanRGB[3] = {0, 0, 0};        // 由均值换算的 R、G、B
+    std::vector<uint32_t> histogram[3];   // Y、Cb、Cr 的 256 级直方图，每个 8x8 块的均值计一次
+    int lumaMapWidth = 0;                 // 1/8 尺寸亮度图的宽高
+    int lumaMapHeight = 0;
+    std::vector<uint8_t> lumaMap;         // 每个 Y 块的均值，按行存储
+};
+
+// 对已完成 huffmanDecode 的 imgData（系数仍为量化值、Zig-Zag 顺序）计算统计量，
+// 只读取每块的 DC 系数并乘以量化表第一项，不修改 imgData
+void computeDctStats(const ImageData &imgData, DctImageStats &stats);
+
+// 熵解码后直接计算统计量：imgData 需已初始化块结构；不支持的采样方式返回 UnsupportedSampling
+DecodeStatus decodeDctStats(ImageData &imgData, DctImageStats &stats);
+
+// 经典 pHash：把灰度图按块平均缩放到 32x32，做 2D DCT，取左上 8x8 低频系数与中位数比较得到 64 位
+uint64_t perceptualHash(const std::vector<uint8_t> &gray, int width, int height);
+
+// 两个哈希之间不同的比特数
+int hammingDistance(uint64_t a, uint64_t b);
+
+#endif // DCT_STATS_H
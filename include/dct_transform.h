@@ -0,0 +1,28 @@
+#ifndef DCT_TRANSFORM_H
+#define DCT_TRANSFORM_H
+
+#include <string>
+#include "jpeg_header_parser.h"
+
+// 无损的 DCT 域几何变换
+enum class DctTransform {
+    None,
+    FlipHorizontal,  // 左右镜像
+    FlipVertical,    // 上下镜像
+    Transpose,       // 沿主对角线转置
+    Rotate90,        // 顺时针 90 度
+    Rotate180,
+    Rotate270,       // 顺时针 270 度（逆时针 90 度）
+};
+
+// 由名字解析变换（flip-h、flip-v、transpose、rot90、rot180、rot270），未知名字返回 false
+bool parseDctTransform(const std::string &name, DctTransform &transform);
+
+// 在 huffmanDecode 之后、inverseQuantize 之前调用：系数仍为量化值、Zig-Zag 顺序。
+// 通过重排 8x8 块、翻转系数符号与转置块内系数完成变换，不做 IDCT，结果可直接用于无损重新编码。
+// 转置类变换同时转置量化表。宽高不是 MCU 整数倍时，会移到左边或上边的不完整 MCU 被裁掉
+// （与 jpegtran -trim 相同），否则填充区域会出现在图像内。系数变换是精确的，但重建出的像素与
+// 像素域变换只在逆 DCT 舍入范围内一致。
+void transformCoefficients(ImageData &imgData, DctTransform transform);
+
+#endif // DCT_TRANSFORM_H
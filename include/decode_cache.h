@@ -0,0 +1,136 @@
+#ifndef DECODE_CACHE_H
+#define DECODE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 64 位非加密哈希（XXH64 算法），每次处理 32 字节，吞吐接近内存带宽
+uint64_t hashBytes(const uint8_t *data, size_t size, uint64_t seed = 0);
+
+// 缓存键：JPEG 字节的哈希与长度，加上规范化的解码选项（如 "crop=0,0,64,64 luma format=bmp"）。
+// 内容相同的请求共享结果，与文件名或请求方式无关
+struct DecodeCacheKey {
+    uint64_t contentHash = 0;
+    uint64_t contentSize = 0;
+    uint64_t optionsHash = 0;
+    std::string options;
+
+    bool operator==(const DecodeCacheKey &other) const {
+        return contentHash == other.contentHash && contentSize == other.contentSize &&
+               optionsHash == other.optionsHash && options == other.options;
+    }
+};
+
+DecodeCacheKey makeDecodeCacheKey(const uint8_t *data, size_t size, const std::string &options);
+
+struct DecodeCacheKeyHash {
+    size_t operator()(const DecodeCacheKey &key) const {
+        return static_cast<size_t>(key.contentHash ^ (key.optionsHash * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+// 缓存的解码结果（响应中的像素或 BMP 文件字节），创建后只读，可被多个线程同时持有。
+// 来自磁盘层时数据直接指向文件映射，最后一个持有者释放时解除映射
+class CachedImage {
+public:
+    CachedImage(int width, int height, int channels, std::vector<uint8_t> bytes);
+    ~CachedImage();
+    CachedImage(const CachedImage &) = delete;
+    CachedImage &operator=(const CachedImage &) = delete;
+
+    // 映射 path 并校验文件头与 key，失败返回 nullptr
+    static std::shared_ptr<const CachedImage> map(const std::string &path, const DecodeCacheKey &key);
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    const uint8_t *data() const { return mapping ? mappedData : bytes.data(); }
+    size_t size() const { return mapping ? mappedSize : bytes.size(); }
+    bool mapped() const { return mapping != nullptr; }
+
+private:
+    CachedImage() = default;
+    std::vector<uint8_t> bytes;
+    void *mapping = nullptr;
+    size_t mappingLength = 0;
+    const uint8_t *mappedData = nullptr;
+    size_t mappedSize = 0;
+};
+
+struct DecodeCacheOptions {
+    size_t memoryBytes = 256u << 20;  // 内存层容量（按数据字节计），0 表示不缓存在内存中
+    std::string diskDirectory;        // 磁盘层目录，为空表示不启用；目录中已有的缓存文件会被沿用
+    uint64_t diskBytes = 1ull << 30;  // 磁盘层容量
+};
+
+struct DecodeCacheStats {
+    uint64_t hits = 0;           // 内存层命中
+    uint64_t diskHits = 0;       // 内存未命中、磁盘层命中（随后放入内存层）
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;      // 从内存层淘汰的条目
+    uint64_t diskWrites = 0;     // 淘汰时写入磁盘层的条目
+    uint64_t diskEvictions = 0;  // 从磁盘层删除的文件
+    uint64_t memoryBytes = 0;    // 当前占用
+    uint64_t diskBytes = 0;
+    size_t memoryEntries = 0;
+    size_t diskEntries = 0;
+};
+
+// 解码结果缓存：内存层为按字节数限制容量的 LRU；启用磁盘层时，从内存淘汰的条目写成文件
+// （先写临时文件再改名），内存未命中时映射文件读取，磁盘层同样按 LRU 删除文件。
+// 所有方法可被多个线程并发调用：两层各有一把锁，锁内只做哈希表与链表操作，文件读写在锁外进行
+class DecodeCache {
+public:
+    explicit DecodeCache(const DecodeCacheOptions &options);
+
+    // 查找 key，未命中返回 nullptr
+    std::shared_ptr<const CachedImage> lookup(const DecodeCacheKey &key);
+    // 放入内存层（已存在时替换），超出容量时按最久未使用淘汰；比整个内存层还大的条目直接写入磁盘层
+    void insert(const DecodeCacheKey &key, std::shared_ptr<const CachedImage> image);
+
+    DecodeCacheStats stats() const;
+
+private:
+    struct Entry {
+        DecodeCacheKey key;
+        std::shared_ptr<const CachedImage> image;
+    };
+    struct DiskEntry {
+        std::string name;
+        uint64_t bytes;
+    };
+
+    std::string diskPath(const DecodeCacheKey &key) const;
+    void insertMemory(const DecodeCacheKey &key, std::shared_ptr<const CachedImage> image, std::vector<Entry> &evicted);
+    void spillToDisk(const Entry &entry);
+    void touchDisk(const std::string &name, uint64_t bytes);
+
+    DecodeCacheOptions options;
+
+    mutable std::mutex memoryMutex;
+    std::list<Entry> memoryLru;  // 表头为最近使用
+    std::unordered_map<DecodeCacheKey, std::list<Entry>::iterator, DecodeCacheKeyHash> memoryIndex;
+    uint64_t memoryUsed = 0;
+
+    mutable std::mutex diskMutex;
+    std::list<DiskEntry> diskLru;
+    std::unordered_map<std::string, std::list<DiskEntry>::iterator> diskIndex;
+    uint64_t diskUsed = 0;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> diskHits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> insertions{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> diskWrites{0};
+    std::atomic<uint64_t> diskEvictions{0};
+};
+
+#endif // DECODE_CACHE_H
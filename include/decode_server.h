@@ -0,0 +1,139 @@
+#ifndef DECODE_SERVER_H
+#define DECODE_SERVER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+#include "decode_cache.h"
+
+// 常驻解码服务。每个连接上逐行发送请求，按顺序返回响应（字段以空格分隔，路径不能含空格）：
+//   decode <JPEG 路径> [选项...]
+//   decode - <字节数> [选项...]      请求行之后紧跟 JPEG 数据
+//   ping
+// 选项：crop=x,y,w,h  只解码矩形区域
+//       luma          只解码亮度，输出灰度
+//       scale=N       缩小为 1/N（1、2、4、8，尺寸向上取整），不能与 crop 同时使用
+//       format=rgb    像素为自上而下、紧密排列的 R,G,B（或灰度），默认
+//       format=bmp    像素为完整的 BMP 文件
+//       out=<路径>    把结果写成 BMP 文件，响应中返回路径而不是像素
+// JPEG 路径与 out= 路径都限定在服务的根目录（DecodeLimits::rootDirectory）之内：相对路径相对于根目录，
+// 规范化（解析 .. 与符号链接）后不在根目录下的路径被拒绝；没有配置根目录时只接受随请求发送的数据，不接受 out=。
+// 服务启用缓存时，内容与选项相同的请求直接返回缓存的像素（out= 时写出缓存的 BMP）。
+// 响应：
+//   ok <宽> <高> <通道数> <字节数>\n 后接像素数据
+//   ok <宽> <高> <通道数> <路径>\n   （out=）
+//   ok\n                              （ping）
+//   error <原因>\n
+// 随请求发送的数据超过 maxInputBytes 时回复 error 并关闭连接；图像像素数超过 maxPixels，
+// 或 SOF 尺寸与扫描数据长度不符时在分配系数之前拒绝；分配失败回复 error out of memory。
+struct DecodeRequest {
+    std::string path;            // 为空表示 JPEG 数据随请求发送
+    size_t inlineSize = 0;
+    bool crop = false;
+    int cropX = 0, cropY = 0, cropWidth = 0, cropHeight = 0;
+    bool lumaOnly = false;
+    int scale = 1;
+    bool bmpFormat = false;
+    std::string outputPath;
+};
+
+// 解析一行请求（不含换行），失败时返回 false 并在 error 中给出原因
+bool parseDecodeRequest(const std::string &line, DecodeRequest &request, std::string &error);
+
+// 单个请求的资源上限与可访问的目录
+struct DecodeLimits {
+    size_t maxInputBytes = size_t(256) << 20;   // JPEG 数据（随请求发送或读入的文件）的字节数
+    uint64_t maxPixels = DEFAULT_MAX_PIXELS;    // 原图的像素数
+    std::string rootDirectory;                  // 请求中的路径限定在此目录内，为空时不接受路径
+};
+
+// 把请求中的路径解析为根目录内的规范路径；root 为空或路径不在 root 之内时返回 false 并给出原因
+bool resolveServerPath(const std::string &root, const std::string &path, std::string &resolved, std::string &error);
+
+// 请求选项的规范形式，用作缓存键的一部分：crop、scale、luma 与响应格式（out= 按 BMP 计），不含输出路径
+std::string decodeCacheOptions(const DecodeRequest &request);
+
+// 每个工作线程常驻的缓冲区：输入、系数块与像素在请求之间复用，避免重复分配与缺页
+struct DecodeWorkerBuffers {
+    std::vector<uint8_t> input;
+    ImageData coefficients;     // 只借用其中的系数块存储
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> response;
+};
+
+// 带缓冲的文件描述符读取：请求行（或响应行）与随后的数据共用一个缓冲区
+class FdReader {
+public:
+    explicit FdReader(int fd) : fd(fd) {}
+    bool readLine(std::string &line);              // 读取一行（去掉换行符），对端关闭时返回 false
+    bool readBytes(uint8_t *out, size_t size);
+    bool hasBufferedData() const { return pos < end; }  // 已读入缓冲区、尚未处理的数据（如流水线发送的下一个请求）
+
+private:
+    bool fill();
+    int fd;
+    char buffer[65536];
+    size_t pos = 0;
+    size_t end = 0;
+};
+
+// 解码 buffers.input 中的 JPEG（path 非空时先读入文件），得到响应数据：紧密排列的像素，
+// 或 format=bmp / out= 时的完整 BMP 文件。cache 非空时先按内容与选项查找，未命中时解码后放入缓存。
+// 失败返回 nullptr 并在 error 中给出原因
+std::shared_ptr<const CachedImage> decodeRequestImage(const DecodeRequest &request, DecodeWorkerBuffers &buffers,
+                                                      DecodeCache *cache, std::string &error,
+                                                      const DecodeLimits &limits = DecodeLimits());
+
+// 读取并处理一个请求（跳过空行），写出响应；对端关闭、读写出错或无法继续使用连接时返回 false
+bool serveDecodeRequest(FdReader &reader, int outFd, DecodeWorkerBuffers &buffers, DecodeCache *cache = nullptr,
+                        const DecodeLimits &limits = DecodeLimits());
+
+// 处理一个连接上的全部请求，直到对端关闭；inFd 与 outFd 可以相同（套接字）或为标准输入/输出
+void serveDecodeConnection(int inFd, int outFd, DecodeWorkerBuffers &buffers, DecodeCache *cache = nullptr,
+                           const DecodeLimits &limits = DecodeLimits());
+
+struct ServerConnection;
+
+// Unix 域套接字服务：主线程用 poll 接受连接并等待空闲连接上的下一个请求，连接可读时交给
+// threadCount 个常驻工作线程之一处理一个请求，随后连接回到主线程。工作线程按请求而不是按连接分配，
+// 长期保持连接的客户端不会占住工作线程；请求读到一半或响应写不出去超过 IO_TIMEOUT_SECONDS 时断开该连接
+class DecodeServer {
+public:
+    static constexpr int IO_TIMEOUT_SECONDS = 30;
+
+    ~DecodeServer();
+    // 绑定并监听 socketPath（已存在的套接字文件会被替换，新文件权限为 0600，只有服务用户能连接），失败返回 false
+    bool listen(const std::string &socketPath);
+    // 接受连接直到 stop 被调用；cache 非空时所有工作线程共用
+    void run(int threadCount, DecodeCache *cache = nullptr, const DecodeLimits &limits = DecodeLimits());
+    // 可在其他线程中调用：停止接受连接与请求，正在处理的请求完成后关闭所有连接，run 返回
+    void stop();
+
+private:
+    void finishRequest(ServerConnection *connection, bool keepOpen);
+
+    std::string path;
+    int listenFd = -1;
+    int wakeFds[2] = {-1, -1};  // 工作线程交还连接或 stop 时写入一个字节，唤醒 poll
+    std::atomic<bool> stopping{false};
+    std::mutex mutex;
+    std::condition_variable connectionReady;
+    std::deque<ServerConnection *> ready;        // 有请求待处理的连接
+    std::vector<ServerConnection *> returned;    // 处理完一个请求、等待主线程重新 poll 的连接
+};
+
+// 客户端：连接服务，失败返回 -1
+int connectDecodeServer(const std::string &socketPath);
+
+// 发送一个请求（inlineData 非空时随后发送 JPEG 数据）并读取响应行与像素；连接出错返回 false
+bool sendDecodeRequest(int fd, FdReader &reader, const std::string &requestLine, const std::vector<uint8_t> *inlineData,
+                       std::string &statusLine, std::vector<uint8_t> &payload);
+
+#endif // DECODE_SERVER_H
@@ -0,0 +1,60 @@
+#ifndef DECODE_TRACE_H
+#define DECODE_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// 解码时间线追踪，输出 Chrome trace-event JSON（chrome://tracing 或 Perfetto 可直接打开）。
+// 每个线程把事件追加到自己的缓冲区，记录时只取该缓冲区自己的锁（只与开始 / 导出竞争），
+// 每个线程最多保留约 26 万个事件；关闭时每个埋点只多一次 relaxed 原子读。
+
+namespace decode_trace {
+extern std::atomic<bool> enabled;
+
+inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 追加一个完整事件到调用线程的缓冲区；name 必须是字符串字面量等静态字符串，arg < 0 表示没有参数
+void record(const char *name, int arg, uint64_t beginNs, uint64_t endNs);
+} // namespace decode_trace
+
+// 清空之前的事件并开始记录
+void startDecodeTrace();
+// 停止记录，已记录的事件保留到下一次 startDecodeTrace
+void stopDecodeTrace();
+
+// 为调用线程命名（显示在时间线的线程标题上），追踪关闭时也可调用：只保存名字，不分配事件缓冲区
+void setTraceThreadName(const std::string &name);
+
+// 写出所有线程的事件，可在其他线程仍在记录时调用；因超出上限丢弃的事件数写在 otherData.droppedEvents 中
+void writeDecodeTrace(std::ostream &out);
+bool writeDecodeTrace(const std::string &filename);
+
+// 已记录的事件数（所有线程）
+size_t decodeTraceEventCount();
+
+// 作用域内的一段工作，析构时记录开始与结束时间；arg 显示在事件的 args 中（如 MCU 行号）
+class TraceScope {
+public:
+    explicit TraceScope(const char *name, int arg = -1)
+        : name(name), arg(arg), beginNs(decode_trace::isEnabled() ? decode_trace::nowNs() : 0) {}
+    ~TraceScope() {
+        if (beginNs) decode_trace::record(name, arg, beginNs, decode_trace::nowNs());
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+    int arg;
+    uint64_t beginNs;
+};
+
+#endif // DECODE_TRACE_H
@@ -5,10 +5,59 @@
 #include <cstdint>
 #include "jpeg_header_parser.h"  // 确保包含了 ImageData 结构定义
 
+// 熵解码结果：出错时返回错误码而不是退出进程，便于在多线程服务中使用
+enum class DecodeStatus {
+    Ok,            // 解码成功
+    Truncated,     // 比特流提前结束
+    InvalidCode,   // 遇到无效的哈夫曼码
+    MissingTable,  // 缺少所需的哈夫曼表
+    PrematureMarker, // 扫描数据在所有 MCU 解码完之前遇到了其他标记
+    InvalidHeader, // 文件头无法解析
+    UnsupportedSampling, // 合法但不支持的采样方式（只支持灰度与 4:2:0），不代表数据损坏
+};
+
+// 返回错误码的文字描述
+const char *decodeStatusMessage(DecodeStatus status);
+
+// getHuffmanSymbol 的错误返回值
+constexpr int HUFFMAN_TRUNCATED = -1;
+constexpr int HUFFMAN_INVALID_CODE = -2;
+
+// 哈夫曼符号的解码方式，三者结果完全相同
+enum class HuffmanDecodeMode {
+    BitSerial,     // 逐位累积码字并查 huffmanCodesByLength
+    SingleSymbol,  // 预读 HUFFMAN_LOOKUP_BITS 位查表，每次得到一个符号
+    MultiSymbol,   // AC 短码一次查表得到最多两个“零游程 + 系数”，连同幅值位一起跳过
+};
+
+const char *huffmanDecodeModeName(HuffmanDecodeMode mode);
+
+// 熵解码器状态：比特流读取位置、各分量的哈夫曼表与 DC 预测值，可按 MCU 逐步推进
+struct HuffmanDecodeState {
+    BitStreamReader reader;
+    const HuffmanTable *dcTables[3] = {nullptr, nullptr, nullptr};
+    const HuffmanTable *acTables[3] = {nullptr, nullptr, nullptr};
+    int previousDc[3] = {0, 0, 0};
+    HuffmanDecodeMode mode = HuffmanDecodeMode::MultiSymbol;
+
+    explicit HuffmanDecodeState(const std::vector<uint8_t> &data) : reader(data) {}
+};
+
 // 解码函数
-int getHuffmanSymbol(BitStreamReader &reader, const HuffmanTable &table);
-int decodeHuffmanDC(BitStreamReader &reader, const HuffmanTable &dcTable);
-void decodeHuffmanAC(BitStreamReader &reader, const HuffmanTable &acTable, int *block);
-void huffmanDecode(const std::vector<uint8_t> &compressedData, ImageData &imgData);
+int getHuffmanSymbol(BitStreamReader &reader, const HuffmanTable &table,
+                     HuffmanDecodeMode mode = HuffmanDecodeMode::SingleSymbol);
+DecodeStatus decodeHuffmanDC(BitStreamReader &reader, const HuffmanTable &dcTable, int &dcDiff,
+                             HuffmanDecodeMode mode = HuffmanDecodeMode::MultiSymbol);
+DecodeStatus decodeHuffmanAC(BitStreamReader &reader, const HuffmanTable &acTable, Coefficient *block,
+                             HuffmanDecodeMode mode = HuffmanDecodeMode::MultiSymbol);
+DecodeStatus initHuffmanDecodeState(HuffmanDecodeState &state, const ImageData &imgData);
+DecodeStatus decodeMcu(HuffmanDecodeState &state, ImageData &imgData, int mcu);
+// 解码第 mcu 个 MCU 到调用方提供的块：彩色为 4 个 Y 块、Cb、Cr，灰度只用 blocks[0]；
+// 为 nullptr 的块只做熵解码、不保存。块需预先清零（AC 只写入非零系数）
+DecodeStatus decodeMcuBlocks(HuffmanDecodeState &state, const ImageData &imgData, int mcu,
+                             Coefficient *const blocks[6]);
+DecodeStatus decodeMcuRow(HuffmanDecodeState &state, ImageData &imgData, int mcuRow);
+DecodeStatus huffmanDecode(const std::vector<uint8_t> &compressedData, ImageData &imgData,
+                           HuffmanDecodeMode mode = HuffmanDecodeMode::MultiSymbol);
 
 #endif // HUFFMAN_DECODER_H
@@ -0,0 +1,33 @@
+#ifndef HUFFMAN_OPTIMIZER_H
+#define HUFFMAN_OPTIMIZER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "huffman_decoder.h"
+#include "jpeg_encoder.h"
+
+// 单张表的符号频次；下标 0..255 为符号
+struct HuffmanStatistics {
+    long counts[256] = {};
+};
+
+// 统计一个 Zig-Zag 顺序的量化块在重新编码时会产生的 DC / AC 符号（与 encodeBlock 对应）
+void countBlockSymbols(const Coefficient *block, int &previousDc, HuffmanStatistics &dcStats, HuffmanStatistics &acStats);
+
+// 按频次生成最优哈夫曼表，码长不超过 16 位且不使用全 1 码字（JPEG 标准 K.2）
+void buildOptimalHuffmanTable(const HuffmanStatistics &stats, int tableClass, int tableId, HuffmanEncodeTable &table);
+
+// 无损重新优化哈夫曼表的结果
+struct OptimizeReport {
+    DecodeStatus status = DecodeStatus::Ok;
+    size_t inputBytes = 0;
+    size_t outputBytes = 0;
+};
+
+// 两遍处理：第一遍熵解码统计符号频次，第二遍再次熵解码并用最优表重新编码。
+// 每次只保留一个 MCU 的系数，量化系数、量化表和其他标记段（APPn、DQT、DRI 等）原样保留，
+// 只替换 DHT 与扫描数据。
+OptimizeReport optimizeJPEG(const std::string &inputFile, std::vector<uint8_t> &output);
+
+#endif // HUFFMAN_OPTIMIZER_H
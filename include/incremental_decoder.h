@@ -0,0 +1,68 @@
+#ifndef INCREMENTAL_DECODER_H
+#define INCREMENTAL_DECODER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+
+enum class DecodeEventType {
+    HeaderParsed,  // SOS 之前的标记段已解析，image() 的尺寸与表可用
+    RowsReady,     // MCU 行 [mcuRowBegin, mcuRowEnd) 的像素已写入 pixelData()
+    Done,          // 解码结束，status 为最终结果
+};
+
+struct DecodeEvent {
+    DecodeEventType type = DecodeEventType::HeaderParsed;
+    int mcuRowBegin = 0;
+    int mcuRowEnd = 0;
+    DecodeStatus status = DecodeStatus::Ok;
+};
+
+using DecodeEventCallback = std::function<void(const DecodeEvent &)>;
+
+// 推送式增量解码：数据分段到达时逐段 feed，不需要先缓存整个文件。
+// 标记段凑齐一整段才解析；扫描数据去掉填充字节后追加到 compressedData，
+// 每次尽量多解码 MCU，某个 MCU 的数据不够时退回到它开始的比特位置与 DC 预测值，
+// 等下一段数据到达后重新解码（与 libjpeg 挂起式数据源相同的做法）
+class IncrementalDecoder {
+public:
+    explicit IncrementalDecoder(DecodeEventCallback onEvent);
+    IncrementalDecoder(const IncrementalDecoder &) = delete;
+    IncrementalDecoder &operator=(const IncrementalDecoder &) = delete;
+
+    // 送入下一段数据；返回 Ok 表示尚未出错，解码结束后返回最终结果并忽略后续数据
+    DecodeStatus feed(const uint8_t *data, size_t size);
+    // 数据已全部送入：还没解码完的图像以 Truncated（或 InvalidHeader）结束
+    DecodeStatus finish();
+
+    bool done() const { return finished; }
+    const ImageData &image() const { return imgData; }
+    // 像素布局同 fillBMPRows，只有已交付的 MCU 行有效
+    const std::vector<uint8_t> &pixelData() const { return pixels; }
+    int mcuRowsReady() const { return rowsReady; }
+
+private:
+    size_t feedHeader(const uint8_t *data, size_t size);
+    size_t feedScan(const uint8_t *data, size_t size);
+    void decodeAvailable();
+    void complete(DecodeStatus status);
+
+    DecodeEventCallback onEvent;
+    ImageData imgData;
+    HuffmanDecodeState state;          // reader 引用 imgData.compressedData，追加数据后继续读取
+    std::vector<uint8_t> header;       // SOI 到 SOS 段结束的原始字节
+    size_t headerPos = 0;              // header 中下一个待检查的标记段位置
+    bool headerParsed = false;
+    bool pendingFF = false;            // 上一段以 0xFF 结尾，要看下一字节才能确定含义
+    bool scanEnded = false;            // 扫描数据后已遇到 EOI 或其他标记
+    bool finished = false;
+    DecodeStatus result = DecodeStatus::Ok;
+    int nextMcu = 0;
+    int rowsReady = 0;
+    std::vector<uint8_t> pixels;
+};
+
+#endif // INCREMENTAL_DECODER_H
@@ -6,4 +6,7 @@
 // 对 Y 分量执行逆 DCT 操作
 void inverseDCT(ImageData &imgData);
 
+// 只处理 MCU 行 [mcuRowBegin, mcuRowEnd)
+void inverseDCT(ImageData &imgData, int mcuRowBegin, int mcuRowEnd);
+
 #endif // INVERSE_DCT_H
@@ -3,7 +3,28 @@
 
 #include "jpeg_header_parser.h"
 
+// 逆量化的实现：Auto 在运行时选择当前 CPU 支持的最快实现
+enum class DequantizeKernel {
+    Auto,
+    Scalar,
+    Sse2,   // 每条指令 8 个系数
+    Avx2,   // 每条指令 16 个系数
+};
+
+const char *dequantizeKernelName(DequantizeKernel kernel);
+bool dequantizeKernelSupported(DequantizeKernel kernel);
+
+// 把量化表转换为 16 位（16 位精度的 DQT 表项饱和到 32767，乘积本来就会饱和，结果不变）
+void makeDequantizeTable(const std::vector<int> &quantTable, Coefficient table[64]);
+
+// 一个块的 64 个系数逐个乘以量化表，乘积饱和到 int16
+void dequantizeBlock(Coefficient *block, const Coefficient *table, DequantizeKernel kernel = DequantizeKernel::Auto);
+
 // 对 Y 分量执行逆量化操作
 void inverseQuantize(ImageData &imgData);
 
+// 只处理 MCU 行 [mcuRowBegin, mcuRowEnd)
+void inverseQuantize(ImageData &imgData, int mcuRowBegin, int mcuRowEnd,
+                     DequantizeKernel kernel = DequantizeKernel::Auto);
+
 #endif // INVERSE_QUANTIZE_H
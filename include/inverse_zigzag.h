@@ -2,4 +2,6 @@
 #define INVERSE_ZIGZAG_H
 #include "jpeg_header_parser.h"
 void inverseZigZag(ImageData &imgData);
-#endif
\ No newline at end of file
+// 只处理 MCU 行 [mcuRowBegin, mcuRowEnd)
+void inverseZigZag(ImageData &imgData, int mcuRowBegin, int mcuRowEnd);
+#endif
@@ -4,7 +4,13 @@
 #include <vector>
 #include <cstdint>
 #include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
 
-void decodeJPEG(ImageData &imgData, const std::vector<uint8_t> &compressedData);
+// 解码整幅图像；所有状态都保存在 imgData 中，不同图像可在不同线程中并发解码
+DecodeStatus decodeJPEG(ImageData &imgData, const std::vector<uint8_t> &compressedData);
+
+// 由 huffmanDecode 得到的量化系数重建像素块（逆量化、逆 Zig-Zag、逆 DCT），
+// 可在两者之间插入 DCT 域处理（如 transformCoefficients）
+void reconstructImage(ImageData &imgData);
 
 #endif // JPEG_DECODER_H
@@ -0,0 +1,97 @@
+#ifndef JPEG_ENCODER_H
+#define JPEG_ENCODER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "jpeg_header_parser.h"
+
+// 色度采样方式（单通道输入总是编码为灰度）
+enum class ChromaSubsampling {
+    Yuv420,  // 16x16 MCU：4 个 Y 块 + Cb + Cr
+    Yuv444,  // 8x8 MCU：Y + Cb + Cr
+};
+
+struct EncodeOptions {
+    int quality = 75;                                     // 1..100，按 IJG 公式缩放标准量化表
+    ChromaSubsampling subsampling = ChromaSubsampling::Yuv420;
+    int restartInterval = 0;                              // 每隔多少个 MCU 插入 RSTn，0 表示不插入
+    int threadCount = 1;                                  // 有重启间隔时，各间隔可并行编码
+};
+
+// 编码器输入：自上而下、紧密排列的像素，channels 为 1（灰度）或 3（R,G,B）
+struct RawImage {
+    int width = 0;
+    int height = 0;
+    int channels = 3;
+    std::vector<uint8_t> pixels;
+};
+
+// 编码用哈夫曼表：spec 为 DHT 中的码长计数与符号，code/size 由 spec 生成
+struct HuffmanEncodeTable {
+    HuffmanTable spec;
+    uint16_t code[256] = {};
+    uint8_t size[256] = {};
+};
+
+// 按码长计数与符号生成规范哈夫曼码
+void buildHuffmanEncodeTable(const std::vector<int> &lengths, const std::vector<int> &symbols, int tableClass,
+                             int tableId, HuffmanEncodeTable &table);
+
+// 标准哈夫曼表（JPEG 标准附录 K.3）：0 为亮度，1 为色度
+const HuffmanEncodeTable &standardDcTable(int tableId);
+const HuffmanEncodeTable &standardAcTable(int tableId);
+
+// 按 IJG 质量公式缩放的标准量化表，Zig-Zag 顺序
+std::vector<int> scaledQuantTable(int tableId, int quality);
+
+// 按字缓冲的比特写入器：64 位累加器，每满 32 位写出一次，0xFF 后补 0x00
+class JpegBitWriter {
+public:
+    explicit JpegBitWriter(std::vector<uint8_t> &out) : out(out) {}
+    void putBits(uint32_t bits, int count) {
+        buffer = (buffer << count) | bits;
+        bitCount += count;
+        if (bitCount >= 32) emitWord();
+    }
+    // 用 1 填充到整字节并写出剩余比特（重启标记前或扫描结束时调用）
+    void flush();
+
+private:
+    void emitWord();
+    std::vector<uint8_t> &out;
+    uint64_t buffer = 0;
+    int bitCount = 0;
+};
+
+// 熵编码一个 Zig-Zag 顺序的量化块，previousDc 为该分量的 DC 预测值
+void encodeBlock(JpegBitWriter &writer, const Coefficient *block, int &previousDc,
+                 const HuffmanEncodeTable &dcTable, const HuffmanEncodeTable &acTable);
+
+// 写出一个只含一张表的 DHT 段（兼容只读取单表 DHT 段的解析器）
+void writeHuffmanTable(std::vector<uint8_t> &out, const HuffmanEncodeTable &table);
+
+// 写出 SOI、APP0、DQT、SOF0、DHT、DRI 与 SOS 段；components 为 1 或 3，
+// quantTables[0/1] 为亮度/色度量化表，dcTables/acTables 同理
+void writeJPEGHeaders(std::vector<uint8_t> &out, int width, int height, int components, ChromaSubsampling subsampling,
+                      const std::vector<int> *quantTables[2], const HuffmanEncodeTable *dcTables[2],
+                      const HuffmanEncodeTable *acTables[2], int restartInterval);
+
+// 编码一幅图像为基线 JPEG，失败（尺寸或通道数无效）返回 false
+bool encodeJPEG(const RawImage &image, const EncodeOptions &options, std::vector<uint8_t> &out);
+
+// 将 fillBMPRows 生成的 BMP 像素（自下而上、B,G,R、4 字节行对齐）转换为编码器输入
+RawImage rawImageFromBMPRows(const std::vector<uint8_t> &pixelData, int width, int height, int channels);
+
+// 反向转换：自上而下的 R,G,B（或灰度）转为 fillBMPRows 布局，可直接交给 writeBMP
+void bmpRowsFromRawImage(const RawImage &image, std::vector<uint8_t> &pixelData);
+
+// 读取 24 位或 8 位灰度（调色板）BMP
+bool loadBMP(const std::string &filename, RawImage &image);
+
+// 读取紧密排列的 RGB（channels 为 3）或灰度原始像素
+bool loadRawImage(const std::string &filename, int width, int height, int channels, RawImage &image);
+
+bool saveAsJPEG(const std::string &filename, const RawImage &image, const EncodeOptions &options);
+
+#endif // JPEG_ENCODER_H
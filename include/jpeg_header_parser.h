@@ -15,15 +15,45 @@ constexpr uint8_t SOS = 0xDA;   // Start of Scan
 constexpr uint8_t EOI = 0xD9;   // End of Image
 constexpr uint8_t DRI = 0xDD;
 
+// 解码前允许的默认最大像素数（1 亿），防止损坏或恶意的 SOF 尺寸导致巨量分配
+constexpr uint64_t DEFAULT_MAX_PIXELS = 100000000;
+
+// 系数以 16 位存储：8 位基线 JPEG 的量化系数、逆量化后的系数与逆 DCT 结果都在 int16 范围内，
+// 损坏数据产生的越界值在写入时饱和
+using Coefficient = int16_t;
+
+inline Coefficient saturateCoefficient(int value) {
+    return static_cast<Coefficient>(value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+}
+
 // Huffman Table
 #include <unordered_map>
 
+// 查表解码每次预读的比特数：码长不超过它的码字一次查表即可得到
+constexpr int HUFFMAN_LOOKUP_BITS = 10;
+
+// 多符号查表项：预读的 HUFFMAN_LOOKUP_BITS 位中完整包含的前一到两个“码字 + 幅值位”，
+// 每项为零游程加一个系数（DC 表为差分值），或 EOB
+struct HuffmanFastEntry {
+    int16_t value[2] = {0, 0};
+    uint8_t run[2] = {0, 0};
+    uint8_t bits[2] = {0, 0};   // 消耗到第 1 项、第 2 项结束为止的比特数
+    uint8_t items = 0;          // 0 表示码字或幅值超出预读范围，需逐符号解码
+    bool endOfBlock = false;    // 最后一项是 EOB
+};
+
+struct HuffmanTable;
+// 由 huffmanCodesByLength 构建单符号与多符号查找表（实现在 huffman_decoder.cpp）
+void buildHuffmanLookup(HuffmanTable &table);
+
 struct HuffmanTable {
     int tableClass;                // 0 表示 DC 表，1 表示 AC 表
     int tableId;                   // 表 ID
     std::vector<int> lengths;      // 符号长度数组（每个长度对应的符号数量）
     std::vector<int> symbols;      // 符号数组
     std::unordered_map<int, std::unordered_map<int, int>> huffmanCodesByLength;  // 按长度存储的哈夫曼码表
+    std::vector<uint16_t> lookup;                // 以预读位为下标：(符号 << 8) | 码长，0 表示需逐位解码
+    std::vector<HuffmanFastEntry> fastEntries;   // 以预读位为下标的多符号表
 
     void buildHuffmanCodes() {
         int code = 0;
@@ -47,6 +77,7 @@ struct HuffmanTable {
                 }
             }
         }
+        buildHuffmanLookup(*this);
     }
 };
 
@@ -58,24 +89,30 @@ struct ImageData {
     int colorComponents = 0;
     int yQuantTableId = 0;
     int crCbQuantTableId = 1;
+    std::vector<int> hSamplingFactors;  // 各分量的水平采样因子（SOF0 中的顺序）
+    std::vector<int> vSamplingFactors;  // 各分量的垂直采样因子
     std::map<int, std::vector<int>> quantizationTables;  // 量化表
     std::vector<HuffmanTable> huffmanTables;           // 哈夫曼表
 
     // 颜色分量：Y、Cr 和 Cb 的系数块（每个块包含 64 个系数）
-    std::vector<std::vector<int>> Y;   // Y 分量
-    std::vector<std::vector<int>> Cr;  // Cr 分量
-    std::vector<std::vector<int>> Cb;  // Cb 分量
+    std::vector<std::vector<Coefficient>> Y;   // Y 分量
+    std::vector<std::vector<Coefficient>> Cr;  // Cr 分量
+    std::vector<std::vector<Coefficient>> Cb;  // Cb 分量
 
     // 新增的二维向量，用于存储8x8块格式
-    std::vector<std::vector<std::vector<int>>> Y_blocks_2D;   // Y 分量的二维 8x8 块
-    std::vector<std::vector<std::vector<int>>> Cr_blocks_2D;  // Cr 分量的二维 8x8 块
-    std::vector<std::vector<std::vector<int>>> Cb_blocks_2D;  // Cb 分量的二维 8x8 块
+    std::vector<std::vector<std::vector<Coefficient>>> Y_blocks_2D;   // Y 分量的二维 8x8 块
+    std::vector<std::vector<std::vector<Coefficient>>> Cr_blocks_2D;  // Cr 分量的二维 8x8 块
+    std::vector<std::vector<std::vector<Coefficient>>> Cb_blocks_2D;  // Cb 分量的二维 8x8 块
 
     int totalBlocks = 0;         // MCU 的总数量
     int totalYBlocks = 0;        // Y 分量块总数
     int totalCrCbBlocks = 0;     // Cr 和 Cb 分量块总数
 
+    bool lumaOnly = false;       // 仅解码亮度：色度系数只做熵解码跳过，不存储、不做 IDCT
+
     std::vector<uint8_t> compressedData;  // 用于存储比特流数据
+    int scanEndMarker = 0;                // 结束扫描数据的标记：EOI 为正常结束，0 表示文件在 EOI 前截断
+    int restartInterval = 0;              // DRI 重启间隔（MCU 数），0 表示没有 RSTn 标记
 
     // 哈夫曼表 ID：每个分量使用的 DC 和 AC 哈夫曼表
     std::vector<int> dcTableIds = {0, 1, 1};  // 默认: Y 用表 0，Cr 和 Cb 用表 1
@@ -98,28 +135,103 @@ struct ImageData {
         }
     }
 
-    // 初始化方法：根据图像宽度和高度自动计算 MCU 总数并设置块数量
-    void initializeBlocks(int imageWidth, int imageHeight) {
+    // 单分量（灰度）图像只有 Y，没有色度
+    bool isGrayscale() const {
+        return colorComponents == 1;
+    }
+
+    // 是否需要存储并重建色度分量
+    bool hasChroma() const {
+        return !isGrayscale() && !lumaOnly;
+    }
+
+    // 第 block 个 Y 块左上角在图像中的像素坐标
+    void yBlockPosition(int block, int &row, int &col) const {
+        if (isGrayscale()) {
+            row = (block / mcuWidth) * 8;
+            col = (block % mcuWidth) * 8;
+        } else {
+            int mcu = block / 4;
+            int sub = block % 4;  // 0 左上，1 右上，2 左下，3 右下
+            row = (mcu / mcuWidth) * 16 + (sub / 2) * 8;
+            col = (mcu % mcuWidth) * 16 + (sub % 2) * 8;
+        }
+    }
+
+    // MCU 行 [mcuRowBegin, mcuRowEnd) 对应的 Y 块与已存储色度块的下标范围 [begin, end)
+    void mcuRowBlockRange(int mcuRowBegin, int mcuRowEnd, int &yBegin, int &yEnd, int &crCbBegin, int &crCbEnd) const {
+        int yBlocksPerMcu = isGrayscale() ? 1 : 4;
+        yBegin = mcuRowBegin * mcuWidth * yBlocksPerMcu;
+        yEnd = mcuRowEnd * mcuWidth * yBlocksPerMcu;
+        crCbBegin = hasChroma() ? mcuRowBegin * mcuWidth : 0;
+        crCbEnd = hasChroma() ? mcuRowEnd * mcuWidth : 0;
+    }
+
+    // 解码器支持的采样方式：灰度，或 Y 为 2x2、Cb/Cr 为 1x1 的 4:2:0 彩色
+    bool hasSupportedSampling() const {
+        if (isGrayscale()) return true;
+        return hSamplingFactors.size() == 3 && vSamplingFactors.size() == 3 && hSamplingFactors[0] == 2 &&
+               vSamplingFactors[0] == 2 && hSamplingFactors[1] == 1 && vSamplingFactors[1] == 1 &&
+               hSamplingFactors[2] == 1 && vSamplingFactors[2] == 1;
+    }
+
+    // 各分量引用的量化表都已定义
+    bool hasRequiredQuantTables() const {
+        return quantizationTables.count(yQuantTableId) &&
+               (isGrayscale() || quantizationTables.count(crCbQuantTableId));
+    }
+
+    // SOF 尺寸是否可信：像素数不超过 maxPixels，且熵编码数据至少能容纳全部块
+    // （每块至少 2 比特，即 DC 与 EOB 各一个最短码字）。应在 initializeBlocks 分配之前检查
+    bool hasPlausibleSize(uint64_t maxPixels) const {
+        uint64_t size = static_cast<uint64_t>(mcuSize());
+        uint64_t mcus = (width + size - 1) / size * ((height + size - 1) / size);
+        uint64_t blocks = mcus * (isGrayscale() ? 1 : 6);
+        return static_cast<uint64_t>(width) * height <= maxPixels && blocks * 2 <= compressedData.size() * 8;
+    }
+
+    // 每个 MCU 覆盖的像素边长：灰度为 8，4:2:0 彩色为 16
+    int mcuSize() const {
+        return isGrayscale() ? 8 : 16;
+    }
+
+    // 根据图像宽度和高度计算 MCU 网格与各分量块数，不分配系数存储
+    void initializeMcuLayout(int imageWidth, int imageHeight) {
         this->width = imageWidth;
         this->height = imageHeight;
 
-        // 每个 MCU 覆盖 16x16 像素，计算 MCU 的数量
-        mcuWidth = (width + 15) / 16;   // 向上取整，保证覆盖整个宽度
-        mcuHeight = (height + 15) / 16; // 向上取整，保证覆盖整个高度
+        // 计算 MCU 的数量（彩色 16x16，灰度 8x8）
+        int size = mcuSize();
+        mcuWidth = (width + size - 1) / size;   // 向上取整，保证覆盖整个宽度
+        mcuHeight = (height + size - 1) / size; // 向上取整，保证覆盖整个高度
         totalBlocks = mcuWidth * mcuHeight; // MCU 总数量
 
-        totalYBlocks = totalBlocks * 4;          // 每个 MCU 包含 4 个 Y 块
-        totalCrCbBlocks = totalBlocks;           // 每个 MCU 包含 1 个 Cr 和 1 个 Cb 块
+        if (isGrayscale()) {
+            totalYBlocks = totalBlocks;          // 灰度：每个 MCU 只有 1 个 Y 块
+            totalCrCbBlocks = 0;                 // 没有色度块
+        } else {
+            totalYBlocks = totalBlocks * 4;      // 每个 MCU 包含 4 个 Y 块
+            totalCrCbBlocks = totalBlocks;       // 每个 MCU 包含 1 个 Cr 和 1 个 Cb 块
+        }
+    }
+
+    // 初始化方法：根据图像宽度和高度自动计算 MCU 总数并设置块数量
+    void initializeBlocks(int imageWidth, int imageHeight) {
+        initializeMcuLayout(imageWidth, imageHeight);
+
+        // 仅解码亮度时不为色度分配存储
+        int storedCrCbBlocks = hasChroma() ? totalCrCbBlocks : 0;
 
         // 初始化 Y、Cr、Cb 一维数据存储结构
-        Y.resize(totalYBlocks, std::vector<int>(64, 0));     // 每个 Y 块包含 64 个系数
-        Cr.resize(totalCrCbBlocks, std::vector<int>(64, 0)); // 每个 Cr 块包含 64 个系数
-        Cb.resize(totalCrCbBlocks, std::vector<int>(64, 0)); // 每个 Cb 块包含 64 个系数
+        Y.resize(totalYBlocks, std::vector<Coefficient>(64, 0));     // 每个 Y 块包含 64 个系数
+        Cr.resize(storedCrCbBlocks, std::vector<Coefficient>(64, 0)); // 每个 Cr 块包含 64 个系数
+        Cb.resize(storedCrCbBlocks, std::vector<Coefficient>(64, 0)); // 每个 Cb 块包含 64 个系数
 
         // 初始化 Y、Cr、Cb 的二维 8x8 块结构
-        Y_blocks_2D.resize(totalYBlocks, std::vector<std::vector<int>>(8, std::vector<int>(8, 0)));
-        Cr_blocks_2D.resize(totalCrCbBlocks, std::vector<std::vector<int>>(8, std::vector<int>(8, 0)));
-        Cb_blocks_2D.resize(totalCrCbBlocks, std::vector<std::vector<int>>(8, std::vector<int>(8, 0)));
+        const std::vector<std::vector<Coefficient>> emptyBlock(8, std::vector<Coefficient>(8, 0));
+        Y_blocks_2D.resize(totalYBlocks, emptyBlock);
+        Cr_blocks_2D.resize(storedCrCbBlocks, emptyBlock);
+        Cb_blocks_2D.resize(storedCrCbBlocks, emptyBlock);
     }
 
     // 设置哈夫曼表 ID，用于各分量的哈夫曼表编号
@@ -140,13 +252,45 @@ public:
     int readBits(int numBits);     // 读取指定数量的比特
     int readBit();                 // 读取一个比特
 
+    // 预读 numBits 位（不超过 24）但不前进，数据末尾之后补 0
+    uint32_t peekBits(int numBits) const {
+        uint32_t window = 0;
+        if (bytePos + 4 <= data.size()) {
+            const uint8_t *p = &data[bytePos];
+            window = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        } else {
+            for (size_t i = bytePos; i < bytePos + 4; ++i) {
+                window = (window << 8) | (i < data.size() ? data[i] : 0);
+            }
+        }
+        return (window << bitPos) >> (32 - numBits);
+    }
+    void skipBits(int numBits) {
+        bitPos += numBits;
+        bytePos += bitPos >> 3;
+        bitPos &= 7;
+    }
+    size_t bitsRemaining() const { return bytePos < data.size() ? (data.size() - bytePos) * 8 - bitPos : 0; }
+    void alignToByte();            // 丢弃当前字节剩余的填充位（RSTn 标记之前）
+    size_t bitOffset() const { return bytePos * 8 + bitPos; }  // 当前读取位置（比特）
+    void seekBit(size_t offset) {                                // 跳到指定比特位置继续读取
+        bytePos = offset / 8;
+        bitPos = static_cast<int>(offset % 8);
+    }
+
 private:
     const std::vector<uint8_t> &data; // 数据流引用
     size_t bytePos;                    // 当前字节位置
     int bitPos;                        // 当前字节中的比特位置
 };
 
-// 解析 JPEG 文件头
-ImageData parseJPEGHeader(const std::string &filename);
+// 解析 JPEG 文件头；verbose 为 false 时不向标准输出打印表内容
+ImageData parseJPEGHeader(const std::string &filename, bool verbose = true);
+
+// 从输入流解析一幅图像：SOI 之后的标记段与第一个扫描的数据
+ImageData parseJPEGStream(std::istream &file, bool verbose = true);
+
+// 解析内存中的一幅图像（如 MJPEG 流中的一帧），不复制输入
+ImageData parseJPEGMemory(const uint8_t *data, size_t size, bool verbose = false);
 
 #endif // JPEG_HEADER_PARSER_H
\ No newline at end of file
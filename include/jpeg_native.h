@@ -0,0 +1,54 @@
+#ifndef JPEG_NATIVE_H
+#define JPEG_NATIVE_H
+
+/* 供 Python（ctypes）等外部语言调用的 C 接口，编译为共享库 libjpeg_native。
+ * 典型用法：jpeg_native_open 解析内存中的 JPEG，jpeg_native_info 取得尺寸，调用方按尺寸分配缓冲区，
+ * jpeg_native_decode 把像素直接写入该缓冲区（不经过临时文件，也不在库内另存一份输出），最后 jpeg_native_close。
+ * 各函数都不持有全局锁，不同句柄可在不同线程中同时解码；同一句柄不能并发使用 */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 返回码：0 为成功，1~6 与 DecodeStatus 的错误一一对应 */
+enum {
+    JPEG_NATIVE_OK = 0,
+    JPEG_NATIVE_TRUNCATED = 1,
+    JPEG_NATIVE_INVALID_CODE = 2,
+    JPEG_NATIVE_MISSING_TABLE = 3,
+    JPEG_NATIVE_PREMATURE_MARKER = 4,
+    JPEG_NATIVE_INVALID_HEADER = 5,
+    JPEG_NATIVE_UNSUPPORTED_SAMPLING = 6, /* 合法但不支持的采样方式（只支持灰度与 4:2:0） */
+    JPEG_NATIVE_INVALID_ARGUMENT = 7,     /* 通道数不支持、行跨度或缓冲区太小 */
+    JPEG_NATIVE_OUT_OF_MEMORY = 8,
+    JPEG_NATIVE_TOO_LARGE = 9,            /* 像素数超过上限，或尺寸与熵编码数据的长度不符 */
+};
+
+typedef struct jpeg_native_image jpeg_native_image;
+
+/* 解析内存中的 JPEG 并复制熵编码数据，返回后 data 即可释放。失败时 *image 为 NULL。
+ * 像素数超过 max_pixels（0 表示默认的 1 亿），或 SOF 尺寸所需的块数放不进熵编码数据时返回
+ * JPEG_NATIVE_TOO_LARGE，调用方不会按损坏头部中的尺寸分配输出缓冲区 */
+int jpeg_native_open(const uint8_t *data, size_t size, uint64_t max_pixels, jpeg_native_image **image);
+
+/* 图像尺寸与原生通道数（灰度为 1，彩色为 3） */
+void jpeg_native_info(const jpeg_native_image *image, int *width, int *height, int *channels);
+
+/* 解码到调用方的缓冲区，自上而下、每行 stride 字节（不小于 width * channels），size 为缓冲区总字节数。
+ * channels：1 为亮度（彩色图像只解码亮度，色度系数只做熵解码跳过），3 为 R,G,B，4 为 R,G,B,255；
+ * 灰度图像输出 3 / 4 通道时 R = G = B。可以对同一句柄重复调用，系数块在返回前释放 */
+int jpeg_native_decode(jpeg_native_image *image, int channels, uint8_t *out, size_t stride, size_t size);
+
+void jpeg_native_close(jpeg_native_image *image);
+
+/* 返回码的文字描述（UTF-8 静态字符串） */
+const char *jpeg_native_status_message(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JPEG_NATIVE_H */
@@ -0,0 +1,35 @@
+#ifndef JPEG_PROBE_H
+#define JPEG_PROBE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 仅由标记段得到的图像元数据，不读取熵编码数据
+struct JpegProbeInfo {
+    int sofMarker = 0;               // SOF 标记（0xC0 基线，0xC1 扩展，0xC2 渐进）
+    int precision = 0;               // 采样精度
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    std::vector<int> componentIds;
+    std::vector<int> hSamplingFactors;
+    std::vector<int> vSamplingFactors;
+    std::vector<int> quantTableIds;
+    int restartInterval = 0;         // DRI 指定的重启间隔（MCU 数），0 表示无
+    uint64_t quantTableHash = 0;     // 所有 DQT 段内容的 FNV-1a 哈希
+    uint64_t huffmanTableHash = 0;   // 所有 DHT 段内容的 FNV-1a 哈希
+    int estimatedQuality = 0;        // 由亮度量化表估算的 IJG 质量因子（1~100）
+    int64_t scanOffset = 0;          // 熵编码数据在文件中的起始偏移（SOS 段之后）
+};
+
+// 只解析到 SOS 为止：DQT/DHT/SOF/DRI 段读入一个段长以内的缓冲区，其他段直接跳过
+// 成功时返回 true；不是 JPEG 或在 SOS 之前截断时返回 false
+bool probeJPEG(const std::string &filename, JpegProbeInfo &info);
+
+// 递归扫描目录中的 .jpg/.jpeg 文件，用 threadCount 个线程并行探测，
+// 每个文件输出一行 CSV 记录（顺序与目录遍历顺序一致），返回成功探测的文件数。
+// 无法读取的子目录在标准错误中报告后跳过，不影响其余部分
+int indexJPEGTree(const std::string &root, const std::string &csvFilename, int threadCount);
+
+#endif // JPEG_PROBE_H
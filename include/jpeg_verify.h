@@ -0,0 +1,23 @@
+#ifndef JPEG_VERIFY_H
+#define JPEG_VERIFY_H
+
+#include <string>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+
+// 完整性检查结果
+struct VerifyReport {
+    DecodeStatus status = DecodeStatus::Ok;
+    int failedMcu = -1;      // 出错的 MCU 序号，成功时为 -1
+    int totalMcus = 0;       // 图像的 MCU 总数
+    int endMarker = 0;       // 结束扫描数据的标记（EOI 或提前出现的标记），0 表示文件截断
+};
+
+// 只遍历熵编码数据：读取哈夫曼符号和幅值比特并检查其合法性，
+// 不存储系数，不做逆量化、IDCT 和颜色转换。imgData 只需解析过头部并构建好哈夫曼码表。
+VerifyReport verifyEntropyData(const ImageData &imgData);
+
+// 解析文件头（不打印）后调用 verifyEntropyData
+VerifyReport verifyJPEG(const std::string &filename);
+
+#endif // JPEG_VERIFY_H
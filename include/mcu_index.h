@@ -0,0 +1,45 @@
+#ifndef MCU_INDEX_H
+#define MCU_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+#include "jpeg_encoder.h"
+
+// 熵解码检查点：某个 MCU 开始时的比特位置与 DC 预测值
+struct McuCheckpoint {
+    uint64_t bitOffset = 0;          // 相对 compressedData（已去掉填充字节与 RSTn）的比特位置
+    int previousDc[3] = {0, 0, 0};
+};
+
+// MCU 位置索引：第 k 个检查点对应 MCU k * interval
+struct McuIndex {
+    int width = 0;
+    int height = 0;
+    int interval = 0;                // 检查点间隔（MCU 数）
+    uint64_t dataSize = 0;           // compressedData 字节数，用于发现索引与图像不匹配
+    std::vector<McuCheckpoint> checkpoints;
+};
+
+// 与 huffmanDecode 相同的完整熵解码，同时每隔 interval 个 MCU 记录一个检查点；
+// interval <= 0 时每个 MCU 行记录一个
+DecodeStatus huffmanDecodeWithIndex(const std::vector<uint8_t> &compressedData, ImageData &imgData, int interval,
+                                    McuIndex &index);
+
+// 只做熵解码建立索引，不存储系数（imgData 只需解析头部、构建哈夫曼码表并计算 MCU 布局）
+DecodeStatus buildMcuIndex(const ImageData &imgData, int interval, McuIndex &index);
+
+// 索引文件：检查点的比特位置按差分、DC 按 zigzag 变长整数存储
+bool saveMcuIndex(const std::string &filename, const McuIndex &index);
+bool loadMcuIndex(const std::string &filename, McuIndex &index);
+bool mcuIndexMatches(const McuIndex &index, const ImageData &imgData);
+
+// 解码像素矩形 [x, x + width) × [y, y + height)（超出图像的部分被裁掉）。
+// 只熵解码到矩形最后一个 MCU，只重建矩形覆盖的 MCU；index 非空时每个 MCU 行
+// 从最近的检查点开始熵解码，否则从扫描开头顺序解码；imgData.lumaOnly 时输出灰度
+DecodeStatus decodeRegion(const ImageData &imgData, const McuIndex *index, int x, int y, int width, int height,
+                          RawImage &region);
+
+#endif // MCU_INDEX_H
@@ -0,0 +1,143 @@
+#ifndef MCU_ROW_RING_H
+#define MCU_ROW_RING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// 有界无锁环形队列（Vyukov MPMC 算法），元素为 MCU 行号
+// 熵解码线程生产已解码完成的 MCU 行，重建线程消费；
+// 容量决定熵解码最多能领先重建多少行。
+// tryPush / tryPop 不加锁；push / pop 在队列满或空时先让出 CPU 重试有限次数，仍不成功就在条件变量上睡眠，
+// 空闲线程不占用 CPU。只有存在睡眠的线程时，成功的入队 / 出队才加锁唤醒它们
+class McuRowRing {
+public:
+    explicit McuRowRing(size_t capacity) {
+        // 容量向上取整为 2 的幂，便于用掩码取模
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        slots.reset(new Slot[size]);
+        for (size_t i = 0; i < size; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    // 队列满时返回 false
+    bool tryPush(int row) {
+        if (!pushOnce(row)) return false;
+        wakeWaiters();
+        return true;
+    }
+
+    // 队列空时返回 false
+    bool tryPop(int &row) {
+        if (!popOnce(row)) return false;
+        wakeWaiters();
+        return true;
+    }
+
+    // 队列满时等待
+    void push(int row) {
+        for (int spin = 0; spin < SPIN_LIMIT; ++spin) {
+            if (tryPush(row)) return;
+            std::this_thread::yield();
+        }
+        waitFor([&]() { return pushOnce(row); });
+        wakeWaiters();
+    }
+
+    // 队列空时等待
+    int pop() {
+        int row;
+        for (int spin = 0; spin < SPIN_LIMIT; ++spin) {
+            if (tryPop(row)) return row;
+            std::this_thread::yield();
+        }
+        waitFor([&]() { return popOnce(row); });
+        wakeWaiters();
+        return row;
+    }
+
+private:
+    static constexpr int SPIN_LIMIT = 64;
+
+    // 先登记为等待者再重试：与 wakeWaiters 中“完成操作后检查等待者”的两个全序栅栏配对，
+    // 对方要么看到登记并唤醒，要么它的操作对这里的重试可见，不会丢失唤醒
+    template <typename Attempt>
+    void waitFor(Attempt attempt) {
+        std::unique_lock<std::mutex> lock(waitMutex);
+        waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        changed.wait(lock, attempt);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wakeWaiters() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lock(waitMutex);
+        changed.notify_all();
+    }
+
+    bool pushOnce(int row) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.row = row;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool popOnce(int &row) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    row = slot.row;
+                    slot.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        int row;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePos;  // 生产者与消费者的位置分处不同缓存行
+    alignas(64) std::atomic<size_t> dequeuePos;
+    alignas(64) std::atomic<int> waiters{0};  // 正在 waitFor 中的线程数
+    std::mutex waitMutex;
+    std::condition_variable changed;
+};
+
+#endif // MCU_ROW_RING_H
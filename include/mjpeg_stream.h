@@ -0,0 +1,56 @@
+#ifndef MJPEG_STREAM_H
+#define MJPEG_STREAM_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+
+// MJPEG 流中的一帧在流缓冲区中的位置
+struct MjpegFrame {
+    size_t offset = 0;              // SOI 所在位置
+    size_t size = 0;                // SOI 到 EOI（含）的字节数；流在帧中间结束时截到流末尾
+    size_t headerSize = 0;          // SOI 到 SOS 段结束的字节数，0 表示没有找到 SOS
+    bool hasHuffmanTables = false;  // 帧内有 DHT 段
+    bool hasQuantTables = false;    // 帧内有 DQT 段
+    bool complete = false;          // 以 EOI 结束
+};
+
+// 按标记扫描切分连续的 SOI…EOI 帧：头部按段长度跳过，熵编码数据中找第一个
+// 既不是填充字节也不是 RSTn 的标记；帧之间的其他字节被忽略
+std::vector<MjpegFrame> splitMjpegFrames(const uint8_t *data, size_t size);
+
+// 解码后的一帧，像素为 fillBMPRows 格式（自下而上、B,G,R、4 字节行对齐）
+struct DecodedFrame {
+    size_t index = 0;
+    DecodeStatus status = DecodeStatus::Ok;
+    int width = 0;
+    int height = 0;
+    int channels = 0;                // 1 为灰度，3 为彩色
+    bool defaultHuffmanTables = false;  // 帧内没有 DHT，使用标准表或之前帧的表
+    std::vector<uint8_t> pixelData;
+};
+
+struct MjpegDecodeOptions {
+    int threadCount = 1;        // 解码线程数，1 表示在调用线程中顺序解码
+    int maxFramesInFlight = 0;  // 已解码未交付的帧数上限，0 表示 2 * threadCount
+};
+
+struct MjpegStreamReport {
+    size_t frames = 0;
+    size_t failedFrames = 0;
+    size_t defaultTableFrames = 0;  // 没有 DHT 段的帧数
+};
+
+// 按帧序号依次在调用线程中回调
+using MjpegFrameCallback = std::function<void(const DecodedFrame &)>;
+
+// 解码内存中的 MJPEG 流。DHT 与 DQT 在帧间沿用：每帧从标准哈夫曼表（附录 K.3）
+// 与之前各帧定义过的表开始，再用自己的表覆盖同类别、同 ID 的表。
+// 各帧在线程池中并发解码，按顺序交付
+MjpegStreamReport decodeMjpegStream(const uint8_t *data, size_t size, const MjpegDecodeOptions &options,
+                                    const MjpegFrameCallback &onFrame);
+
+#endif // MJPEG_STREAM_H
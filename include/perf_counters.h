@@ -0,0 +1,86 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+
+// 通过 perf_event_open 读取的硬件计数器（只统计用户态）
+enum class PerfEvent {
+    Cycles,
+    Instructions,
+    BranchMisses,
+    L1dMisses,
+    LlcMisses,
+    Count
+};
+
+const char *perfEventName(PerfEvent event);
+
+// 一次采样的计数差值；valid[i] 为 false 表示该计数器不可用
+struct PerfSample {
+    uint64_t values[static_cast<int>(PerfEvent::Count)] = {};
+    bool valid[static_cast<int>(PerfEvent::Count)] = {};
+
+    uint64_t value(PerfEvent event) const { return values[static_cast<int>(event)]; }
+    bool has(PerfEvent event) const { return valid[static_cast<int>(event)]; }
+    PerfSample &operator+=(const PerfSample &other);
+};
+
+// 调用线程的一组计数器。每个计数器单独打开，部分不可用（虚拟机、容器、
+// perf_event_paranoid 限制或非 Linux 系统）时其余照常工作，全部不可用时 available() 为 false
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available() const;
+    // 第一个打开失败的原因（strerror），全部成功时为空
+    const std::string &error() const { return openError; }
+
+    void start();
+    // 返回 start 以来的计数；被多路复用时按实际运行时间比例放大
+    PerfSample stop();
+
+private:
+    int fds[static_cast<int>(PerfEvent::Count)];
+    uint64_t startValues[static_cast<int>(PerfEvent::Count)][3] = {};
+    std::string openError;
+};
+
+// 解码流水线各阶段，按执行顺序
+enum class DecodeStage {
+    Huffman,
+    Dequantize,
+    ZigZag,
+    IDCT,
+    ColorConvert,   // YCbCr -> BGR 并写入 BMP 行
+    Count
+};
+
+const char *decodeStageName(DecodeStage stage);
+
+// 每个阶段的耗时与计数器
+struct DecodeStageProfile {
+    double milliseconds[static_cast<int>(DecodeStage::Count)] = {};
+    PerfSample counters[static_cast<int>(DecodeStage::Count)];
+    long mcus = 0;
+    int images = 0;
+
+    // 累加另一幅（或另一次）解码；空的 profile 直接取对方的值
+    DecodeStageProfile &operator+=(const DecodeStageProfile &other);
+};
+
+// 与 decodeJPEG + fillBMPRows 相同的解码，但逐阶段计时与采样；imgData 需已初始化块，
+// pixelData 为 bmpRowSize * height 的 BMP 像素。counters 不可用时只记录耗时
+DecodeStatus decodeJPEGProfiled(ImageData &imgData, std::vector<uint8_t> &pixelData, PerfCounters &counters,
+                                DecodeStageProfile &profile);
+
+// 打印每阶段的耗时、IPC 与每 MCU 的周期 / 分支预测失败 / 缓存未命中次数（累加多幅时为合计）
+void printDecodeStageProfile(std::ostream &out, const DecodeStageProfile &profile);
+
+#endif // PERF_COUNTERS_H
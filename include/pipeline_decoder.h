@@ -0,0 +1,17 @@
+#ifndef PIPELINE_DECODER_H
+#define PIPELINE_DECODER_H
+
+#include <vector>
+#include <cstdint>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+
+// 流水线解码：调用线程逐行把系数熵解码到一个 MCU 行的缓冲槽中，经无锁环形队列交给
+// workerCount 个重建线程并发地做逆量化、逆 Zig-Zag、逆 DCT 和颜色转换，
+// 结果写入 BMP 像素缓冲区 pixelData（布局同 fillBMPRows），空出的槽再回到熵解码线程。
+// ringDepth 限制熵解码最多领先重建的 MCU 行数；系数只存在于 ringDepth + workerCount 个槽中，
+// 与图像高度无关。imgData 只需解析头部并 initializeMcuLayout，不使用也不分配整幅图像的系数数组
+DecodeStatus decodeJPEGPipelined(ImageData &imgData, const std::vector<uint8_t> &compressedData,
+                                 std::vector<uint8_t> &pixelData, int workerCount, int ringDepth = 8);
+
+#endif // PIPELINE_DECODER_H
@@ -0,0 +1,77 @@
+#ifndef PIXEL_OUTPUT_H
+#define PIXEL_OUTPUT_H
+
+#include "jpeg_header_parser.h"
+#include <cstdint>
+#include <string>
+
+// 解码结果的输出格式
+enum class OutputFormat {
+    Bmp,      // 24 位 B,G,R（灰度为 8 位调色板）BMP，自下而上
+    Yuv420p,  // 重建后的 Y、Cb、Cr 平面依次排列，不做颜色转换、色度不上采样（灰度或仅亮度只有 Y 平面）
+    Rgb,      // 自上而下的 R,G,B
+    Rgba,     // 自上而下的 R,G,B,255
+    Qoi,      // QOI 无损压缩的 R,G,B，按 MCU 行流式编码写出
+};
+
+bool parseOutputFormat(const std::string &name, OutputFormat &format);
+const char *outputFormatName(OutputFormat format);
+
+inline uint8_t clampToByte(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+// YCbCr 转 RGB 的查找表，结果与浮点公式 int(y + 1.402 * (cr - 128)) 等逐像素相同：
+// y 非负时截断等于 y 加上偏移量的下取整（结果为负时都被裁剪为 0）。G 的两项偏移以 2^-22 定点相加，
+// 两项之和恰为整数时浮点求值顺序会影响截断结果，这种 (cb, cr) 组合退回浮点公式
+struct YccTables {
+    static constexpr int GREEN_SHIFT = 22;
+    int16_t red[256];        // floor(1.402 * (cr - 128))
+    int16_t blue[256];       // floor(1.772 * (cb - 128))
+    int32_t greenCb[256];    // round(-0.344136 * (cb - 128) * 2^22)
+    int32_t greenCr[256];    // round(-0.714136 * (cr - 128) * 2^22)
+    YccTables();
+};
+extern const YccTables yccTables;
+
+// YCbCr（电平偏移后的样本）转 RGB，BMP 与打包 RGB 输出共用，两者像素值完全相同
+inline void ycbcrToRgb(int y, int cb, int cr, uint8_t &r, uint8_t &g, uint8_t &b) {
+    y = clampToByte(y + 128);
+    cb = clampToByte(cb + 128);
+    cr = clampToByte(cr + 128);
+    r = clampToByte(y + yccTables.red[cr]);
+    b = clampToByte(y + yccTables.blue[cb]);
+    int32_t green = yccTables.greenCb[cb] + yccTables.greenCr[cr];
+    constexpr int32_t mask = (1 << YccTables::GREEN_SHIFT) - 1;
+    if (((green + 2) & mask) > 4) {
+        g = clampToByte(y + (green >> YccTables::GREEN_SHIFT));
+    } else {
+        g = clampToByte(int(y - 0.344136 * (cb - 128) - 0.714136 * (cr - 128)));
+    }
+}
+
+// 平面数：有色度时为 3（Y、Cb、Cr），否则为 1
+int yuvPlaneCount(const ImageData &imgData);
+
+// 第 plane 个平面的尺寸：色度平面为亮度的一半（向上取整）
+void yuvPlaneSize(const ImageData &imgData, int plane, int &width, int &height);
+
+// 将 MCU 行 [mcuRowBegin, mcuRowEnd) 的重建样本写入 planes[c]，行跨度 strides[c] 不小于平面宽度；
+// 不同行可并行填充
+void fillYuvPlanes(const ImageData &imgData, int mcuRowBegin, int mcuRowEnd, uint8_t *const planes[3],
+                   const int strides[3]);
+
+// 打包格式每像素字节数：Rgb 为 3，Rgba 为 4
+int packedBytesPerPixel(OutputFormat format);
+
+// 将 MCU 行 [mcuRowBegin, mcuRowEnd) 转换为自上而下的打包像素，行跨度 stride 不小于 width * 每像素字节数；
+// pixels 指向图像第 firstRow 行，按行分段输出时只需一段大小的缓冲区。
+// 灰度或仅亮度图像输出 R = G = B = Y。不同行可并行填充
+void fillPackedRows(const ImageData &imgData, int mcuRowBegin, int mcuRowEnd, OutputFormat format, uint8_t *pixels,
+                    int stride, int firstRow = 0);
+
+// 按格式写出文件：Yuv420p 为紧密排列的平面（I420）；Rgb / Rgba 每行 stride 字节（0 表示紧密排列），
+// 行尾填充为 0，stride 小于 width * 通道数时不写文件并返回 false；Bmp 同 saveAsBMP / saveAsGrayBMP；Qoi 同 saveAsQOI
+bool saveDecodedImage(const std::string &filename, const ImageData &imgData, OutputFormat format, int stride = 0);
+
+#endif // PIXEL_OUTPUT_H
@@ -0,0 +1,41 @@
+#ifndef PYRAMID_DECODER_H
+#define PYRAMID_DECODER_H
+
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+#include "pixel_output.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// 缩小比例 scale 为 1、2、4 或 8，缩小后的尺寸向上取整
+int pyramidLevelSize(int size, int scale);
+
+// 解析 "1,2,4,8" 形式的比例列表，每个比例只能出现一次
+bool parsePyramidScales(const std::string &text, std::vector<int> &scales);
+
+// 缩小的逆 DCT：对逆量化、逆 Zig-Zag 后的完整 8x8 系数块，用按 scale 个相邻样本平均的逆 DCT 基函数
+// 变换（同 IJG jidctred.c），得到 N x N 个电平偏移后的样本（N = 8 / scale），等于完整逆 DCT 输出
+// 按 scale x scale 取平均（只差一次舍入）。out 按行存放，行跨度为 stride。
+// scale 为 1 时是普通的 8 点逆 DCT（浮点矩阵与 inverseDCT 的编译期矩阵可能差一个舍入）
+void reducedInverseDCT(const std::vector<std::vector<Coefficient>> &block, int scale, Coefficient *out, int stride);
+
+// 各级按 MCU 行输出的打包像素（Rgb 或 Rgba，灰度为 R = G = B）：levelIndex 为 scales 中的下标，
+// pixels 为该级第 firstRow 行起的 rowCount 行，行跨度 stride
+using PyramidRowSink =
+    std::function<void(int levelIndex, const uint8_t *pixels, int firstRow, int rowCount, int stride)>;
+
+// 一次熵解码生成多级缩小图像。整幅熵解码之后逐 MCU 行逆量化、逆 Zig-Zag，再用缩小的逆 DCT
+// 由同一份系数生成各缩小级的样本（4:2:0 的色度块只缩小一半倍数，直接得到与亮度同分辨率的色度），
+// 需要 1/1 时最后对该行做完整的逆 DCT，随后立即把各级的对应行转换为像素交给 sink。
+// 1/1 级与 fillPackedRows 的结果完全相同。
+// 调用前需已构建哈夫曼码表并初始化系数块（同 decodeJPEG）
+DecodeStatus decodePyramid(ImageData &imgData, const std::vector<int> &scales, OutputFormat packedFormat,
+                           const PyramidRowSink &sink);
+
+// 每级写出一个文件（filenames 与 scales 一一对应），按 MCU 行边解码边写：Bmp（按行定位写入自下而上的位置）、
+// Rgb、Rgba 或 Qoi。解码失败时 status 为错误码；解码或写文件失败都返回 false
+bool savePyramid(ImageData &imgData, const std::vector<int> &scales, const std::vector<std::string> &filenames,
+                 OutputFormat format, DecodeStatus &status);
+
+#endif // PYRAMID_DECODER_H
@@ -3,8 +3,25 @@
 
 #include "jpeg_header_parser.h"
 #include <string>
+#include <vector>
 
 // 将解码后的 ImageData 保存为 BMP 文件
 bool saveAsBMP(const std::string &filename, const ImageData &imgData);
 
+// 将 ImageData 的 Y 分量保存为 8 位调色板 BMP 文件（灰度图像或仅亮度模式，不依赖 OpenCV）
+bool saveAsGrayBMP(const std::string &filename, const ImageData &imgData);
+
+// BMP 每行像素字节数（4 字节对齐）：灰度/仅亮度为 8 位，彩色为 24 位
+int bmpRowSize(const ImageData &imgData);
+
+// 将 MCU 行 [mcuRowBegin, mcuRowEnd) 转换为 BMP 像素（自下而上）写入 pixelData，
+// pixelData 大小为 bmpRowSize * height；不同行可并行填充
+void fillBMPRows(const ImageData &imgData, int mcuRowBegin, int mcuRowEnd, std::vector<uint8_t> &pixelData);
+
+// 生成 BMP 文件头与信息头（灰度时附带调色板），其后紧接 fillBMPRows 的像素即为完整文件
+void bmpHeaderBytes(const ImageData &imgData, std::vector<uint8_t> &header);
+
+// 写出 BMP 文件头（灰度时附带调色板）与已填充好的像素数据
+bool writeBMP(const std::string &filename, const ImageData &imgData, const std::vector<uint8_t> &pixelData);
+
 #endif // SAVE_AS_BMP_H
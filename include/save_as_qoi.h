@@ -0,0 +1,43 @@
+#ifndef SAVE_AS_QOI_H
+#define SAVE_AS_QOI_H
+
+#include "jpeg_header_parser.h"
+#include "jpeg_encoder.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// QOI（"Quite OK Image"）编码器：无损、按字节编码，每个像素只看前一个像素和 64 项颜色索引，
+// 编码速度接近内存带宽。像素按自上而下的行逐批送入，编码结果追加到 out，调用方可以随时写出并清空 out，
+// 因此整幅图像不必同时驻留内存
+class QoiEncoder {
+public:
+    // 写入 14 字节文件头；channels 为 3（RGB）或 4（RGBA）
+    QoiEncoder(int width, int height, int channels, std::vector<uint8_t> &out);
+
+    // 追加 rowCount 行像素，每行 stride 字节；总行数不能超过 height
+    void encodeRows(const uint8_t *pixels, int rowCount, int stride);
+
+    // 写出未结束的游程与 8 字节结束标记
+    void finish();
+
+    int rowsEncoded() const { return rows; }
+
+private:
+    std::vector<uint8_t> &out;
+    int width;
+    int height;
+    int channels;
+    int rows = 0;
+    int run = 0;
+    uint32_t previous = 0xFF000000u;  // R | G << 8 | B << 16 | A << 24，初始为不透明黑色
+    uint32_t index[64] = {};
+};
+
+// 解码完整的 QOI 数据到 RawImage（channels 同文件头），数据无效时返回 false
+bool decodeQOI(const std::vector<uint8_t> &data, RawImage &image);
+
+// 按 MCU 行逐段转换为 RGB 并编码、写出，内存中只保留一个 MCU 行的像素；灰度或仅亮度时 R = G = B
+bool saveAsQOI(const std::string &filename, const ImageData &imgData);
+
+#endif // SAVE_AS_QOI_H
@@ -0,0 +1,33 @@
+#ifndef SPECULATIVE_HUFFMAN_H
+#define SPECULATIVE_HUFFMAN_H
+
+#include <vector>
+#include <cstdint>
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+
+struct SpeculativeDecodeStats {
+    int chunks = 0;            // 熵编码数据切分的段数，1 表示退回了串行解码
+    int syncedChunks = 0;      // 真实解码状态落在推测序列上的段数
+    long blocks = 0;           // 解码的块数
+    long redecodedBlocks = 0;  // 同步阶段在推测序列之外逐块重新解码的块数
+    double guessMs = 0;        // 三个阶段的耗时：并行推测、串行同步、并行解码
+    double syncMs = 0;
+    double decodeMs = 0;
+};
+
+// 推测式并行熵解码，用于没有重启间隔的图像：
+// 1. 把熵编码数据按比特数切成 threadCount 段，每段从段首比特开始、假定位于 MCU 的第一个块，
+//    并行解码并记录每个块的起止比特、在 MCU 中的位置与 DC 差分（不保存系数），遇到无效码字时
+//    跳过一个比特重新开始；
+// 2. 串行地从真实状态出发：真实的块起点与某段推测序列中的块起点（比特位置相同、所用哈夫曼表
+//    序列相同）重合后，哈夫曼码的自同步保证之后完全一致，直接采用推测结果并用 DC 差分推进预测值；
+//    不重合时逐块解码直到重合；
+// 3. 已知每段的真实起点、块号与 DC 预测值后，各段并行解码到 imgData。
+// 结果（包括出错时的返回值与已写入的系数）与 huffmanDecode 完全相同。有重启间隔、线程数为 1
+// 或数据太短时直接串行解码。
+DecodeStatus speculativeHuffmanDecode(const std::vector<uint8_t> &compressedData, ImageData &imgData,
+                                      int threadCount, SpeculativeDecodeStats *stats = nullptr,
+                                      HuffmanDecodeMode mode = HuffmanDecodeMode::MultiSymbol);
+
+#endif // SPECULATIVE_HUFFMAN_H
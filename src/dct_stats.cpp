@@ -0,0 +1,149 @@
+#include "dct_stats.h"
+#include <algorithm>
+#include <cmath>
+
+// 8x8 正交 DCT 中 DC = 8 * 块均值，因此块均值 = DC * q0 / 8，再加回电平偏移 128
+static double blockMean(int dc, int quant0) {
+    return dc * quant0 / 8.0 + 128.0;
+}
+
+void computeDctStats(const ImageData &imgData, DctImageStats &stats) {
+    const std::vector<int> &quantTableY = imgData.quantizationTables.at(imgData.yQuantTableId);
+
+    // 1/8 尺寸亮度图：每个 Y 块对应一个像素，裁掉整块都在图像之外的填充块
+    stats.lumaMapWidth = (imgData.width + 7) / 8;
+    stats.lumaMapHeight = (imgData.height + 7) / 8;
+    stats.lumaMap.assign(stats.lumaMapWidth * stats.lumaMapHeight, 0);
+    for (int c = 0; c < 3; ++c) {
+        stats.histogram[c].assign(256, 0);
+        stats.mean[c] = 128.0;
+    }
+
+    double sumY = 0;
+    int countY = 0;
+    for (int block = 0; block < imgData.totalYBlocks; ++block) {
+        int row = 0, col = 0;
+        imgData.yBlockPosition(block, row, col);
+        if (row >= imgData.height || col >= imgData.width) continue;
+
+        double mean = blockMean(imgData.Y[block][0], quantTableY[0]);
+        uint8_t value = static_cast<uint8_t>(std::clamp(static_cast<int>(std::lround(mean)), 0, 255));
+        stats.lumaMap[(row / 8) * stats.lumaMapWidth + col / 8] = value;
+        stats.histogram[0][value]++;
+        sumY += mean;
+        countY++;
+    }
+    if (countY) stats.mean[0] = sumY / countY;
+
+    // 色度：每个 MCU 一个 Cb 块和一个 Cr 块
+    if (imgData.hasChroma()) {
+        const std::vector<int> &quantTableCrCb = imgData.quantizationTables.at(imgData.crCbQuantTableId);
+        double sumCb = 0, sumCr = 0;
+        for (int mcu = 0; mcu < imgData.totalCrCbBlocks; ++mcu) {
+            double cb = blockMean(imgData.Cb[mcu][0], quantTableCrCb[0]);
+            double cr = blockMean(imgData.Cr[mcu][0], quantTableCrCb[0]);
+            stats.histogram[1][std::clamp(static_cast<int>(std::lround(cb)), 0, 255)]++;
+            stats.histogram[2][std::clamp(static_cast<int>(std::lround(cr)), 0, 255)]++;
+            sumCb += cb;
+            sumCr += cr;
+        }
+        if (imgData.totalCrCbBlocks) {
+            stats.mean[1] = sumCb / imgData.totalCrCbBlocks;
+            stats.mean[2] = sumCr / imgData.totalCrCbBlocks;
+        }
+    }
+
+    // 与 saveAsBMP 相同的 YCbCr -> RGB 公式
+    double y = stats.mean[0], cb = stats.mean[1] - 128.0, cr = stats.mean[2] - 128.0;
+    stats.meanRGB[0] = std::clamp(y + 1.402 * cr, 0.0, 255.0);
+    stats.meanRGB[1] = std::clamp(y - 0.344136 * cb - 0.714136 * cr, 0.0, 255.0);
+    stats.meanRGB[2] = std::clamp(y + 1.772 * cb, 0.0, 255.0);
+
+    stats.perceptualHash = perceptualHash(stats.lumaMap, stats.lumaMapWidth, stats.lumaMapHeight);
+}
+
+DecodeStatus decodeDctStats(ImageData &imgData, DctImageStats &stats) {
+    if (!imgData.hasSupportedSampling()) return DecodeStatus::UnsupportedSampling;
+    DecodeStatus status = huffmanDecode(imgData.compressedData, imgData);
+    if (status != DecodeStatus::Ok) return status;
+    computeDctStats(imgData, stats);
+    return DecodeStatus::Ok;
+}
+
+constexpr int HASH_SIZE = 32;   // 缩放后的边长
+constexpr int HASH_LOW = 8;     // 保留的低频系数边长
+
+// 32 点 DCT 的前 8 个基函数，首次使用时计算一次（线程安全的局部静态变量）
+struct HashDctBasis {
+    double v[HASH_LOW][HASH_SIZE];
+    HashDctBasis() {
+        for (int u = 0; u < HASH_LOW; ++u) {
+            for (int x = 0; x < HASH_SIZE; ++x) {
+                v[u][x] = std::cos((2 * x + 1) * u * M_PI / (2 * HASH_SIZE));
+            }
+        }
+    }
+};
+
+uint64_t perceptualHash(const std::vector<uint8_t> &gray, int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    static const HashDctBasis basis;
+
+    // 按块平均缩放到 32x32
+    double small[HASH_SIZE][HASH_SIZE];
+    for (int oy = 0; oy < HASH_SIZE; ++oy) {
+        int y0 = oy * height / HASH_SIZE;
+        int y1 = std::max(y0 + 1, (oy + 1) * height / HASH_SIZE);
+        for (int ox = 0; ox < HASH_SIZE; ++ox) {
+            int x0 = ox * width / HASH_SIZE;
+            int x1 = std::max(x0 + 1, (ox + 1) * width / HASH_SIZE);
+            double sum = 0;
+            for (int y = y0; y < y1; ++y) {
+                for (int x = x0; x < x1; ++x) {
+                    sum += gray[y * width + x];
+                }
+            }
+            small[oy][ox] = sum / ((y1 - y0) * (x1 - x0));
+        }
+    }
+
+    // 可分离 2D DCT，只计算左上 8x8
+    double rows[HASH_LOW][HASH_SIZE];
+    for (int u = 0; u < HASH_LOW; ++u) {
+        for (int y = 0; y < HASH_SIZE; ++y) {
+            double sum = 0;
+            for (int x = 0; x < HASH_SIZE; ++x) sum += basis.v[u][x] * small[y][x];
+            rows[u][y] = sum;
+        }
+    }
+    double coefficients[HASH_LOW * HASH_LOW];
+    for (int v = 0; v < HASH_LOW; ++v) {
+        for (int u = 0; u < HASH_LOW; ++u) {
+            double sum = 0;
+            for (int y = 0; y < HASH_SIZE; ++y) sum += basis.v[v][y] * rows[u][y];
+            coefficients[v * HASH_LOW + u] = sum;
+        }
+    }
+
+    // 与中位数比较
+    double sorted[HASH_LOW * HASH_LOW];
+    std::copy(coefficients, coefficients + HASH_LOW * HASH_LOW, sorted);
+    std::nth_element(sorted, sorted + 32, sorted + 64);
+    double median = sorted[32];
+
+    uint64_t hash = 0;
+    for (int i = 0; i < HASH_LOW * HASH_LOW; ++i) {
+        if (coefficients[i] > median) hash |= 1ULL << i;
+    }
+    return hash;
+}
+
+int hammingDistance(uint64_t a, uint64_t b) {
+    uint64_t diff = a ^ b;
+    int count = 0;
+    while (diff) {
+        diff &= diff - 1;
+        count++;
+    }
+    return count;
+}
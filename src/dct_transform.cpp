@@ -0,0 +1,165 @@
+#include "dct_transform.h"
+#include <algorithm>
+#include <vector>
+
+// Zig-Zag 索引表：zigzagOrder[row][col] 为自然顺序 (row, col) 在 Zig-Zag 序列中的下标
+static const int zigzagOrder[8][8] =
+{{0,  1,  5,  6, 14, 15, 27, 28},
+{2,  4,  7, 13, 16, 26, 29, 42},
+{3,  8, 12, 17, 25, 30, 41, 43},
+{9, 11, 18, 24, 31, 40, 44, 53},
+{10, 19, 23, 32, 39, 45, 52, 54},
+{20, 22, 33, 38, 46, 51, 55, 60},
+{21, 34, 37, 47, 50, 56, 59, 61},
+{35, 36, 48, 49, 57, 58, 62, 63}};
+
+bool parseDctTransform(const std::string &name, DctTransform &transform) {
+    if (name == "flip-h") transform = DctTransform::FlipHorizontal;
+    else if (name == "flip-v") transform = DctTransform::FlipVertical;
+    else if (name == "transpose") transform = DctTransform::Transpose;
+    else if (name == "rot90") transform = DctTransform::Rotate90;
+    else if (name == "rot180") transform = DctTransform::Rotate180;
+    else if (name == "rot270") transform = DctTransform::Rotate270;
+    else if (name == "none") transform = DctTransform::None;
+    else return false;
+    return true;
+}
+
+static bool isTransposing(DctTransform transform) {
+    return transform == DctTransform::Transpose || transform == DctTransform::Rotate90 ||
+           transform == DctTransform::Rotate270;
+}
+
+// 块内系数变换表：目标 Zig-Zag 位置 i 的系数 = sign[i] * 源块第 sourceIndex[i] 个系数
+// 像素域的镜像对应频率 u 的系数乘以 (-1)^u，转置对应系数矩阵转置
+// 顺时针 90 度 = 转置 + 左右镜像，270 度 = 转置 + 上下镜像
+struct BlockMapping {
+    int sourceIndex[64];
+    int sign[64];
+};
+
+static BlockMapping makeBlockMapping(DctTransform transform) {
+    BlockMapping mapping;
+    bool transpose = isTransposing(transform);
+    for (int v = 0; v < 8; ++v) {
+        for (int u = 0; u < 8; ++u) {
+            bool negate = false;
+            switch (transform) {
+            case DctTransform::FlipHorizontal:
+            case DctTransform::Rotate90:
+                negate = u & 1;
+                break;
+            case DctTransform::FlipVertical:
+            case DctTransform::Rotate270:
+                negate = v & 1;
+                break;
+            case DctTransform::Rotate180:
+                negate = (u + v) & 1;
+                break;
+            default:
+                break;
+            }
+            int target = zigzagOrder[v][u];
+            mapping.sourceIndex[target] = transpose ? zigzagOrder[u][v] : target;
+            mapping.sign[target] = negate ? -1 : 1;
+        }
+    }
+    return mapping;
+}
+
+// 目标块 (dx, dy) 来自源块网格（宽 srcW、高 srcH）中的哪一块
+static void sourceBlock(DctTransform transform, int dx, int dy, int srcW, int srcH, int &sx, int &sy) {
+    switch (transform) {
+    case DctTransform::FlipHorizontal: sx = srcW - 1 - dx; sy = dy; break;
+    case DctTransform::FlipVertical:   sx = dx; sy = srcH - 1 - dy; break;
+    case DctTransform::Rotate180:      sx = srcW - 1 - dx; sy = srcH - 1 - dy; break;
+    case DctTransform::Transpose:      sx = dy; sy = dx; break;
+    case DctTransform::Rotate90:       sx = dy; sy = srcH - 1 - dx; break;
+    case DctTransform::Rotate270:      sx = srcW - 1 - dy; sy = dx; break;
+    default:                           sx = dx; sy = dy; break;
+    }
+}
+
+// 分量平面中块坐标 (bx, by) 在 ImageData 存储中的下标
+// 彩色图像的 Y 按 MCU 存 4 块（左上、右上、左下、右下），其余情况按光栅顺序
+static int blockIndex(bool interleavedY, int mcuWidth, int bx, int by) {
+    if (!interleavedY) return by * mcuWidth + bx;
+    int mcu = (by / 2) * mcuWidth + bx / 2;
+    return mcu * 4 + (by % 2) * 2 + bx % 2;
+}
+
+// 变换一个分量平面；blocksPerMcuSide 为每个 MCU 在该分量上的边长（块数）
+static void transformPlane(std::vector<std::vector<Coefficient>> &blocks, DctTransform transform,
+                           int srcMcuWidth, int srcMcuCols, int srcMcuRows, int dstMcuWidth, int blocksPerMcuSide) {
+    bool interleavedY = blocksPerMcuSide == 2;
+    int srcW = srcMcuCols * blocksPerMcuSide;
+    int srcH = srcMcuRows * blocksPerMcuSide;
+    int dstW = isTransposing(transform) ? srcH : srcW;
+    int dstH = isTransposing(transform) ? srcW : srcH;
+
+    // 块本身只移动不复制，系数在临时数组中变换后写回
+    BlockMapping mapping = makeBlockMapping(transform);
+    std::vector<std::vector<Coefficient>> result(dstW * dstH);
+    Coefficient coefficients[64];
+    for (int dy = 0; dy < dstH; ++dy) {
+        for (int dx = 0; dx < dstW; ++dx) {
+            int sx, sy;
+            sourceBlock(transform, dx, dy, srcW, srcH, sx, sy);
+            std::vector<Coefficient> &block = result[blockIndex(interleavedY, dstMcuWidth, dx, dy)];
+            block = std::move(blocks[blockIndex(interleavedY, srcMcuWidth, sx, sy)]);
+            std::copy(block.begin(), block.end(), coefficients);
+            for (int i = 0; i < 64; ++i) {
+                block[i] = saturateCoefficient(mapping.sign[i] * coefficients[mapping.sourceIndex[i]]);
+            }
+        }
+    }
+    blocks.swap(result);
+}
+
+// 转置 Zig-Zag 顺序存储的量化表
+static void transposeQuantTable(std::vector<int> &table) {
+    std::vector<int> result(64);
+    for (int v = 0; v < 8; ++v) {
+        for (int u = 0; u < 8; ++u) {
+            result[zigzagOrder[v][u]] = table[zigzagOrder[u][v]];
+        }
+    }
+    table.swap(result);
+}
+
+void transformCoefficients(ImageData &imgData, DctTransform transform) {
+    if (transform == DctTransform::None) return;
+
+    // 会被移到左边/上边的不完整 MCU 需要裁掉
+    int size = imgData.mcuSize();
+    bool trimWidth = transform == DctTransform::FlipHorizontal || transform == DctTransform::Rotate180 ||
+                     transform == DctTransform::Rotate270;
+    bool trimHeight = transform == DctTransform::FlipVertical || transform == DctTransform::Rotate180 ||
+                      transform == DctTransform::Rotate90;
+    int width = imgData.width;
+    int height = imgData.height;
+    if (trimWidth && width >= size) width -= width % size;
+    if (trimHeight && height >= size) height -= height % size;
+
+    int srcMcuCols = (width + size - 1) / size;
+    int srcMcuRows = (height + size - 1) / size;
+    int dstMcuWidth = isTransposing(transform) ? srcMcuRows : srcMcuCols;
+
+    int ySide = imgData.isGrayscale() ? 1 : 2;
+    transformPlane(imgData.Y, transform, imgData.mcuWidth, srcMcuCols, srcMcuRows, dstMcuWidth, ySide);
+    if (imgData.hasChroma()) {
+        transformPlane(imgData.Cb, transform, imgData.mcuWidth, srcMcuCols, srcMcuRows, dstMcuWidth, 1);
+        transformPlane(imgData.Cr, transform, imgData.mcuWidth, srcMcuCols, srcMcuRows, dstMcuWidth, 1);
+    }
+
+    if (isTransposing(transform)) {
+        for (auto &entry : imgData.quantizationTables) {
+            transposeQuantTable(entry.second);
+        }
+        std::swap(width, height);
+    }
+
+    // 按新的宽高重新计算 MCU 网格；系数数组已与新网格一致，二维块只在裁边时缩小，
+    // 其内容会被 inverseZigZag 整体覆盖
+    imgData.initializeBlocks(width, height);
+}
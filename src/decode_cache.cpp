@@ -0,0 +1,338 @@
+#include "decode_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint64_t PRIME1 = 11400714785074694791ull;
+constexpr uint64_t PRIME2 = 14029467366897019727ull;
+constexpr uint64_t PRIME3 = 1609587929392839161ull;
+constexpr uint64_t PRIME4 = 9650029242287828579ull;
+constexpr uint64_t PRIME5 = 2870177450012600261ull;
+
+inline uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t load64(const uint8_t *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t load32(const uint8_t *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t hashRound(uint64_t acc, uint64_t input) {
+    return rotateLeft(acc + input * PRIME2, 31) * PRIME1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    return (acc ^ hashRound(0, value)) * PRIME1 + PRIME4;
+}
+
+// 磁盘层文件：固定头部、选项字符串、数据
+const char CACHE_MAGIC[8] = {'J', 'D', 'C', 'A', 'C', 'H', 'E', '1'};
+const char *CACHE_EXTENSION = ".jdc";
+
+struct CacheFileHeader {
+    char magic[8];
+    uint64_t contentHash;
+    uint64_t contentSize;
+    uint64_t optionsHash;
+    int32_t width;
+    int32_t height;
+    int32_t channels;
+    uint32_t optionsLength;
+    uint64_t dataSize;
+};
+
+uint64_t imageBytes(const std::shared_ptr<const CachedImage> &image) {
+    return image->size();
+}
+} // namespace
+
+uint64_t hashBytes(const uint8_t *data, size_t size, uint64_t seed) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    uint64_t hash;
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2, v2 = seed + PRIME2, v3 = seed, v4 = seed - PRIME1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = hashRound(v1, load64(p));
+            v2 = hashRound(v2, load64(p + 8));
+            v3 = hashRound(v3, load64(p + 16));
+            v4 = hashRound(v4, load64(p + 24));
+        }
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = seed + PRIME5;
+    }
+    hash += size;
+
+    for (; p + 8 <= end; p += 8) hash = rotateLeft(hash ^ hashRound(0, load64(p)), 27) * PRIME1 + PRIME4;
+    if (p + 4 <= end) {
+        hash = rotateLeft(hash ^ (load32(p) * PRIME1), 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) hash = rotateLeft(hash ^ (*p * PRIME5), 11) * PRIME1;
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+DecodeCacheKey makeDecodeCacheKey(const uint8_t *data, size_t size, const std::string &options) {
+    DecodeCacheKey key;
+    key.contentHash = hashBytes(data, size);
+    key.contentSize = size;
+    key.options = options;
+    key.optionsHash = hashBytes(reinterpret_cast<const uint8_t *>(options.data()), options.size(), size);
+    return key;
+}
+
+CachedImage::CachedImage(int width, int height, int channels, std::vector<uint8_t> bytes)
+    : width(width), height(height), channels(channels), bytes(std::move(bytes)) {}
+
+CachedImage::~CachedImage() {
+    if (mapping) ::munmap(mapping, mappingLength);
+}
+
+std::shared_ptr<const CachedImage> CachedImage::map(const std::string &path, const DecodeCacheKey &key) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info {};
+    void *mapping = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(CacheFileHeader)) {
+        mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);  // 映射在关闭文件后仍然有效
+    if (mapping == MAP_FAILED) return nullptr;
+
+    std::shared_ptr<CachedImage> image(new CachedImage());
+    image->mapping = mapping;
+    image->mappingLength = static_cast<size_t>(info.st_size);
+
+    CacheFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    const uint8_t *options = static_cast<const uint8_t *>(mapping) + sizeof(header);
+    size_t dataOffset = sizeof(header) + header.optionsLength;
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.contentHash != key.contentHash ||
+        header.contentSize != key.contentSize || header.optionsHash != key.optionsHash ||
+        header.optionsLength != key.options.size() || dataOffset + header.dataSize != image->mappingLength ||
+        std::memcmp(options, key.options.data(), key.options.size()) != 0) {
+        return nullptr;
+    }
+    image->width = header.width;
+    image->height = header.height;
+    image->channels = header.channels;
+    image->mappedData = static_cast<const uint8_t *>(mapping) + dataOffset;
+    image->mappedSize = header.dataSize;
+    return image;
+}
+
+DecodeCache::DecodeCache(const DecodeCacheOptions &options) : options(options) {
+    if (this->options.diskDirectory.empty()) return;
+    std::error_code error;
+    std::filesystem::create_directories(this->options.diskDirectory, error);
+
+    // 沿用目录中已有的缓存文件，按修改时间排成 LRU 顺序；删除上次未完成写入的临时文件
+    std::vector<std::pair<std::filesystem::file_time_type, DiskEntry>> existing;
+    for (const auto &file : std::filesystem::directory_iterator(this->options.diskDirectory, error)) {
+        std::string name = file.path().filename().string();
+        if (file.path().extension() == ".tmp") {
+            std::filesystem::remove(file.path(), error);
+        } else if (file.path().extension() == CACHE_EXTENSION && file.is_regular_file(error)) {
+            existing.push_back({file.last_write_time(error), DiskEntry{name, file.file_size(error)}});
+        }
+    }
+    std::sort(existing.begin(), existing.end(),
+              [](const auto &a, const auto &b) { return a.first > b.first; });
+    for (const auto &item : existing) {
+        diskLru.push_back(item.second);
+        diskIndex[item.second.name] = std::prev(diskLru.end());
+        diskUsed += item.second.bytes;
+    }
+}
+
+std::string DecodeCache::diskPath(const DecodeCacheKey &key) const {
+    char name[40];
+    std::snprintf(name, sizeof(name), "%016llx%016llx", static_cast<unsigned long long>(key.contentHash),
+                  static_cast<unsigned long long>(key.optionsHash));
+    return (std::filesystem::path(options.diskDirectory) / (std::string(name) + CACHE_EXTENSION)).string();
+}
+
+std::shared_ptr<const CachedImage> DecodeCache::lookup(const DecodeCacheKey &key) {
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        auto it = memoryIndex.find(key);
+        if (it != memoryIndex.end()) {
+            memoryLru.splice(memoryLru.begin(), memoryLru, it->second);
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->image;
+        }
+    }
+
+    if (!options.diskDirectory.empty()) {
+        std::string path = diskPath(key);
+        std::string name = std::filesystem::path(path).filename().string();
+        bool known;
+        {
+            std::lock_guard<std::mutex> lock(diskMutex);
+            known = diskIndex.count(name) > 0;
+        }
+        std::shared_ptr<const CachedImage> image = known ? CachedImage::map(path, key) : nullptr;
+        if (image) {
+            diskHits.fetch_add(1, std::memory_order_relaxed);
+            touchDisk(name, 0);
+            std::vector<Entry> evicted;
+            insertMemory(key, image, evicted);
+            for (const Entry &entry : evicted) spillToDisk(entry);
+            return image;
+        }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void DecodeCache::insert(const DecodeCacheKey &key, std::shared_ptr<const CachedImage> image) {
+    insertions.fetch_add(1, std::memory_order_relaxed);
+    std::vector<Entry> evicted;
+    if (imageBytes(image) > options.memoryBytes) {
+        evicted.push_back(Entry{key, std::move(image)});
+    } else {
+        insertMemory(key, std::move(image), evicted);
+    }
+    for (const Entry &entry : evicted) spillToDisk(entry);
+}
+
+void DecodeCache::insertMemory(const DecodeCacheKey &key, std::shared_ptr<const CachedImage> image,
+                               std::vector<Entry> &evicted) {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    auto it = memoryIndex.find(key);
+    if (it != memoryIndex.end()) {
+        memoryUsed -= imageBytes(it->second->image);
+        memoryLru.erase(it->second);
+        memoryIndex.erase(it);
+    }
+    memoryUsed += imageBytes(image);
+    memoryLru.push_front(Entry{key, std::move(image)});
+    memoryIndex[key] = memoryLru.begin();
+
+    while (memoryUsed > options.memoryBytes && !memoryLru.empty()) {
+        Entry &victim = memoryLru.back();
+        memoryUsed -= imageBytes(victim.image);
+        memoryIndex.erase(victim.key);
+        evicted.push_back(std::move(victim));
+        memoryLru.pop_back();
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void DecodeCache::spillToDisk(const Entry &entry) {
+    if (options.diskDirectory.empty()) return;
+    std::string path = diskPath(entry.key);
+    std::string name = std::filesystem::path(path).filename().string();
+    {
+        std::lock_guard<std::mutex> lock(diskMutex);
+        if (diskIndex.count(name)) return;  // 来自磁盘层，或已由其他线程写出
+    }
+
+    // 先写临时文件再改名，并发读取者只会看到完整的文件
+    static std::atomic<uint64_t> tempCounter{0};
+    std::string tempPath = path + "." + std::to_string(::getpid()) + "-" +
+                           std::to_string(tempCounter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+    const CachedImage &image = *entry.image;
+    CacheFileHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.contentHash = entry.key.contentHash;
+    header.contentSize = entry.key.contentSize;
+    header.optionsHash = entry.key.optionsHash;
+    header.width = image.width;
+    header.height = image.height;
+    header.channels = image.channels;
+    header.optionsLength = static_cast<uint32_t>(entry.key.options.size());
+    header.dataSize = image.size();
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(entry.key.options.data(), entry.key.options.size());
+        file.write(reinterpret_cast<const char *>(image.data()), image.size());
+        if (!file) {
+            file.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return;
+    }
+    diskWrites.fetch_add(1, std::memory_order_relaxed);
+    touchDisk(name, sizeof(header) + entry.key.options.size() + image.size());
+}
+
+void DecodeCache::touchDisk(const std::string &name, uint64_t bytes) {
+    std::vector<std::string> removed;
+    {
+        std::lock_guard<std::mutex> lock(diskMutex);
+        auto it = diskIndex.find(name);
+        if (it != diskIndex.end()) {
+            diskLru.splice(diskLru.begin(), diskLru, it->second);
+        } else if (bytes > 0) {
+            diskLru.push_front(DiskEntry{name, bytes});
+            diskIndex[name] = diskLru.begin();
+            diskUsed += bytes;
+        }
+        while (diskUsed > options.diskBytes && diskLru.size() > 1) {
+            const DiskEntry &victim = diskLru.back();
+            diskUsed -= victim.bytes;
+            removed.push_back(victim.name);
+            diskIndex.erase(victim.name);
+            diskLru.pop_back();
+        }
+    }
+    // 已映射的文件删除后映射仍然有效，持有者不受影响
+    for (const std::string &victim : removed) {
+        std::remove((std::filesystem::path(options.diskDirectory) / victim).string().c_str());
+        diskEvictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+DecodeCacheStats DecodeCache::stats() const {
+    DecodeCacheStats result;
+    result.hits = hits.load(std::memory_order_relaxed);
+    result.diskHits = diskHits.load(std::memory_order_relaxed);
+    result.misses = misses.load(std::memory_order_relaxed);
+    result.insertions = insertions.load(std::memory_order_relaxed);
+    result.evictions = evictions.load(std::memory_order_relaxed);
+    result.diskWrites = diskWrites.load(std::memory_order_relaxed);
+    result.diskEvictions = diskEvictions.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        result.memoryBytes = memoryUsed;
+        result.memoryEntries = memoryLru.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(diskMutex);
+        result.diskBytes = diskUsed;
+        result.diskEntries = diskLru.size();
+    }
+    return result;
+}
@@ -0,0 +1,598 @@
+#include "decode_server.h"
+#include "jpeg_decoder.h"
+#include "decode_trace.h"
+#include "jpeg_encoder.h"
+#include "mcu_index.h"
+#include "pyramid_decoder.h"
+#include "save_as_bmp.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool writeAll(int fd, const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t count = ::write(fd, p, size);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        p += count;
+        size -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+// 向唤醒管道写入一个字节；管道已满时主线程已有待处理的唤醒，写入失败可以忽略
+void wakePoll(int fd) {
+    char byte = 0;
+    ssize_t written = ::write(fd, &byte, 1);
+    (void)written;
+}
+
+// 读入整个文件；超过 maxBytes 时不读取，返回 false 并把 tooLarge 置为 true
+bool readFile(const std::string &path, std::vector<uint8_t> &data, size_t maxBytes, bool &tooLarge) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamoff size = file.tellg();
+    if (size < 0) return false;
+    tooLarge = static_cast<uint64_t>(size) > maxBytes;
+    if (tooLarge) return false;
+    data.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(data.data()), data.size()));
+}
+
+// 把 from 的系数块存储交换到 to（resize 会保留已有的块，只需清零）
+void swapCoefficientStorage(ImageData &from, ImageData &to) {
+    from.Y.swap(to.Y);
+    from.Cb.swap(to.Cb);
+    from.Cr.swap(to.Cr);
+    from.Y_blocks_2D.swap(to.Y_blocks_2D);
+    from.Cb_blocks_2D.swap(to.Cb_blocks_2D);
+    from.Cr_blocks_2D.swap(to.Cr_blocks_2D);
+}
+
+// 完整解码到 buffers.pixels（fillBMPRows 布局），复用上一次请求的系数块
+DecodeStatus decodeWithWarmBuffers(ImageData &imgData, DecodeWorkerBuffers &buffers) {
+    imgData.initializeHuffmanTables();
+    swapCoefficientStorage(buffers.coefficients, imgData);
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    for (auto *component : {&imgData.Y, &imgData.Cb, &imgData.Cr}) {
+        for (auto &block : *component) std::fill(block.begin(), block.end(), 0);
+    }
+    DecodeStatus status = decodeJPEG(imgData, imgData.compressedData);
+    if (status == DecodeStatus::Ok) {
+        buffers.pixels.assign(static_cast<size_t>(bmpRowSize(imgData)) * imgData.height, 0);
+        fillBMPRows(imgData, 0, imgData.mcuHeight, buffers.pixels);
+    }
+    swapCoefficientStorage(imgData, buffers.coefficients);
+    return status;
+}
+
+// 缩小解码：decodePyramid 只生成 1/scale 一级，得到紧密排列的像素（灰度或仅亮度时为单通道）
+DecodeStatus decodeScaled(ImageData &imgData, int scale, DecodeWorkerBuffers &buffers, RawImage &image) {
+    imgData.initializeHuffmanTables();
+    swapCoefficientStorage(buffers.coefficients, imgData);
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    for (auto *component : {&imgData.Y, &imgData.Cb, &imgData.Cr}) {
+        for (auto &block : *component) std::fill(block.begin(), block.end(), 0);
+    }
+    image.width = pyramidLevelSize(imgData.width, scale);
+    image.height = pyramidLevelSize(imgData.height, scale);
+    image.channels = imgData.hasChroma() ? 3 : 1;
+    image.pixels.assign(static_cast<size_t>(image.width) * image.height * image.channels, 0);
+    // decodePyramid 总是输出 R,G,B，单通道时取 R（灰度时 R = G = B）
+    DecodeStatus status = decodePyramid(imgData, {scale}, OutputFormat::Rgb,
+                                        [&](int, const uint8_t *pixels, int firstRow, int rowCount, int stride) {
+        size_t rowBytes = static_cast<size_t>(image.width) * image.channels;
+        for (int row = 0; row < rowCount; ++row) {
+            const uint8_t *src = pixels + static_cast<size_t>(row) * stride;
+            uint8_t *dst = &image.pixels[(firstRow + row) * rowBytes];
+            if (image.channels == 3) {
+                std::memcpy(dst, src, rowBytes);
+            } else {
+                for (int x = 0; x < image.width; ++x) dst[x] = src[x * 3];
+            }
+        }
+    });
+    swapCoefficientStorage(imgData, buffers.coefficients);
+    return status;
+}
+
+// 解码 buffers.input 中的 JPEG，生成响应数据（不经过缓存）
+std::shared_ptr<const CachedImage> decodeImage(const DecodeRequest &request, DecodeWorkerBuffers &buffers,
+                                               const DecodeLimits &limits, std::string &error) {
+    ImageData imgData = parseJPEGMemory(buffers.input.data(), buffers.input.size());
+    if (!imgData.width || !imgData.height || !imgData.hasSupportedSampling() || !imgData.hasRequiredQuantTables()) {
+        error = decodeStatusMessage(DecodeStatus::InvalidHeader);
+        return nullptr;
+    }
+    // 在分配系数块之前拒绝过大或与扫描数据长度不符的尺寸
+    if (!imgData.hasPlausibleSize(limits.maxPixels)) {
+        error = "image too large";
+        return nullptr;
+    }
+    imgData.lumaOnly = request.lumaOnly;
+
+    // 两条路径最终都得到 fillBMPRows 布局的像素与描述它的 ImageData
+    ImageData layout;
+    if (request.crop) {
+        imgData.initializeHuffmanTables();
+        imgData.initializeMcuLayout(imgData.width, imgData.height);
+        RawImage region;
+        DecodeStatus status = decodeRegion(imgData, nullptr, request.cropX, request.cropY, request.cropWidth,
+                                           request.cropHeight, region);
+        if (status != DecodeStatus::Ok || !region.width || !region.height) {
+            error = status != DecodeStatus::Ok ? decodeStatusMessage(status) : "empty region";
+            return nullptr;
+        }
+        layout.colorComponents = region.channels;
+        layout.width = region.width;
+        layout.height = region.height;
+        bmpRowsFromRawImage(region, buffers.pixels);
+    } else if (request.scale > 1) {
+        RawImage scaled;
+        DecodeStatus status = decodeScaled(imgData, request.scale, buffers, scaled);
+        if (status != DecodeStatus::Ok) {
+            error = decodeStatusMessage(status);
+            return nullptr;
+        }
+        layout.colorComponents = scaled.channels;
+        layout.width = scaled.width;
+        layout.height = scaled.height;
+        bmpRowsFromRawImage(scaled, buffers.pixels);
+    } else {
+        DecodeStatus status = decodeWithWarmBuffers(imgData, buffers);
+        if (status != DecodeStatus::Ok) {
+            error = decodeStatusMessage(status);
+            return nullptr;
+        }
+        layout.colorComponents = imgData.hasChroma() ? 3 : 1;
+        layout.width = imgData.width;
+        layout.height = imgData.height;
+    }
+    int channels = layout.colorComponents;
+
+    std::vector<uint8_t> bytes;
+    if (request.bmpFormat || !request.outputPath.empty()) {
+        bmpHeaderBytes(layout, bytes);
+        bytes.insert(bytes.end(), buffers.pixels.begin(), buffers.pixels.end());
+    } else {
+        bytes = rawImageFromBMPRows(buffers.pixels, layout.width, layout.height, channels).pixels;
+    }
+    return std::make_shared<CachedImage>(layout.width, layout.height, channels, std::move(bytes));
+}
+
+bool writeBytes(const std::string &path, const CachedImage &image) {
+    TraceScope trace("write bmp");
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(image.data()), image.size());
+    return static_cast<bool>(file);
+}
+
+// 处理一个 decode 请求，生成完整的响应
+void handleDecode(const DecodeRequest &request, DecodeWorkerBuffers &buffers, DecodeCache *cache,
+                  const DecodeLimits &limits) {
+    std::vector<uint8_t> &response = buffers.response;
+    auto fail = [&](const std::string &message) {
+        std::string line = "error " + message + "\n";
+        response.assign(line.begin(), line.end());
+    };
+
+    std::string error, outputPath;
+    if (!request.outputPath.empty() && !resolveServerPath(limits.rootDirectory, request.outputPath, outputPath, error)) {
+        fail(error);
+        return;
+    }
+    std::shared_ptr<const CachedImage> image = decodeRequestImage(request, buffers, cache, error, limits);
+    if (!image) {
+        fail(error);
+        return;
+    }
+
+    std::ostringstream line;
+    line << "ok " << image->width << " " << image->height << " " << image->channels << " ";
+    if (!request.outputPath.empty()) {
+        if (!writeBytes(outputPath, *image)) {
+            fail("cannot write " + request.outputPath);
+            return;
+        }
+        line << request.outputPath << "\n";
+        std::string text = line.str();
+        response.assign(text.begin(), text.end());
+        return;
+    }
+    line << image->size() << "\n";
+    std::string text = line.str();
+    response.assign(text.begin(), text.end());
+    response.insert(response.end(), image->data(), image->data() + image->size());
+}
+
+} // namespace
+
+bool FdReader::readLine(std::string &line) {
+    line.clear();
+    while (true) {
+        if (pos == end && !fill()) return false;
+        const void *newline = std::memchr(buffer + pos, '\n', end - pos);
+        size_t stop = newline ? static_cast<const char *>(newline) - buffer : end;
+        line.append(buffer + pos, stop - pos);
+        pos = stop;
+        if (newline) {
+            pos++;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return true;
+        }
+    }
+}
+
+bool FdReader::readBytes(uint8_t *out, size_t size) {
+    while (size > 0) {
+        if (pos == end && !fill()) return false;
+        size_t count = std::min(size, end - pos);
+        std::memcpy(out, buffer + pos, count);
+        out += count;
+        pos += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool FdReader::fill() {
+    ssize_t count;
+    do {
+        count = ::read(fd, buffer, sizeof(buffer));
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) return false;
+    pos = 0;
+    end = static_cast<size_t>(count);
+    return true;
+}
+
+int connectDecodeServer(const std::string &socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) return -1;
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socketPath.c_str());
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool sendDecodeRequest(int fd, FdReader &reader, const std::string &requestLine, const std::vector<uint8_t> *inlineData,
+                       std::string &statusLine, std::vector<uint8_t> &payload) {
+    std::string line = requestLine + "\n";
+    if (!writeAll(fd, line.data(), line.size())) return false;
+    if (inlineData && !writeAll(fd, inlineData->data(), inlineData->size())) return false;
+    if (!reader.readLine(statusLine)) return false;
+
+    // ok <宽> <高> <通道数> <字节数>：字节数是纯数字时后面跟着像素
+    payload.clear();
+    std::istringstream fields(statusLine);
+    std::string ok, last;
+    int width, height, channels;
+    if (!(fields >> ok >> width >> height >> channels >> last) || ok != "ok") return true;
+    if (last.find_first_not_of("0123456789") != std::string::npos) return true;
+    payload.resize(std::stoull(last));
+    return reader.readBytes(payload.data(), payload.size());
+}
+
+std::string decodeCacheOptions(const DecodeRequest &request) {
+    std::ostringstream options;
+    if (request.scale > 1) options << "scale=" << request.scale << " ";
+    if (request.crop) {
+        options << "crop=" << request.cropX << "," << request.cropY << "," << request.cropWidth << ","
+                << request.cropHeight << " ";
+    }
+    if (request.lumaOnly) options << "luma ";
+    options << (request.bmpFormat || !request.outputPath.empty() ? "format=bmp" : "format=rgb");
+    return options.str();
+}
+
+bool resolveServerPath(const std::string &root, const std::string &path, std::string &resolved, std::string &error) {
+    if (root.empty()) {
+        error = "paths disabled";
+        return false;
+    }
+    // 已存在的部分（含末尾的符号链接）解析为真实路径，再检查是否仍在根目录之内
+    std::error_code ec;
+    std::filesystem::path base = std::filesystem::canonical(root, ec);
+    std::filesystem::path target = ec ? base : std::filesystem::weakly_canonical(base / path, ec);
+    std::filesystem::path relative = target.lexically_relative(base);
+    if (ec || relative.empty() || relative == "." || *relative.begin() == "..") {
+        error = "path outside root " + path;
+        return false;
+    }
+    resolved = target.string();
+    return true;
+}
+
+std::shared_ptr<const CachedImage> decodeRequestImage(const DecodeRequest &request, DecodeWorkerBuffers &buffers,
+                                                      DecodeCache *cache, std::string &error,
+                                                      const DecodeLimits &limits) {
+    if (!request.path.empty()) {
+        std::string path;
+        if (!resolveServerPath(limits.rootDirectory, request.path, path, error)) return nullptr;
+        bool tooLarge = false;
+        if (!readFile(path, buffers.input, limits.maxInputBytes, tooLarge)) {
+            error = tooLarge ? "file too large " + request.path : "cannot read " + request.path;
+            return nullptr;
+        }
+    }
+    if (!cache) return decodeImage(request, buffers, limits, error);
+
+    DecodeCacheKey key = makeDecodeCacheKey(buffers.input.data(), buffers.input.size(), decodeCacheOptions(request));
+    std::shared_ptr<const CachedImage> image = cache->lookup(key);
+    if (!image) {
+        image = decodeImage(request, buffers, limits, error);
+        if (image) cache->insert(key, image);  // 解码失败不缓存
+    }
+    return image;
+}
+
+bool parseDecodeRequest(const std::string &line, DecodeRequest &request, std::string &error) {
+    request = DecodeRequest();
+    std::istringstream fields(line);
+    std::string command, source;
+    fields >> command >> source;
+    if (command != "decode" || source.empty()) {
+        error = "unknown request";
+        return false;
+    }
+    if (source == "-") {
+        long long size = -1;
+        if (!(fields >> size) || size <= 0) {
+            error = "missing inline size";
+            return false;
+        }
+        request.inlineSize = static_cast<size_t>(size);
+    } else {
+        request.path = source;
+    }
+
+    std::string option;
+    while (fields >> option) {
+        if (option == "luma") {
+            request.lumaOnly = true;
+        } else if (option.rfind("crop=", 0) == 0) {
+            request.crop = std::sscanf(option.c_str() + 5, "%d,%d,%d,%d", &request.cropX, &request.cropY,
+                                       &request.cropWidth, &request.cropHeight) == 4;
+            if (!request.crop) {
+                error = "invalid crop";
+                return false;
+            }
+        } else if (option.rfind("scale=", 0) == 0) {
+            std::vector<int> scales;
+            if (!parsePyramidScales(option.substr(6), scales) || scales.size() != 1) {
+                error = "invalid scale";
+                return false;
+            }
+            request.scale = scales[0];
+        } else if (option == "format=rgb") {
+            request.bmpFormat = false;
+        } else if (option == "format=bmp") {
+            request.bmpFormat = true;
+        } else if (option.rfind("out=", 0) == 0 && option.size() > 4) {
+            request.outputPath = option.substr(4);
+        } else {
+            error = "unknown option " + option;
+            return false;
+        }
+    }
+    if (request.crop && request.scale > 1) {
+        error = "crop and scale cannot be combined";
+        return false;
+    }
+    return true;
+}
+
+bool serveDecodeRequest(FdReader &reader, int outFd, DecodeWorkerBuffers &buffers, DecodeCache *cache,
+                        const DecodeLimits &limits) {
+    auto sendError = [&](const std::string &message) {
+        std::string text = "error " + message + "\n";
+        return writeAll(outFd, text.data(), text.size());
+    };
+    std::string line;
+    do {
+        if (!reader.readLine(line)) return false;
+    } while (line.empty());
+    if (line == "ping") return writeAll(outFd, "ok\n", 3);
+
+    DecodeRequest request;
+    std::string error;
+    if (!parseDecodeRequest(line, request, error)) {
+        // 无法确定后面是否跟着 JPEG 数据，只能关闭连接
+        return sendError(error) && line.rfind("decode - ", 0) != 0;
+    }
+    // 不读取过大的数据，同样只能关闭连接
+    if (request.path.empty() && request.inlineSize > limits.maxInputBytes) {
+        sendError("inline data too large");
+        return false;
+    }
+    TraceScope trace("request");
+    try {
+        if (request.path.empty()) {
+            buffers.input.resize(request.inlineSize);
+            if (!reader.readBytes(buffers.input.data(), buffers.input.size())) return false;
+        }
+        handleDecode(request, buffers, cache, limits);
+    } catch (const std::bad_alloc &) {
+        // 释放常驻缓冲区，后续请求重新分配；数据未读完时关闭连接
+        bool dataPending = request.path.empty() && buffers.input.size() != request.inlineSize;
+        buffers = DecodeWorkerBuffers();
+        return sendError("out of memory") && !dataPending;
+    }
+    return writeAll(outFd, buffers.response.data(), buffers.response.size());
+}
+
+void serveDecodeConnection(int inFd, int outFd, DecodeWorkerBuffers &buffers, DecodeCache *cache,
+                           const DecodeLimits &limits) {
+    FdReader reader(inFd);
+    while (serveDecodeRequest(reader, outFd, buffers, cache, limits)) {
+    }
+}
+
+// 一个客户端连接：FdReader 中可能已缓冲了下一个请求，因此随连接一起在线程之间传递
+struct ServerConnection {
+    explicit ServerConnection(int fd) : fd(fd), reader(fd) {}
+    ~ServerConnection() { ::close(fd); }
+    int fd;
+    FdReader reader;
+};
+
+DecodeServer::~DecodeServer() {
+    if (listenFd >= 0) ::close(listenFd);
+    for (int fd : wakeFds) {
+        if (fd >= 0) ::close(fd);
+    }
+    if (!path.empty()) ::unlink(path.c_str());
+}
+
+bool DecodeServer::listen(const std::string &socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) return false;
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+    ::unlink(socketPath.c_str());
+    // 套接字文件在 bind 时按 umask 创建：临时收紧 umask，使其权限为 0600，其他用户无法连接
+    mode_t mask = ::umask(0177);
+    bool bound = ::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+    ::umask(mask);
+    if (!bound || ::listen(listenFd, 64) < 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    path = socketPath;
+    return true;
+}
+
+void DecodeServer::finishRequest(ServerConnection *connection, bool keepOpen) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!keepOpen || stopping) {
+        delete connection;
+    } else if (connection->reader.hasBufferedData()) {
+        // 下一个请求已在缓冲区中，poll 不会再报告可读，直接排到队尾
+        ready.push_back(connection);
+        connectionReady.notify_one();
+    } else {
+        returned.push_back(connection);
+        wakePoll(wakeFds[1]);
+    }
+}
+
+void DecodeServer::run(int threadCount, DecodeCache *cache, const DecodeLimits &limits) {
+    // 客户端提前断开时 write 返回错误而不是终止进程
+    std::signal(SIGPIPE, SIG_IGN);
+    if (::pipe(wakeFds) < 0) return;
+    ::fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::max(threadCount, 1); ++i) {
+        workers.emplace_back([this, i, cache, &limits]() {
+            setTraceThreadName("server worker " + std::to_string(i));
+            DecodeWorkerBuffers buffers;  // 整个线程生命周期内复用
+            while (true) {
+                ServerConnection *connection;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    connectionReady.wait(lock, [this]() { return !ready.empty() || stopping; });
+                    if (ready.empty()) return;
+                    connection = ready.front();
+                    ready.pop_front();
+                }
+                bool keepOpen = serveDecodeRequest(connection->reader, connection->fd, buffers, cache, limits);
+                finishRequest(connection, keepOpen);
+            }
+        });
+    }
+
+    // 主线程 poll 监听套接字、唤醒管道与所有空闲连接；连接可读（或对端关闭）时移入 ready
+    std::vector<ServerConnection *> idle;
+    std::vector<pollfd> fds;
+    timeval timeout{IO_TIMEOUT_SECONDS, 0};
+    while (!stopping) {
+        fds.assign({{listenFd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}});
+        for (ServerConnection *connection : idle) fds.push_back({connection->fd, POLLIN, 0});
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<ServerConnection *> stillIdle;
+        for (size_t i = 0; i < idle.size(); ++i) {
+            if (fds[i + 2].revents) {
+                ready.push_back(idle[i]);
+                connectionReady.notify_one();
+            } else {
+                stillIdle.push_back(idle[i]);
+            }
+        }
+        idle.swap(stillIdle);
+        if (fds[1].revents) {
+            char bytes[256];
+            while (::read(wakeFds[0], bytes, sizeof(bytes)) > 0) {
+            }
+            idle.insert(idle.end(), returned.begin(), returned.end());
+            returned.clear();
+        }
+        if (fds[0].revents) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                break;  // stop() 关闭了监听套接字
+            }
+            // 请求读到一半或响应写不出去时不无限期占住工作线程
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            idle.push_back(new ServerConnection(fd));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (ServerConnection *connection : ready) delete connection;
+        ready.clear();
+    }
+    connectionReady.notify_all();
+    for (std::thread &worker : workers) worker.join();
+    // 工作线程退出后不会再交还连接
+    for (ServerConnection *connection : idle) delete connection;
+    for (ServerConnection *connection : returned) delete connection;
+    returned.clear();
+}
+
+void DecodeServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    connectionReady.notify_all();
+    if (listenFd >= 0) ::shutdown(listenFd, SHUT_RDWR);
+    if (wakeFds[1] >= 0) wakePoll(wakeFds[1]);
+}
@@ -0,0 +1,182 @@
+#include "decode_trace.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> decode_trace::enabled{false};
+
+namespace {
+struct TraceEvent {
+    const char *name;
+    int arg;
+    uint64_t beginNs;
+    uint64_t endNs;
+};
+
+// 每个线程最多保留的事件数，超出后丢弃新事件（长时间运行的 --serve --trace 不会无限增长）
+constexpr size_t MAX_EVENTS_PER_THREAD = size_t(1) << 18;
+
+// 只有所属线程追加事件；startDecodeTrace / writeDecodeTrace 在其他线程中清空或读取，
+// 与追加之间用每个缓冲区自己的锁同步（几乎总是无竞争的，不同线程记录时互不阻塞）
+struct ThreadBuffer {
+    int tid = 0;
+    std::string name;
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t dropped = 0;
+    bool exited = false;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    int nextTid = 1;
+    uint64_t startNs = 0;
+};
+
+TraceRegistry &registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+// 线程第一次记录时注册缓冲区（唯一需要加锁的地方），线程退出时标记，下次 start 时回收。
+// 追踪关闭时只命名、不记录的线程不注册，名字先存在线程本地，注册时再写入
+struct LocalBuffer {
+    ThreadBuffer *buffer = nullptr;
+    std::string name;
+    ~LocalBuffer() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffer->exited = true;
+    }
+    ThreadBuffer &get() {
+        if (!buffer) {
+            TraceRegistry &traces = registry();
+            std::lock_guard<std::mutex> lock(traces.mutex);
+            traces.buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = traces.buffers.back().get();
+            buffer->tid = traces.nextTid++;
+            buffer->name = name;
+            buffer->events.reserve(4096);
+        }
+        return *buffer;
+    }
+};
+
+thread_local LocalBuffer localBuffer;
+
+void writeJsonString(std::ostream &out, const std::string &text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec
+                << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+} // namespace
+
+void decode_trace::record(const char *name, int arg, uint64_t beginNs, uint64_t endNs) {
+    ThreadBuffer &buffer = localBuffer.get();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() < MAX_EVENTS_PER_THREAD) {
+        buffer.events.push_back({name, arg, beginNs, endNs});
+    } else {
+        buffer.dropped++;
+    }
+}
+
+void startDecodeTrace() {
+    TraceRegistry &traces = registry();
+    {
+        std::lock_guard<std::mutex> lock(traces.mutex);
+        auto &buffers = traces.buffers;
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                     [](const std::unique_ptr<ThreadBuffer> &buffer) { return buffer->exited; }),
+                      buffers.end());
+        for (auto &buffer : buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+        traces.startNs = decode_trace::nowNs();
+    }
+    decode_trace::enabled.store(true, std::memory_order_release);
+}
+
+void stopDecodeTrace() {
+    decode_trace::enabled.store(false, std::memory_order_release);
+}
+
+void setTraceThreadName(const std::string &name) {
+    localBuffer.name = name;
+    if (!localBuffer.buffer) return;
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    localBuffer.buffer->name = name;
+}
+
+size_t decodeTraceEventCount() {
+    TraceRegistry &traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    size_t count = 0;
+    for (const auto &buffer : traces.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+// 每个事件输出为 "X"（完整事件，开始时间 + 时长），时间单位为微秒，从 startDecodeTrace 起算
+void writeDecodeTrace(std::ostream &out) {
+    TraceRegistry &traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    size_t dropped = 0;
+    for (const auto &buffer : traces.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        dropped += buffer->dropped;
+        if (buffer->events.empty()) continue;
+        if (!buffer->name.empty()) {
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+            writeJsonString(out, buffer->name);
+            out << "}}";
+        }
+        for (const TraceEvent &event : buffer->events) {
+            separator();
+            double begin = (static_cast<double>(event.beginNs) - static_cast<double>(traces.startNs)) / 1000.0;
+            double duration = static_cast<double>(event.endNs - event.beginNs) / 1000.0;
+            out << "{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"ts\":" << begin << ",\"dur\":" << duration;
+            if (event.arg >= 0) out << ",\"args\":{\"n\":" << event.arg << "}";
+            out << "}";
+        }
+    }
+    out << "\n],\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool writeDecodeTrace(const std::string &filename) {
+    std::ofstream file(filename);
+    if (!file) return false;
+    writeDecodeTrace(file);
+    return static_cast<bool>(file);
+}
@@ -1,169 +1,327 @@
 #include "huffman_decoder.h"
+#include "decode_trace.h"
 #include <iostream>
 #include <bitset>
 #include <algorithm>
-#include <cstdlib>
 #include <unordered_map>
 
-// 查找哈夫曼符号
-int decodeHuffmanDC(BitStreamReader &reader, const HuffmanTable &dcTable) {
+const char *decodeStatusMessage(DecodeStatus status) {
+    switch (status) {
+    case DecodeStatus::Ok:
+        return "ok";
+    case DecodeStatus::Truncated:
+        return "比特流提前结束";
+    case DecodeStatus::InvalidCode:
+        return "无效的哈夫曼码";
+    case DecodeStatus::MissingTable:
+        return "缺少哈夫曼表";
+    case DecodeStatus::PrematureMarker:
+        return "扫描数据中出现提前的标记";
+    case DecodeStatus::InvalidHeader:
+        return "文件头无效";
+    case DecodeStatus::UnsupportedSampling:
+        return "不支持的采样方式";
+    }
+    return "unknown";
+}
+
+const char *huffmanDecodeModeName(HuffmanDecodeMode mode) {
+    switch (mode) {
+    case HuffmanDecodeMode::BitSerial: return "bit-serial";
+    case HuffmanDecodeMode::SingleSymbol: return "single-symbol";
+    case HuffmanDecodeMode::MultiSymbol: return "multi-symbol";
+    }
+    return "?";
+}
+
+static int extendMagnitude(int value, int size) {
+    // 如果值位于负数区间，转换为负值
+    if (value < (1 << (size - 1))) {
+        value -= (1 << size) - 1;
+    }
+    return value;
+}
+
+// 码长不超过 HUFFMAN_LOOKUP_BITS 的码字展开到以其为前缀的所有表项；按码长从短到长填充且不覆盖，
+// 与逐位匹配时短码优先的结果一致（损坏的表中码字可能重叠）
+void buildHuffmanLookup(HuffmanTable &table) {
+    const int tableSize = 1 << HUFFMAN_LOOKUP_BITS;
+    table.lookup.assign(tableSize, 0);
+    for (int length = 1; length <= HUFFMAN_LOOKUP_BITS; ++length) {
+        auto lengthMap = table.huffmanCodesByLength.find(length);
+        if (lengthMap == table.huffmanCodesByLength.end()) continue;
+        for (const auto &entry : lengthMap->second) {
+            if (entry.first >= (1 << length)) continue;  // 溢出的码字逐位解码时也永远匹配不到
+            int shift = HUFFMAN_LOOKUP_BITS - length;
+            for (int i = entry.first << shift; i < (entry.first + 1) << shift; ++i) {
+                if (table.lookup[i] == 0) table.lookup[i] = static_cast<uint16_t>((entry.second << 8) | length);
+            }
+        }
+    }
+
+    // 多符号表：在预读窗口内依次解析“码字 + 幅值位”，AC 表最多两项，DC 表一项
+    bool ac = table.tableClass == 1;
+    table.fastEntries.assign(tableSize, HuffmanFastEntry());
+    for (int window = 0; window < tableSize; ++window) {
+        HuffmanFastEntry &fast = table.fastEntries[window];
+        int pos = 0;
+        for (int item = 0; item < (ac ? 2 : 1); ++item) {
+            uint16_t code = table.lookup[(window << pos) & (tableSize - 1)];
+            int length = code & 0xFF;
+            if (code == 0 || pos + length > HUFFMAN_LOOKUP_BITS) break;
+            int symbol = code >> 8;
+            if (ac && symbol == 0) {
+                fast.bits[item] = static_cast<uint8_t>(pos + length);
+                fast.items++;
+                fast.endOfBlock = true;
+                break;
+            }
+            int size = ac ? symbol & 0xF : symbol;
+            if (pos + length + size > HUFFMAN_LOOKUP_BITS) break;
+            pos += length + size;
+            int value = size ? extendMagnitude((window >> (HUFFMAN_LOOKUP_BITS - pos)) & ((1 << size) - 1), size) : 0;
+            fast.value[item] = static_cast<int16_t>(value);
+            fast.run[item] = static_cast<uint8_t>(ac ? symbol >> 4 : 0);
+            fast.bits[item] = static_cast<uint8_t>(pos);
+            fast.items++;
+        }
+    }
+}
+
+// 逐位累积码字并在对应长度的码表中匹配
+static int bitSerialSymbol(BitStreamReader &reader, const HuffmanTable &table) {
     int code = 0;
-    std::vector<int> codeHistory;  // 记录每一步的 code 值
 
-    // 尝试匹配哈夫曼码
     for (int length = 1; length <= 16; ++length) {
         int bit = reader.readBit();
         if (bit == -1) {
-            std::cerr << "DC 解码错误：读取比特流失败。" << std::endl;
-            std::exit(EXIT_FAILURE);
+            return HUFFMAN_TRUNCATED;
         }
 
         code = (code << 1) | bit;  // 累积构建当前码字
-        codeHistory.push_back(code);  // 记录当前 code 值
 
         // 在当前长度的哈夫曼表中查找匹配的码字
-        auto lengthMap = dcTable.huffmanCodesByLength.find(length);
-        if (lengthMap != dcTable.huffmanCodesByLength.end()) {
+        auto lengthMap = table.huffmanCodesByLength.find(length);
+        if (lengthMap != table.huffmanCodesByLength.end()) {
             auto it = lengthMap->second.find(code);
             if (it != lengthMap->second.end()) {
-                int symbol = it->second;  // 获取匹配到的符号
-                // std::cout << "匹配成功: Code = " << code << ", Symbol = " << symbol << std::endl;
-
-                if (symbol == 0) return 0;  // symbol 为 0，DC 值也是 0
-
-                // 根据 symbol 值读取附加的比特位数
-                int additionalBits = reader.readBits(symbol);
-                if (additionalBits < (1 << (symbol - 1))) {
-                    additionalBits -= (1 << symbol) - 1;  // 将其转换为负值
-                }
-                return additionalBits;  // 返回实际 DC 值
+                return it->second;  // 获取匹配到的符号
             }
         }
     }
 
-    // 如果未找到有效符号，回退指针并输出每一步的 code
-    std::cerr << "DC 解码错误：未找到有效符号。" << std::endl;
-    std::cerr << "解码过程中的 code 值：" << std::endl;
-    for (size_t i = 0; i < codeHistory.size(); ++i) {
-        std::cerr << "Step " << (i + 1) << ": Code = " << codeHistory[i] << std::endl;
+    return HUFFMAN_INVALID_CODE;
+}
+
+// 查找哈夫曼符号：短码预读查表，长码或数据末尾不足一个预读窗口时逐位匹配
+// 成功返回符号，比特流耗尽返回 HUFFMAN_TRUNCATED，16 位内无匹配返回 HUFFMAN_INVALID_CODE
+int getHuffmanSymbol(BitStreamReader &reader, const HuffmanTable &table, HuffmanDecodeMode mode) {
+    if (mode != HuffmanDecodeMode::BitSerial && !table.lookup.empty()) {
+        uint16_t code = table.lookup[reader.peekBits(HUFFMAN_LOOKUP_BITS)];
+        size_t length = code & 0xFF;
+        if (code != 0 && length <= reader.bitsRemaining()) {
+            reader.skipBits(static_cast<int>(length));
+            return code >> 8;
+        }
     }
+    return bitSerialSymbol(reader, table);
+}
 
-    std::exit(EXIT_FAILURE);
+// 将 JPEG 幅值编码（size 位附加比特）还原为有符号值，读取失败返回 false
+static bool readMagnitude(BitStreamReader &reader, int size, int &value) {
+    value = 0;
+    if (size == 0) return true;
+
+    value = reader.readBits(size);
+    if (value < 0) return false;
+    value = extendMagnitude(value, size);
+    return true;
 }
 
+static DecodeStatus symbolStatus(int symbol) {
+    return symbol == HUFFMAN_TRUNCATED ? DecodeStatus::Truncated : DecodeStatus::InvalidCode;
+}
 
-void decodeHuffmanAC(BitStreamReader &reader, const HuffmanTable &acTable, int *block) {
-    int index = 1;  // AC 系数从索引 1 开始，因为 0 是 DC 系数
+// 解码 DC 差分值
+DecodeStatus decodeHuffmanDC(BitStreamReader &reader, const HuffmanTable &dcTable, int &dcDiff,
+                             HuffmanDecodeMode mode) {
+    if (mode == HuffmanDecodeMode::MultiSymbol && !dcTable.fastEntries.empty()) {
+        const HuffmanFastEntry &fast = dcTable.fastEntries[reader.peekBits(HUFFMAN_LOOKUP_BITS)];
+        if (fast.items != 0 && fast.bits[0] <= reader.bitsRemaining()) {
+            reader.skipBits(fast.bits[0]);
+            dcDiff = fast.value[0];
+            return DecodeStatus::Ok;
+        }
+    }
 
-    while (index < 64) {
-        int code = 0;
-
-        // 逐位累积并匹配码字
-        for (int length = 1; length <= 16; ++length) {
-            int bit = reader.readBit();
-            if (bit == -1) {
-                std::cerr << "AC 解码错误：读取比特流失败。" << std::endl;
-                std::exit(EXIT_FAILURE);
-            }
+    int symbol = getHuffmanSymbol(reader, dcTable, mode);
+    if (symbol < 0) return symbolStatus(symbol);
 
-            code = (code << 1) | bit;  // 累积构建当前码字
-
-            // 在当前长度的哈夫曼表中查找匹配的码字
-            auto lengthMap = acTable.huffmanCodesByLength.find(length);
-            if (lengthMap != acTable.huffmanCodesByLength.end()) {
-                auto it = lengthMap->second.find(code);
-                if (it != lengthMap->second.end()) {
-                    int symbol = it->second;  // 获取匹配到的符号
-
-                    if (symbol == 0) {  // EOB 符号，填充剩余位置为 0
-                        while (index < 64) block[index++] = 0;
-                        return;
-                    }
-
-                    // 解析 symbol 的高 4 位为 runLength，低 4 位为 size
-                    int runLength = (symbol >> 4) & 0xF;
-                    int size = symbol & 0xF;
-
-                    // 跳过指定的零游程
-                    index += runLength;
-                    if (index >= 64) return;  // 超出范围则结束
-
-                    int acValue = 0;
-                    if (size > 0) {
-                        acValue = reader.readBits(size);  // 读取 size 位的值
-                        // 如果值位于负数区间，转换为负值
-                        if (acValue < (1 << (size - 1))) {
-                            acValue -= (1 << size) - 1;
-                        }
-                    }
-
-                    block[index++] = acValue;  // 将解码后的 AC 值放入块中
-                    break;
-                }
+    // 根据 symbol 值读取附加的比特位数，symbol 为 0 时 DC 差分也是 0
+    if (!readMagnitude(reader, symbol, dcDiff)) return DecodeStatus::Truncated;
+    return DecodeStatus::Ok;
+}
+
+// 多符号解码一次查表：处理了至少一个符号返回 true（done 表示遇到 EOB），否则由调用方逐符号解码。
+// 码字、幅值位超出剩余数据，或零游程越过块尾（逐符号解码时不读幅值位）的情况都交给逐符号路径
+static bool decodeAcFast(BitStreamReader &reader, const HuffmanTable &acTable, Coefficient *block, int &index,
+                         bool &done) {
+    const HuffmanFastEntry &fast = acTable.fastEntries[reader.peekBits(HUFFMAN_LOOKUP_BITS)];
+    size_t remaining = reader.bitsRemaining();
+    if (fast.items == 0 || fast.bits[0] > remaining) return false;
+
+    if (fast.endOfBlock && fast.items == 1) {
+        reader.skipBits(fast.bits[0]);
+        while (index < 64) block[index++] = 0;
+        done = true;
+        return true;
+    }
+    if (index + fast.run[0] >= 64) return false;
+    index += fast.run[0];
+    block[index++] = fast.value[0];
+    int consumed = fast.bits[0];
+
+    if (fast.items == 2 && fast.bits[1] <= remaining) {
+        if (fast.endOfBlock) {
+            if (index < 64) {
+                reader.skipBits(fast.bits[1]);
+                while (index < 64) block[index++] = 0;
+                done = true;
+                return true;
             }
+        } else if (index + fast.run[1] < 64) {
+            index += fast.run[1];
+            block[index++] = fast.value[1];
+            consumed = fast.bits[1];
         }
     }
+    reader.skipBits(consumed);
+    return true;
 }
 
-// huffmanDecode 整体实现
-void huffmanDecode(const std::vector<uint8_t> &compressedData, ImageData &imgData) {
-    BitStreamReader reader(compressedData);
-    // 对于每个 MCU 单元，逐块解码，暂时不做累加
-    int previousDcY = 0, previousDcCr = 0, previousDcCb = 0;
-    for (int mcu = 0; mcu < imgData.totalBlocks; ++mcu) {
-        // 解码 4 个 Y 块
-        for (int yBlock = 0; yBlock < 4; ++yBlock) {
-            int blockIndex = mcu * 4 + yBlock;
-            // 获取 DC 和 AC 哈夫曼表
-            const HuffmanTable* dcTableY = imgData.getHuffmanTable(0, imgData.dcTableIds[0]);
-            const HuffmanTable* acTableY = imgData.getHuffmanTable(1, imgData.acTableIds[0]);
-
-            if (!dcTableY || !acTableY) {
-                std::cerr << "Error: Huffman table for Y component not found." << std::endl;
-                return;
-            }
+DecodeStatus decodeHuffmanAC(BitStreamReader &reader, const HuffmanTable &acTable, Coefficient *block,
+                             HuffmanDecodeMode mode) {
+    int index = 1;  // AC 系数从索引 1 开始，因为 0 是 DC 系数
+    bool multiSymbol = mode == HuffmanDecodeMode::MultiSymbol && !acTable.fastEntries.empty();
 
-            // 解码 DC 系数并暂存差分值
-            int dcCoefficient = decodeHuffmanDC(reader, *dcTableY);
-            imgData.Y[blockIndex][0] = dcCoefficient + previousDcY; // 暂存差分值，不进行累加
-            previousDcY = imgData.Y[blockIndex][0];
-            // 解码 AC 系数并填充到块中
-            decodeHuffmanAC(reader, *acTableY, &imgData.Y[blockIndex][0]);
+    while (index < 64) {
+        bool done = false;
+        if (multiSymbol && decodeAcFast(reader, acTable, block, index, done)) {
+            if (done) return DecodeStatus::Ok;
+            continue;
         }
 
-        // 解码 Cr 块
-        const HuffmanTable* dcTableCr = imgData.getHuffmanTable(0, imgData.dcTableIds[1]);
-        const HuffmanTable* acTableCr = imgData.getHuffmanTable(1, imgData.acTableIds[1]);
+        int symbol = getHuffmanSymbol(reader, acTable, mode);
+        if (symbol < 0) return symbolStatus(symbol);
 
-        if (!dcTableCr || !acTableCr) {
-            std::cerr << "Error: Huffman table for Cr component not found." << std::endl;
-            return;
+        if (symbol == 0) {  // EOB 符号，填充剩余位置为 0
+            while (index < 64) block[index++] = 0;
+            return DecodeStatus::Ok;
         }
 
-        // 解码 Cr 的 DC 系数并暂存差分值
-        int dcCoefficientCr = decodeHuffmanDC(reader, *dcTableCr);
-        imgData.Cr[mcu][0] = dcCoefficientCr + previousDcCr; // 暂存差分值
-        previousDcCr = imgData.Cr[mcu][0];
-        // 解码 Cr 的 AC 系数并填充到块中
-        decodeHuffmanAC(reader, *acTableCr, &imgData.Cr[mcu][0]);
+        // 解析 symbol 的高 4 位为 runLength，低 4 位为 size
+        int runLength = (symbol >> 4) & 0xF;
+        int size = symbol & 0xF;
 
-        // 解码 Cb 块
-        const HuffmanTable* dcTableCb = imgData.getHuffmanTable(0, imgData.dcTableIds[2]);
-        const HuffmanTable* acTableCb = imgData.getHuffmanTable(1, imgData.acTableIds[2]);
+        // 跳过指定的零游程
+        index += runLength;
+        if (index >= 64) return DecodeStatus::Ok;  // 超出范围则结束
 
-        if (!dcTableCb || !acTableCb) {
-            std::cerr << "Error: Huffman table for Cb component not found." << std::endl;
-            return;
+        int acValue = 0;
+        if (!readMagnitude(reader, size, acValue)) return DecodeStatus::Truncated;
+
+        block[index++] = static_cast<Coefficient>(acValue);  // size 最多 15 位，不会溢出
+    }
+    return DecodeStatus::Ok;
+}
+
+// 解码一个块：DC 差分累加到预测值上，再解码 AC 系数
+static DecodeStatus decodeBlock(BitStreamReader &reader, const HuffmanTable &dcTable, const HuffmanTable &acTable,
+                                Coefficient *block, int &previousDc, HuffmanDecodeMode mode) {
+    int dcDiff = 0;
+    DecodeStatus status = decodeHuffmanDC(reader, dcTable, dcDiff, mode);
+    if (status != DecodeStatus::Ok) return status;
+
+    // 损坏的数据可能让 DC 累加值超出 16 位
+    block[0] = saturateCoefficient(dcDiff + previousDc);
+    previousDc = block[0];
+    return decodeHuffmanAC(reader, acTable, block, mode);
+}
+
+// 查找各分量使用的哈夫曼表，灰度图像只需要 Y 的表
+DecodeStatus initHuffmanDecodeState(HuffmanDecodeState &state, const ImageData &imgData) {
+    int components = imgData.isGrayscale() ? 1 : 3;
+    for (int c = 0; c < components; ++c) {
+        state.dcTables[c] = imgData.getHuffmanTable(0, imgData.dcTableIds[c]);
+        state.acTables[c] = imgData.getHuffmanTable(1, imgData.acTableIds[c]);
+        if (!state.dcTables[c] || !state.acTables[c]) {
+            return DecodeStatus::MissingTable;
         }
+        state.previousDc[c] = 0;
+    }
+    return DecodeStatus::Ok;
+}
+
+// 解码第 mcu 个 MCU
+// 灰度扫描非交织，每个 MCU 只有一个 8x8 Y 块；彩色扫描依次为 4 个 Y 块、1 个 Cb 块和 1 个 Cr 块
+DecodeStatus decodeMcu(HuffmanDecodeState &state, ImageData &imgData, int mcu) {
+    if (imgData.isGrayscale()) {
+        Coefficient *const blocks[6] = {&imgData.Y[mcu][0], nullptr, nullptr, nullptr, nullptr, nullptr};
+        return decodeMcuBlocks(state, imgData, mcu, blocks);
+    }
+
+    // 仅亮度模式：Cb、Cr 只做熵解码跳过，不存储系数
+    Coefficient *const blocks[6] = {&imgData.Y[mcu * 4][0], &imgData.Y[mcu * 4 + 1][0], &imgData.Y[mcu * 4 + 2][0],
+                                    &imgData.Y[mcu * 4 + 3][0], imgData.lumaOnly ? nullptr : &imgData.Cb[mcu][0],
+                                    imgData.lumaOnly ? nullptr : &imgData.Cr[mcu][0]};
+    return decodeMcuBlocks(state, imgData, mcu, blocks);
+}
+
+DecodeStatus decodeMcuBlocks(HuffmanDecodeState &state, const ImageData &imgData, int mcu,
+                             Coefficient *const blocks[6]) {
+    // 重启间隔边界：编码器已把比特流补齐到整字节并重置 DC 预测值（RSTn 标记已在解析时去掉）
+    if (imgData.restartInterval > 0 && mcu > 0 && mcu % imgData.restartInterval == 0) {
+        state.reader.alignToByte();
+        state.previousDc[0] = state.previousDc[1] = state.previousDc[2] = 0;
+    }
 
-        // 解码 Cb 的 DC 系数并暂存差分值
-        int dcCoefficientCb = decodeHuffmanDC(reader, *dcTableCb);
-        imgData.Cb[mcu][0] = dcCoefficientCb + previousDcCb; // 暂存差分值
-        previousDcCb = imgData.Cb[mcu][0];
-        // 解码 Cb 的 AC 系数并填充到块中
-        decodeHuffmanAC(reader, *acTableCb, &imgData.Cb[mcu][0]);
+    Coefficient scratch[64];
+    if (imgData.isGrayscale()) {
+        return decodeBlock(state.reader, *state.dcTables[0], *state.acTables[0], blocks[0] ? blocks[0] : scratch,
+                           state.previousDc[0], state.mode);
     }
 
-    std::cout << "Huffman Decoding ends" << std::endl;
+    // 扫描中分量顺序为 Y×4、Cb、Cr（JFIF 分量 ID 1、2、3）
+    for (int b = 0; b < 6; ++b) {
+        int component = b < 4 ? 0 : b - 3;
+        DecodeStatus status = decodeBlock(state.reader, *state.dcTables[component], *state.acTables[component],
+                                          blocks[b] ? blocks[b] : scratch, state.previousDc[component], state.mode);
+        if (status != DecodeStatus::Ok) return status;
+    }
+    return DecodeStatus::Ok;
 }
 
+// 解码一整行 MCU
+DecodeStatus decodeMcuRow(HuffmanDecodeState &state, ImageData &imgData, int mcuRow) {
+    TraceScope trace("entropy row", mcuRow);
+    int first = mcuRow * imgData.mcuWidth;
+    for (int mcu = first; mcu < first + imgData.mcuWidth; ++mcu) {
+        DecodeStatus status = decodeMcu(state, imgData, mcu);
+        if (status != DecodeStatus::Ok) return status;
+    }
+    return DecodeStatus::Ok;
+}
+
+// huffmanDecode 整体实现
+DecodeStatus huffmanDecode(const std::vector<uint8_t> &compressedData, ImageData &imgData, HuffmanDecodeMode mode) {
+    HuffmanDecodeState state(compressedData);
+    state.mode = mode;
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    if (status != DecodeStatus::Ok) return status;
+
+    for (int mcuRow = 0; mcuRow < imgData.mcuHeight; ++mcuRow) {
+        status = decodeMcuRow(state, imgData, mcuRow);
+        if (status != DecodeStatus::Ok) return status;
+    }
+    return DecodeStatus::Ok;
+}
@@ -0,0 +1,244 @@
+#include "huffman_optimizer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static int magnitudeBits(int value) {
+    int bits = 0;
+    while (value) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+void countBlockSymbols(const Coefficient *block, int &previousDc, HuffmanStatistics &dcStats, HuffmanStatistics &acStats) {
+    int diff = block[0] - previousDc;
+    previousDc = block[0];
+    dcStats.counts[magnitudeBits(diff < 0 ? -diff : diff)]++;
+
+    int run = 0;
+    for (int k = 1; k < 64; ++k) {
+        int value = block[k];
+        if (value == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {
+            acStats.counts[0xF0]++;
+            run -= 16;
+        }
+        acStats.counts[(run << 4) | magnitudeBits(value < 0 ? -value : value)]++;
+        run = 0;
+    }
+    if (run > 0) acStats.counts[0x00]++;
+}
+
+void buildOptimalHuffmanTable(const HuffmanStatistics &stats, int tableClass, int tableId, HuffmanEncodeTable &table) {
+    // 符号 256 为保留的伪符号（频次 1），保证没有真实符号分到全 1 码字
+    long freq[257];
+    int codeSize[257];
+    int others[257];
+    std::copy(stats.counts, stats.counts + 256, freq);
+    freq[256] = 1;
+    std::fill(codeSize, codeSize + 257, 0);
+    std::fill(others, others + 257, -1);
+
+    // 反复合并频次最小的两棵子树，记录每个符号的码长
+    while (true) {
+        int c1 = -1, c2 = -1;
+        long v1 = 0, v2 = 0;
+        for (int i = 0; i <= 256; ++i) {
+            if (freq[i] && (c1 < 0 || freq[i] <= v1)) {
+                c1 = i;
+                v1 = freq[i];
+            }
+        }
+        for (int i = 0; i <= 256; ++i) {
+            if (freq[i] && i != c1 && (c2 < 0 || freq[i] <= v2)) {
+                c2 = i;
+                v2 = freq[i];
+            }
+        }
+        if (c2 < 0) break;
+
+        freq[c1] += freq[c2];
+        freq[c2] = 0;
+        codeSize[c1]++;
+        while (others[c1] >= 0) {
+            c1 = others[c1];
+            codeSize[c1]++;
+        }
+        others[c1] = c2;
+        codeSize[c2]++;
+        while (others[c2] >= 0) {
+            c2 = others[c2];
+            codeSize[c2]++;
+        }
+    }
+
+    // 各码长的符号个数；257 个符号的哈夫曼树深度不超过 256
+    int bits[257] = {};
+    for (int i = 0; i <= 256; ++i) {
+        if (codeSize[i]) bits[codeSize[i]]++;
+    }
+
+    // 限制码长到 16：把最长的一对符号上移，同时把一个较短的码字拆成两个
+    for (int i = 256; i > 16; --i) {
+        while (bits[i] > 0) {
+            int j = i - 2;
+            while (bits[j] == 0) j--;
+            bits[i] -= 2;
+            bits[i - 1]++;
+            bits[j + 1] += 2;
+            bits[j]--;
+        }
+    }
+    // 去掉伪符号占用的最长码字
+    int longest = 16;
+    while (longest > 0 && bits[longest] == 0) longest--;
+    if (longest > 0) bits[longest]--;
+
+    // 符号按码长排序；码长相同时保持符号顺序
+    std::vector<int> lengths(bits + 1, bits + 17);
+    std::vector<int> symbols;
+    for (int length = 1; length <= 256; ++length) {
+        for (int symbol = 0; symbol < 256; ++symbol) {
+            if (codeSize[symbol] == length) symbols.push_back(symbol);
+        }
+    }
+    buildHuffmanEncodeTable(lengths, symbols, tableClass, tableId, table);
+}
+
+// 依次熵解码每个块（DC 已还原为绝对值），交给 visitor(component, block, newInterval)；
+// component 为 0（Y）、1（Cb）或 2（Cr），newInterval 表示该块是一个重启间隔的第一个块
+template <typename Visitor>
+static DecodeStatus forEachBlock(const ImageData &imgData, Visitor visitor) {
+    HuffmanDecodeState state(imgData.compressedData);
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    if (status != DecodeStatus::Ok) return status;
+
+    int components = imgData.isGrayscale() ? 1 : 3;
+    int blocksPerComponent[3] = {imgData.isGrayscale() ? 1 : 4, 1, 1};
+    Coefficient block[64];
+    for (int mcu = 0; mcu < imgData.totalBlocks; ++mcu) {
+        bool newInterval = mcu == 0;
+        if (imgData.restartInterval > 0 && mcu > 0 && mcu % imgData.restartInterval == 0) {
+            state.reader.alignToByte();
+            state.previousDc[0] = state.previousDc[1] = state.previousDc[2] = 0;
+            newInterval = true;
+        }
+        for (int c = 0; c < components; ++c) {
+            for (int b = 0; b < blocksPerComponent[c]; ++b) {
+                std::memset(block, 0, sizeof(block));
+                int dcDiff = 0;
+                status = decodeHuffmanDC(state.reader, *state.dcTables[c], dcDiff);
+                if (status == DecodeStatus::Ok) status = decodeHuffmanAC(state.reader, *state.acTables[c], block);
+                if (status != DecodeStatus::Ok) return status;
+                block[0] = saturateCoefficient(state.previousDc[c] + dcDiff);
+                state.previousDc[c] = block[0];
+                visitor(c, block, newInterval);
+                newInterval = false;
+            }
+        }
+    }
+    return DecodeStatus::Ok;
+}
+
+// 把原文件中 SOS 之前的标记段（DHT 除外）复制到 out，并取出 SOS 段本身
+static bool copySegmentsBeforeScan(const std::vector<uint8_t> &file, std::vector<uint8_t> &out,
+                                   std::vector<uint8_t> &sosSegment) {
+    if (file.size() < 4 || file[0] != 0xFF || file[1] != SOI) return false;
+    out.insert(out.end(), file.begin(), file.begin() + 2);
+    size_t pos = 2;
+    while (pos + 4 <= file.size()) {
+        if (file[pos] != 0xFF) return false;
+        uint8_t marker = file[pos + 1];
+        if (marker == 0xFF) {  // 填充字节
+            pos++;
+            continue;
+        }
+        size_t length = (static_cast<size_t>(file[pos + 2]) << 8) | file[pos + 3];
+        if (length < 2 || pos + 2 + length > file.size()) return false;
+        auto begin = file.begin() + pos;
+        auto end = begin + 2 + length;
+        if (marker == SOS) {
+            sosSegment.assign(begin, end);
+            return true;
+        }
+        if (marker != DHT) out.insert(out.end(), begin, end);
+        pos += 2 + length;
+    }
+    return false;
+}
+
+OptimizeReport optimizeJPEG(const std::string &inputFile, std::vector<uint8_t> &output) {
+    OptimizeReport report;
+    output.clear();
+
+    std::ifstream file(inputFile, std::ios::binary);
+    std::vector<uint8_t> fileData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    report.inputBytes = fileData.size();
+
+    ImageData imgData = parseJPEGHeader(inputFile, false);
+    std::vector<uint8_t> sosSegment;
+    if (!imgData.width || !imgData.height || !copySegmentsBeforeScan(fileData, output, sosSegment)) {
+        report.status = DecodeStatus::InvalidHeader;
+        return report;
+    }
+    // 解码器只支持灰度与 4:2:0 彩色，其他采样方式无法无损处理
+    if (!imgData.hasSupportedSampling()) {
+        report.status = DecodeStatus::InvalidHeader;
+        return report;
+    }
+    imgData.initializeHuffmanTables();
+    imgData.initializeMcuLayout(imgData.width, imgData.height);
+
+    // 第一遍：统计亮度、色度各自的 DC / AC 符号频次
+    HuffmanStatistics dcStats[2], acStats[2];
+    int previousDc[3] = {0, 0, 0};
+    report.status = forEachBlock(imgData, [&](int component, const Coefficient *block, bool newInterval) {
+        if (newInterval) previousDc[0] = previousDc[1] = previousDc[2] = 0;
+        int table = component == 0 ? 0 : 1;
+        countBlockSymbols(block, previousDc[component], dcStats[table], acStats[table]);
+    });
+    if (report.status != DecodeStatus::Ok) return report;
+
+    int tableCount = imgData.isGrayscale() ? 1 : 2;
+    HuffmanEncodeTable dcTables[2], acTables[2];
+    for (int t = 0; t < tableCount; ++t) {
+        // 表号沿用解码时各分量使用的表号，原 SOS 段中的表选择可以保持不变
+        buildOptimalHuffmanTable(dcStats[t], 0, imgData.dcTableIds[t], dcTables[t]);
+        buildOptimalHuffmanTable(acStats[t], 1, imgData.acTableIds[t], acTables[t]);
+    }
+
+    // 写出新的 DHT（每段一张表）与原 SOS 段
+    for (int t = 0; t < tableCount; ++t) {
+        writeHuffmanTable(output, dcTables[t]);
+        writeHuffmanTable(output, acTables[t]);
+    }
+    output.insert(output.end(), sosSegment.begin(), sosSegment.end());
+
+    // 第二遍：按相同的重启间隔重新编码
+    JpegBitWriter writer(output);
+    int interval = 0;
+    report.status = forEachBlock(imgData, [&](int component, const Coefficient *block, bool newInterval) {
+        if (newInterval) {
+            if (interval > 0) {
+                writer.flush();
+                output.push_back(0xFF);
+                output.push_back(static_cast<uint8_t>(0xD0 + (interval - 1) % 8));  // RSTn
+            }
+            interval++;
+            previousDc[0] = previousDc[1] = previousDc[2] = 0;
+        }
+        int table = component == 0 ? 0 : 1;
+        encodeBlock(writer, block, previousDc[component], dcTables[table], acTables[table]);
+    });
+    if (report.status != DecodeStatus::Ok) return report;
+    writer.flush();
+    output.push_back(0xFF);
+    output.push_back(EOI);
+    report.outputBytes = output.size();
+    return report;
+}
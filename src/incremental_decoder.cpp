@@ -0,0 +1,178 @@
+#include "incremental_decoder.h"
+#include "inverse_dct.h"
+#include "inverse_quantize.h"
+#include "inverse_zigzag.h"
+#include "save_as_bmp.h"
+#include <algorithm>
+#include <cstring>
+
+IncrementalDecoder::IncrementalDecoder(DecodeEventCallback onEvent)
+    : onEvent(std::move(onEvent)), state(imgData.compressedData) {}
+
+DecodeStatus IncrementalDecoder::feed(const uint8_t *data, size_t size) {
+    if (finished) return result;
+    size_t pos = 0;
+    if (!headerParsed) {
+        pos = feedHeader(data, size);
+        if (finished) return result;
+        if (!headerParsed) return DecodeStatus::Ok;
+    }
+    if (!scanEnded) feedScan(data + pos, size - pos);
+    decodeAvailable();
+    return finished ? result : DecodeStatus::Ok;
+}
+
+DecodeStatus IncrementalDecoder::finish() {
+    if (finished) return result;
+    if (!headerParsed) {
+        complete(DecodeStatus::InvalidHeader);
+        return result;
+    }
+    scanEnded = true;
+    decodeAvailable();
+    return result;
+}
+
+// 缓存标记段，SOS 段完整后解析头部；返回本段中属于头部的字节数
+size_t IncrementalDecoder::feedHeader(const uint8_t *data, size_t size) {
+    size_t previous = header.size();
+    header.insert(header.end(), data, data + size);
+
+    if (headerPos == 0) {
+        if (header.size() < 2) return size;
+        if (header[0] != 0xFF || header[1] != SOI) {
+            complete(DecodeStatus::InvalidHeader);
+            return size;
+        }
+        headerPos = 2;
+    }
+
+    while (true) {
+        // 标记前可以有任意个 0xFF 填充字节
+        while (headerPos + 1 < header.size() && header[headerPos] == 0xFF && header[headerPos + 1] == 0xFF) {
+            headerPos++;
+        }
+        if (headerPos + 4 > header.size()) return size;
+        uint8_t marker = header[headerPos + 1];
+        size_t length = (header[headerPos + 2] << 8) | header[headerPos + 3];
+        if (header[headerPos] != 0xFF || marker == SOI || marker == EOI || length < 2) {
+            complete(DecodeStatus::InvalidHeader);
+            return size;
+        }
+        size_t end = headerPos + 2 + length;
+        if (end > header.size()) return size;
+        headerPos = end;
+        if (marker == SOS) break;
+    }
+
+    // SOS 段之后的字节属于扫描数据，交给 feedScan
+    size_t consumed = headerPos - previous;
+    header.resize(headerPos);
+    imgData = parseJPEGMemory(header.data(), header.size());
+    if (!imgData.width || !imgData.height || !imgData.hasSupportedSampling() || !imgData.hasRequiredQuantTables()) {
+        complete(DecodeStatus::InvalidHeader);
+        return size;
+    }
+    imgData.initializeHuffmanTables();
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    if (status != DecodeStatus::Ok) {
+        complete(status);
+        return size;
+    }
+    pixels.assign(static_cast<size_t>(bmpRowSize(imgData)) * imgData.height, 0);
+    headerParsed = true;
+
+    DecodeEvent event;
+    event.type = DecodeEventType::HeaderParsed;
+    onEvent(event);
+    return consumed;
+}
+
+// 去掉填充字节与 RSTn 后追加到 compressedData；返回处理的字节数
+size_t IncrementalDecoder::feedScan(const uint8_t *data, size_t size) {
+    std::vector<uint8_t> &out = imgData.compressedData;
+    size_t pos = 0;
+    while (pos < size) {
+        if (pendingFF) {
+            uint8_t next = data[pos++];
+            if (next == 0xFF) continue;  // 标记前的填充字节
+            pendingFF = false;
+            if (next == 0x00) {
+                out.push_back(0xFF);
+            } else if (next < 0xD0 || next > 0xD7) {
+                // EOI 或其他标记：扫描数据结束
+                imgData.scanEndMarker = next;
+                scanEnded = true;
+                return pos;
+            }
+            continue;
+        }
+        const void *found = std::memchr(data + pos, 0xFF, size - pos);
+        size_t end = found ? static_cast<const uint8_t *>(found) - data : size;
+        out.insert(out.end(), data + pos, data + end);
+        pos = end;
+        if (found) {
+            pendingFF = true;
+            pos++;
+        }
+    }
+    return size;
+}
+
+// 尽量多解码 MCU，每完成一行 MCU 就重建这一行的像素并立即通知
+void IncrementalDecoder::decodeAvailable() {
+    DecodeStatus status = DecodeStatus::Ok;
+    while (nextMcu < imgData.totalBlocks) {
+        size_t bitOffset = state.reader.bitOffset();
+        int previousDc[3];
+        std::copy(state.previousDc, state.previousDc + 3, previousDc);
+
+        status = decodeMcu(state, imgData, nextMcu);
+        if (status == DecodeStatus::Truncated && !scanEnded) {
+            // 数据不够：退回到本 MCU 开始处，清掉已写入的系数，等待更多数据
+            state.reader.seekBit(bitOffset);
+            std::copy(previousDc, previousDc + 3, state.previousDc);
+            int yBlocks = imgData.isGrayscale() ? 1 : 4;
+            for (int b = 0; b < yBlocks; ++b) {
+                std::fill(imgData.Y[nextMcu * yBlocks + b].begin(), imgData.Y[nextMcu * yBlocks + b].end(), 0);
+            }
+            if (imgData.hasChroma()) {
+                std::fill(imgData.Cb[nextMcu].begin(), imgData.Cb[nextMcu].end(), 0);
+                std::fill(imgData.Cr[nextMcu].begin(), imgData.Cr[nextMcu].end(), 0);
+            }
+            status = DecodeStatus::Ok;
+            break;
+        }
+        if (status != DecodeStatus::Ok) break;
+
+        nextMcu++;
+        if (nextMcu % imgData.mcuWidth == 0) {
+            inverseQuantize(imgData, rowsReady, rowsReady + 1);
+            inverseZigZag(imgData, rowsReady, rowsReady + 1);
+            inverseDCT(imgData, rowsReady, rowsReady + 1);
+            fillBMPRows(imgData, rowsReady, rowsReady + 1, pixels);
+            rowsReady++;
+
+            DecodeEvent event;
+            event.type = DecodeEventType::RowsReady;
+            event.mcuRowBegin = rowsReady - 1;
+            event.mcuRowEnd = rowsReady;
+            onEvent(event);
+        }
+    }
+    if (status != DecodeStatus::Ok) {
+        complete(status);
+    } else if (nextMcu == imgData.totalBlocks) {
+        complete(DecodeStatus::Ok);
+    }
+}
+
+void IncrementalDecoder::complete(DecodeStatus status) {
+    finished = true;
+    result = status;
+    DecodeEvent event;
+    event.type = DecodeEventType::Done;
+    event.status = status;
+    onEvent(event);
+}
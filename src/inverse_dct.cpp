@@ -2,31 +2,49 @@
 #include <cmath>
 #include <vector>
 
-const double PI = M_PI;
-const int MAT_SIZE = 8; // 固定为8x8 DCT块
+constexpr double PI = M_PI;
+constexpr int MAT_SIZE = 8; // 固定为8x8 DCT块
 
-double DCT_Mat[MAT_SIZE][MAT_SIZE];
-float DctMapTmp[MAT_SIZE][MAT_SIZE];
+// 编译期余弦：先把角度归约到 [-PI, PI]，再用泰勒级数展开
+constexpr double constexprCos(double x)
+{
+    while (x > PI) x -= 2 * PI;
+    while (x < -PI) x += 2 * PI;
+
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 30; n++)
+    {
+        term *= -x * x / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
 
-// 初始化转换矩阵 A，用于 DCT 和 IDCT
-void InitTransMat()
+struct TransMat
 {
-    int i, j;
-    float a;
+    double v[MAT_SIZE][MAT_SIZE];
+};
 
-    for (i = 0; i < MAT_SIZE; i++)
+// 构造转换矩阵 A，用于 DCT 和 IDCT
+constexpr TransMat makeTransMat()
+{
+    TransMat mat{};
+    for (int i = 0; i < MAT_SIZE; i++)
     {
-        for (j = 0; j < MAT_SIZE; j++)
+        for (int j = 0; j < MAT_SIZE; j++)
         {
-            if (i == 0)
-                a = sqrt(1.0 / MAT_SIZE);
-            else
-                a = sqrt(2.0 / MAT_SIZE);
-            DCT_Mat[i][j] = a * cos((j + 0.5) * PI * i / MAT_SIZE);
+            // sqrt(1/8) 与 sqrt(2/8)
+            double a = (i == 0) ? 0.35355339059327376 : 0.5;
+            mat.v[i][j] = a * constexprCos((j + 0.5) * PI * i / MAT_SIZE);
         }
     }
+    return mat;
 }
 
+// 转换矩阵在编译期计算，只读共享，多线程解码无需同步
+constexpr TransMat DCT_Mat = makeTransMat();
+
 // 执行基于矩阵乘法的逆 DCT，修改为引用传递
 void performInverseDCT(const double (&input)[8][8], double (&output)[8][8]) {
     double temp[8][8] = {0};
@@ -36,7 +54,7 @@ void performInverseDCT(const double (&input)[8][8], double (&output)[8][8]) {
         for (int j = 0; j < MAT_SIZE; j++) {
             double sum = 0.0;
             for (int k = 0; k < MAT_SIZE; k++) {
-                sum += DCT_Mat[k][i] * input[k][j];
+                sum += DCT_Mat.v[k][i] * input[k][j];
             }
             temp[i][j] = sum;
         }
@@ -47,7 +65,7 @@ void performInverseDCT(const double (&input)[8][8], double (&output)[8][8]) {
         for (int j = 0; j < MAT_SIZE; j++) {
             double sum = 0.0;
             for (int k = 0; k < MAT_SIZE; k++) {
-                sum += temp[i][k] * DCT_Mat[k][j];
+                sum += temp[i][k] * DCT_Mat.v[k][j];
             }
             output[i][j] = sum;
         }
@@ -56,32 +74,42 @@ void performInverseDCT(const double (&input)[8][8], double (&output)[8][8]) {
 
 // 对 ImageData 中的 Y、Cr、Cb 数据块执行逆 DCT
 void inverseDCT(ImageData &imgData) {
-    InitTransMat(); // 初始化 DCT 矩阵
-
-    for (int mcu = 0; mcu < imgData.totalBlocks; ++mcu) {
-        for (int yBlock = 0; yBlock < 4; ++yBlock) {
-            int blockIndex = mcu * 4 + yBlock;
-            double temp[8][8], result[8][8];
-
-            // 将 1D Y 数据转换为 2D
-            for (int row = 0; row < 8; ++row) {
-                for (int col = 0; col < 8; ++col) {
-                    temp[row][col] = imgData.Y_blocks_2D[blockIndex][row][col];
-                }
+    inverseDCT(imgData, 0, imgData.mcuHeight);
+}
+
+// 四舍五入并饱和到 16 位（只有损坏的系数才会超出范围）
+static Coefficient roundToCoefficient(double value) {
+    return saturateCoefficient(static_cast<int>(std::round(value)));
+}
+
+// 对 MCU 行 [mcuRowBegin, mcuRowEnd) 执行逆 DCT
+void inverseDCT(ImageData &imgData, int mcuRowBegin, int mcuRowEnd) {
+    int yBegin, yEnd, crCbBegin, crCbEnd;
+    imgData.mcuRowBlockRange(mcuRowBegin, mcuRowEnd, yBegin, yEnd, crCbBegin, crCbEnd);
+
+    for (int blockIndex = yBegin; blockIndex < yEnd; ++blockIndex) {
+        double temp[8][8], result[8][8];
+
+        // 将 1D Y 数据转换为 2D
+        for (int row = 0; row < 8; ++row) {
+            for (int col = 0; col < 8; ++col) {
+                temp[row][col] = imgData.Y_blocks_2D[blockIndex][row][col];
             }
+        }
 
-            // 执行逆 DCT
-            performInverseDCT(temp, result);
+        // 执行逆 DCT
+        performInverseDCT(temp, result);
 
-            // 将结果写回 Y_blocks_2D
-            for (int row = 0; row < 8; ++row) {
-                for (int col = 0; col < 8; ++col) {
-                    imgData.Y_blocks_2D[blockIndex][row][col] = static_cast<int>(std::round(result[row][col]));
-                }
+        // 将结果写回 Y_blocks_2D
+        for (int row = 0; row < 8; ++row) {
+            for (int col = 0; col < 8; ++col) {
+                imgData.Y_blocks_2D[blockIndex][row][col] = roundToCoefficient(result[row][col]);
             }
         }
+    }
 
-        // 对 Cr 和 Cb 块执行逆 DCT
+    // 对 Cr 和 Cb 块执行逆 DCT（灰度或仅亮度模式没有色度块）
+    for (int mcu = crCbBegin; mcu < crCbEnd; ++mcu) {
         double tempCr[8][8], resultCr[8][8];
         double tempCb[8][8], resultCb[8][8];
 
@@ -94,7 +122,7 @@ void inverseDCT(ImageData &imgData) {
         performInverseDCT(tempCr, resultCr);
         for (int row = 0; row < 8; ++row) {
             for (int col = 0; col < 8; ++col) {
-                imgData.Cr_blocks_2D[mcu][row][col] = static_cast<int>(std::round(resultCr[row][col]));
+                imgData.Cr_blocks_2D[mcu][row][col] = roundToCoefficient(resultCr[row][col]);
             }
         }
 
@@ -107,7 +135,7 @@ void inverseDCT(ImageData &imgData) {
         performInverseDCT(tempCb, resultCb);
         for (int row = 0; row < 8; ++row) {
             for (int col = 0; col < 8; ++col) {
-                imgData.Cb_blocks_2D[mcu][row][col] = static_cast<int>(std::round(resultCb[row][col]));
+                imgData.Cb_blocks_2D[mcu][row][col] = roundToCoefficient(resultCb[row][col]);
             }
         }
     }
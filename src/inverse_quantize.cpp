@@ -1,31 +1,130 @@
 #include "inverse_quantize.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#define JPEG_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+const char *dequantizeKernelName(DequantizeKernel kernel) {
+    switch (kernel) {
+    case DequantizeKernel::Auto: return "auto";
+    case DequantizeKernel::Scalar: return "scalar";
+    case DequantizeKernel::Sse2: return "sse2";
+    case DequantizeKernel::Avx2: return "avx2";
+    }
+    return "?";
+}
+
+bool dequantizeKernelSupported(DequantizeKernel kernel) {
+    switch (kernel) {
+    case DequantizeKernel::Auto:
+    case DequantizeKernel::Scalar:
+        return true;
+#ifdef JPEG_X86_KERNELS
+    case DequantizeKernel::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case DequantizeKernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+// 第一次调用时检测一次 CPU
+static DequantizeKernel resolveKernel(DequantizeKernel kernel) {
+    if (kernel != DequantizeKernel::Auto) return kernel;
+    static const DequantizeKernel best = dequantizeKernelSupported(DequantizeKernel::Avx2)   ? DequantizeKernel::Avx2
+                                         : dequantizeKernelSupported(DequantizeKernel::Sse2) ? DequantizeKernel::Sse2
+                                                                                              : DequantizeKernel::Scalar;
+    return best;
+}
+
+void makeDequantizeTable(const std::vector<int> &quantTable, Coefficient table[64]) {
+    for (int i = 0; i < 64; ++i) {
+        table[i] = saturateCoefficient(quantTable[i]);
+    }
+}
+
+static void dequantizeScalar(Coefficient *block, const Coefficient *table) {
+    for (int i = 0; i < 64; ++i) {
+        block[i] = saturateCoefficient(block[i] * table[i]);
+    }
+}
+
+#ifdef JPEG_X86_KERNELS
+// 16 位乘积的低半部分与高半部分交错成 32 位，再饱和打包回 16 位
+__attribute__((target("sse2"))) static void dequantizeSse2(Coefficient *block, const Coefficient *table) {
+    for (int i = 0; i < 64; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i *>(table + i));
+        __m128i lo = _mm_mullo_epi16(a, q);
+        __m128i hi = _mm_mulhi_epi16(a, q);
+        __m128i product = _mm_packs_epi32(_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(block + i), product);
+    }
+}
+
+// unpack 与 packs 都在 128 位通道内进行，两者组合后系数顺序不变
+__attribute__((target("avx2"))) static void dequantizeAvx2(Coefficient *block, const Coefficient *table) {
+    for (int i = 0; i < 64; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+        __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(table + i));
+        __m256i lo = _mm256_mullo_epi16(a, q);
+        __m256i hi = _mm256_mulhi_epi16(a, q);
+        __m256i product = _mm256_packs_epi32(_mm256_unpacklo_epi16(lo, hi), _mm256_unpackhi_epi16(lo, hi));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(block + i), product);
+    }
+}
+#endif
+
+void dequantizeBlock(Coefficient *block, const Coefficient *table, DequantizeKernel kernel) {
+    switch (resolveKernel(kernel)) {
+#ifdef JPEG_X86_KERNELS
+    case DequantizeKernel::Avx2:
+        dequantizeAvx2(block, table);
+        return;
+    case DequantizeKernel::Sse2:
+        dequantizeSse2(block, table);
+        return;
+#endif
+    default:
+        dequantizeScalar(block, table);
+        return;
+    }
+}
+
 // 逆量化：应用量化表
-void inverseQuantize(ImageData &imgData) 
+void inverseQuantize(ImageData &imgData)
 {
-    // 获取量化表
-    const std::vector<int> &quantTableY = imgData.quantizationTables[imgData.yQuantTableId];
-    const std::vector<int> &quantTableCrCb = imgData.quantizationTables[imgData.crCbQuantTableId];
+    inverseQuantize(imgData, 0, imgData.mcuHeight);
+}
+
+// 对 MCU 行 [mcuRowBegin, mcuRowEnd) 逆量化，不同行可在不同线程中并行处理
+void inverseQuantize(ImageData &imgData, int mcuRowBegin, int mcuRowEnd, DequantizeKernel kernel)
+{
+    kernel = resolveKernel(kernel);
+
+    // 获取量化表（只读访问，不能用 operator[] 以免并发插入）
+    alignas(32) Coefficient quantTableY[64];
+    makeDequantizeTable(imgData.quantizationTables.at(imgData.yQuantTableId), quantTableY);
 
+    int yBegin, yEnd, crCbBegin, crCbEnd;
+    imgData.mcuRowBlockRange(mcuRowBegin, mcuRowEnd, yBegin, yEnd, crCbBegin, crCbEnd);
+
+    // 对所有 Y 分量块应用亮度量化表（彩色图像每个 MCU 4 块，灰度图像每个 MCU 1 块）
+    for (int blockIndex = yBegin; blockIndex < yEnd; ++blockIndex)
+    {
+        dequantizeBlock(imgData.Y[blockIndex].data(), quantTableY, kernel);
+    }
 
-    // 对每个 MCU 的 4 个 Y 分量块应用量化表 0
-    for (int mcu = 0; mcu < imgData.totalBlocks; ++mcu) 
+    // 对每个 Cr 和 Cb 分量块应用色度量化表（灰度或仅亮度模式没有色度块）
+    if (crCbBegin == crCbEnd) return;
+    alignas(32) Coefficient quantTableCrCb[64];
+    makeDequantizeTable(imgData.quantizationTables.at(imgData.crCbQuantTableId), quantTableCrCb);
+    for (int mcu = crCbBegin; mcu < crCbEnd; ++mcu)
     {
-        for (int yBlock = 0; yBlock < 4; ++yBlock) 
-        {
-            int blockIndex = mcu * 4 + yBlock; // 每个 MCU 中的第 yBlock 个 Y 块
-            for (int i = 0; i < 64; i ++ )
-            {
-                imgData.Y[blockIndex][i] *= quantTableY[i];
-            }
-        }
-
-        // 对每个 Cr 和 Cb 分量块应用量化表 1
-        // 对 8x8 的 Cr 块进行逐元素逆量化
-        for (int i = 0; i < 64; i ++ )
-        {
-            imgData.Cr[mcu][i] *= quantTableCrCb[i];
-            imgData.Cb[mcu][i] *= quantTableCrCb[i];
-        }
+        dequantizeBlock(imgData.Cr[mcu].data(), quantTableCrCb, kernel);
+        dequantizeBlock(imgData.Cb[mcu].data(), quantTableCrCb, kernel);
     }
 }
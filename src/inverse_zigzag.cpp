@@ -1,6 +1,12 @@
-#include "jpeg_header_parser.h"
+#include "inverse_zigzag.h"
 
 void inverseZigZag(ImageData &imgData)
+{
+    inverseZigZag(imgData, 0, imgData.mcuHeight);
+}
+
+// 对 MCU 行 [mcuRowBegin, mcuRowEnd) 做逆 Zig-Zag
+void inverseZigZag(ImageData &imgData, int mcuRowBegin, int mcuRowEnd)
 {
     // Zig-Zag 索引表
     const int zigzagOrder[8][8] = 
@@ -13,21 +19,24 @@ void inverseZigZag(ImageData &imgData)
     {21, 34, 37, 47, 50, 56, 59, 61},
     {35, 36, 48, 49, 57, 58, 62, 63}};
 
-    for (int mcu = 0; mcu < imgData.totalBlocks; mcu++)
+    int yBegin, yEnd, crCbBegin, crCbEnd;
+    imgData.mcuRowBlockRange(mcuRowBegin, mcuRowEnd, yBegin, yEnd, crCbBegin, crCbEnd);
+
+    for (int blockIndex = yBegin; blockIndex < yEnd; blockIndex++)
     {
-        for (int yBlock = 0; yBlock < 4; yBlock++)
+        for (int row = 0; row < 8; row++)
         {
-            int blockIndex = mcu * 4 + yBlock;
-            for (int row = 0; row < 8; row++)
+            for (int col = 0; col < 8; col++)
             {
-                for (int col = 0; col < 8; col++)
-                {
-                    int Y = imgData.Y[blockIndex][zigzagOrder[row][col]];
-                    imgData.Y_blocks_2D[blockIndex][row][col] = Y;
-                }
+                int Y = imgData.Y[blockIndex][zigzagOrder[row][col]];
+                imgData.Y_blocks_2D[blockIndex][row][col] = Y;
             }
         }
+    }
 
+    // 灰度或仅亮度模式没有色度块，直接跳过
+    for (int mcu = crCbBegin; mcu < crCbEnd; mcu++)
+    {
         for (int row = 0; row < 8; row++)
         {
             for (int col = 0; col < 8; col++)
@@ -0,0 +1,1967 @@
+#include "jpeg_header_parser.h"
+#include "jpeg_decoder.h"
+#include "pipeline_decoder.h"
+#include "speculative_huffman.h"
+#include "inverse_quantize.h"
+#include "save_as_bmp.h"
+#include "pixel_output.h"
+#include "save_as_qoi.h"
+#include "pyramid_decoder.h"
+#include "jpeg_verify.h"
+#include "dct_stats.h"
+#include "dct_transform.h"
+#include "jpeg_encoder.h"
+#include "huffman_optimizer.h"
+#include "mcu_index.h"
+#include "mjpeg_stream.h"
+#include "incremental_decoder.h"
+#include "decode_server.h"
+#include "perf_counters.h"
+#include "decode_trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// 关闭解码过程中的调试输出，只保留计时结果
+struct QuietStdout {
+    std::streambuf *saved;
+    QuietStdout() : saved(std::cout.rdbuf(nullptr)) {}
+    ~QuietStdout() {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+    }
+};
+
+// 解析头部并构建哈夫曼码表，失败时宽高为 0
+static ImageData loadHeader(const std::string &filename) {
+    QuietStdout quiet;
+    ImageData header = parseJPEGHeader(filename);
+    header.initializeHuffmanTables();
+    return header;
+}
+
+// 对已解析头部的图像重复完整解码，返回平均每次耗时（毫秒）
+static double timeDecode(const ImageData &header, bool lumaOnly, int iterations) {
+    QuietStdout quiet;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        ImageData imgData = header;
+        imgData.lumaOnly = lumaOnly;
+        imgData.initializeBlocks(imgData.width, imgData.height);
+        decodeJPEG(imgData, imgData.compressedData);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+// 比较完整解码与仅亮度解码的耗时
+static int benchLuma(const std::string &filename, int iterations) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+
+    double fullMs = timeDecode(header, false, iterations);
+    double lumaMs = timeDecode(header, true, iterations);
+    std::cout << filename << " (" << header.width << "x" << header.height << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << "  full decode: " << fullMs << " ms" << std::endl;
+    std::cout << "  luma only:   " << lumaMs << " ms" << std::endl;
+    std::cout << "  reduction:   " << (1.0 - lumaMs / fullMs) * 100.0 << " %" << std::endl;
+    return 0;
+}
+
+// 解码一份头部的副本，返回状态
+static DecodeStatus decodeCopy(const ImageData &header, ImageData &imgData) {
+    imgData = header;
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    return decodeJPEG(imgData, imgData.compressedData);
+}
+
+static bool sameBlocks(const ImageData &a, const ImageData &b) {
+    return a.Y_blocks_2D == b.Y_blocks_2D && a.Cr_blocks_2D == b.Cr_blocks_2D && a.Cb_blocks_2D == b.Cb_blocks_2D;
+}
+
+// 并发压力测试：多个线程同时解码多幅图像（以及截断的损坏数据），
+// 结果必须与单线程解码逐块一致，损坏数据必须返回错误而不是退出进程。
+// 配合 -DJPEG_ENABLE_TSAN=ON 构建可用 ThreadSanitizer 检查数据竞争。
+static int benchStress(const std::vector<std::string> &filenames, int threadCount, int iterations) {
+    std::vector<ImageData> headers;
+    std::vector<ImageData> references;
+    for (const auto &filename : filenames) {
+        ImageData header = loadHeader(filename);
+        if (!header.width || !header.height) {
+            std::cerr << "解析图像头部失败: " << filename << std::endl;
+            return 1;
+        }
+        ImageData reference;
+        if (decodeCopy(header, reference) != DecodeStatus::Ok) {
+            std::cerr << "单线程解码失败: " << filename << std::endl;
+            return 1;
+        }
+        headers.push_back(header);
+        references.push_back(std::move(reference));
+
+        // 截断后的同一幅图像，用于检验错误路径
+        ImageData truncated = header;
+        truncated.compressedData.resize(truncated.compressedData.size() / 2);
+        headers.push_back(truncated);
+        references.emplace_back();
+    }
+
+    std::atomic<int> mismatches(0);
+    std::atomic<int> unexpectedStatus(0);
+    std::atomic<int> decodes(0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < iterations; ++i) {
+                size_t index = (t + i) % headers.size();
+                bool expectFailure = index % 2 == 1;
+                ImageData imgData;
+                DecodeStatus status = decodeCopy(headers[index], imgData);
+                if (expectFailure) {
+                    if (status == DecodeStatus::Ok) unexpectedStatus++;
+                } else if (status != DecodeStatus::Ok) {
+                    unexpectedStatus++;
+                } else if (!sameBlocks(imgData, references[index])) {
+                    mismatches++;
+                }
+                decodes++;
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << "stress: " << threadCount << " threads, " << decodes << " decodes in " << seconds << " s ("
+              << decodes / seconds << " decodes/s)" << std::endl;
+    std::cout << "  mismatches: " << mismatches << ", unexpected status: " << unexpectedStatus << std::endl;
+    return (mismatches == 0 && unexpectedStatus == 0) ? 0 : 1;
+}
+
+// 比较单线程解码（含颜色转换）与流水线解码的耗时，并检查像素一致
+static int benchPipeline(const std::string &filename, int iterations, int threadCount, int ringDepth) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> serialPixels, pipelinePixels;
+    double serialMs = 0, pipelineMs = 0;
+    for (int i = 0; i < iterations; ++i) {
+        ImageData imgData = header;
+        imgData.initializeBlocks(imgData.width, imgData.height);
+        auto start = std::chrono::steady_clock::now();
+        decodeJPEG(imgData, imgData.compressedData);
+        serialPixels.assign(bmpRowSize(imgData) * imgData.height, 0);
+        fillBMPRows(imgData, 0, imgData.mcuHeight, serialPixels);
+        auto end = std::chrono::steady_clock::now();
+        serialMs += std::chrono::duration<double, std::milli>(end - start).count();
+
+        ImageData pipelined = header;
+        pipelined.initializeMcuLayout(pipelined.width, pipelined.height);
+        start = std::chrono::steady_clock::now();
+        decodeJPEGPipelined(pipelined, pipelined.compressedData, pipelinePixels, threadCount, ringDepth);
+        end = std::chrono::steady_clock::now();
+        pipelineMs += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    serialMs /= iterations;
+    pipelineMs /= iterations;
+
+    std::cout << filename << " (" << header.width << "x" << header.height << ", " << threadCount
+              << " reconstruction threads, ring depth " << ringDepth << ")" << std::endl;
+    std::cout << "  single-threaded: " << serialMs << " ms" << std::endl;
+    std::cout << "  pipelined:       " << pipelineMs << " ms" << std::endl;
+    std::cout << "  speedup:         " << serialMs / pipelineMs << "x" << std::endl;
+    bool identical = serialPixels == pipelinePixels;
+    std::cout << "  output identical: " << (identical ? "yes" : "no") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// 流水线解码在追踪关闭 / 开启时的耗时，以及关闭时单个埋点的开销；最后一次开启追踪的时间线写入 traceFile
+static int benchTrace(const std::string &filename, int iterations, int threadCount, const std::string &traceFile) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> pixelData;
+    auto timePipelined = [&](bool traced) {
+        double ms = 0;
+        for (int i = 0; i < iterations; ++i) {
+            ImageData imgData = header;
+            imgData.initializeMcuLayout(imgData.width, imgData.height);
+            if (traced) startDecodeTrace();
+            auto start = std::chrono::steady_clock::now();
+            decodeJPEGPipelined(imgData, imgData.compressedData, pixelData, threadCount);
+            auto end = std::chrono::steady_clock::now();
+            if (traced) stopDecodeTrace();
+            ms += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        return ms / iterations;
+    };
+    setTraceThreadName("entropy (main)");
+    double offMs = timePipelined(false);
+    double onMs = timePipelined(true);
+    size_t events = decodeTraceEventCount();
+
+    const int scopes = 10000000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < scopes; ++i) {
+        TraceScope trace("disabled", i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double scopeNs = std::chrono::duration<double, std::nano>(end - start).count() / scopes;
+
+    std::cout << filename << " (" << header.width << "x" << header.height << ", " << threadCount
+              << " reconstruction threads)" << std::endl;
+    std::cout << "  tracing off: " << offMs << " ms" << std::endl;
+    std::cout << "  tracing on:  " << onMs << " ms (" << events << " events per decode)" << std::endl;
+    std::cout << "  disabled scope: " << scopeNs << " ns" << std::endl;
+    if (!traceFile.empty()) {
+        if (!writeDecodeTrace(traceFile)) {
+            std::cerr << "无法写入时间线: " << traceFile << std::endl;
+            return 1;
+        }
+        std::cout << "  timeline written to " << traceFile << std::endl;
+    }
+    return 0;
+}
+
+// 比较熵数据校验与完整解码（含颜色转换）的吞吐量
+static int benchVerify(const std::string &filename, int iterations) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+
+    double decodeMs = 0;
+    for (int i = 0; i < iterations; ++i) {
+        ImageData imgData = header;
+        imgData.initializeBlocks(imgData.width, imgData.height);
+        std::vector<uint8_t> pixelData(bmpRowSize(imgData) * imgData.height, 0);
+        auto start = std::chrono::steady_clock::now();
+        decodeJPEG(imgData, imgData.compressedData);
+        fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+        auto end = std::chrono::steady_clock::now();
+        decodeMs += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    decodeMs /= iterations;
+
+    ImageData layout = header;
+    layout.initializeMcuLayout(layout.width, layout.height);
+    VerifyReport report;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        report = verifyEntropyData(layout);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double verifyMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+    double megabytes = header.compressedData.size() / 1e6;
+    std::cout << filename << " (" << header.width << "x" << header.height << ", "
+              << header.compressedData.size() << " bytes of entropy data)" << std::endl;
+    std::cout << "  full decode: " << decodeMs << " ms (" << megabytes / (decodeMs / 1000) << " MB/s)" << std::endl;
+    std::cout << "  verify:      " << verifyMs << " ms (" << megabytes / (verifyMs / 1000) << " MB/s), result: "
+              << decodeStatusMessage(report.status) << std::endl;
+    std::cout << "  verify cost: " << verifyMs / decodeMs * 100.0 << " % of full decode" << std::endl;
+    return report.status == DecodeStatus::Ok ? 0 : 1;
+}
+
+// 比较“完整解码后由像素计算哈希”与“只做熵解码、由 DC 系数计算哈希”
+static int benchPhash(const std::string &filename, int iterations) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+
+    uint64_t pixelHash = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        ImageData imgData = header;
+        imgData.initializeBlocks(imgData.width, imgData.height);
+        decodeJPEG(imgData, imgData.compressedData);
+        std::vector<uint8_t> pixelData(bmpRowSize(imgData) * imgData.height, 0);
+        fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+
+        // BMP 像素自下而上、BGR 排列，转换为自上而下的灰度
+        int rowSize = bmpRowSize(imgData);
+        bool gray = imgData.isGrayscale();
+        std::vector<uint8_t> luma(imgData.width * imgData.height);
+        for (int y = 0; y < imgData.height; ++y) {
+            const uint8_t *src = &pixelData[(imgData.height - 1 - y) * rowSize];
+            for (int x = 0; x < imgData.width; ++x) {
+                luma[y * imgData.width + x] = gray ? src[x]
+                    : static_cast<uint8_t>((29 * src[x * 3] + 150 * src[x * 3 + 1] + 77 * src[x * 3 + 2]) >> 8);
+            }
+        }
+        pixelHash = perceptualHash(luma, imgData.width, imgData.height);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double pixelMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+    DctImageStats stats;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        ImageData imgData = header;
+        imgData.initializeBlocks(imgData.width, imgData.height);
+        decodeDctStats(imgData, stats);
+    }
+    end = std::chrono::steady_clock::now();
+    double dctMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+    std::cout << filename << " (" << header.width << "x" << header.height << ")" << std::endl;
+    std::cout << "  decode + pixel hash: " << pixelMs << " ms, hash " << std::hex << pixelHash << std::dec << std::endl;
+    std::cout << "  DCT-domain stats:    " << dctMs << " ms, hash " << std::hex << stats.perceptualHash << std::dec << std::endl;
+    std::cout << "  hamming distance:    " << hammingDistance(pixelHash, stats.perceptualHash) << std::endl;
+    std::cout << "  speedup:             " << pixelMs / dctMs << "x" << std::endl;
+    return 0;
+}
+
+// 像素域参考实现：对 BMP 像素（自下而上）做同样的几何变换
+static void transformPixels(const std::vector<uint8_t> &src, int width, int height, int channels,
+                            DctTransform transform, std::vector<uint8_t> &dst, int &dstWidth, int &dstHeight) {
+    bool transpose = transform == DctTransform::Transpose || transform == DctTransform::Rotate90 ||
+                     transform == DctTransform::Rotate270;
+    dstWidth = transpose ? height : width;
+    dstHeight = transpose ? width : height;
+    int srcRow = (width * channels + 3) & ~3;
+    int dstRow = (dstWidth * channels + 3) & ~3;
+    dst.assign(dstRow * dstHeight, 0);
+    for (int y = 0; y < dstHeight; ++y) {
+        for (int x = 0; x < dstWidth; ++x) {
+            int sx = x, sy = y;
+            switch (transform) {
+            case DctTransform::FlipHorizontal: sx = width - 1 - x; break;
+            case DctTransform::FlipVertical:   sy = height - 1 - y; break;
+            case DctTransform::Rotate180:      sx = width - 1 - x; sy = height - 1 - y; break;
+            case DctTransform::Transpose:      sx = y; sy = x; break;
+            case DctTransform::Rotate90:       sx = y; sy = height - 1 - x; break;
+            case DctTransform::Rotate270:      sx = width - 1 - y; sy = x; break;
+            default: break;
+            }
+            const uint8_t *from = &src[(height - 1 - sy) * srcRow + sx * channels];
+            uint8_t *to = &dst[(dstHeight - 1 - y) * dstRow + x * channels];
+            std::copy(from, from + channels, to);
+        }
+    }
+}
+
+// 比较“解码后旋转像素”与“DCT 域变换后再重建”的耗时，并检查两者输出一致（允许逆 DCT 的 1 级舍入差）。
+// DCT 域变换裁掉右边 / 下边的不完整 MCU 时，与裁边后的原图变换结果比较
+static int benchRotate(const std::string &filename, int iterations, DctTransform transform) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> pixelRotated, decoded;
+    int rotatedWidth = 0, rotatedHeight = 0;
+    double pixelStepMs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        ImageData imgData;
+        DecodeStatus status = decodeCopy(header, imgData);
+        if (status != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << decodeStatusMessage(status) << std::endl;
+            return 1;
+        }
+        std::vector<uint8_t> pixelData(bmpRowSize(imgData) * imgData.height, 0);
+        fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+        auto stepStart = std::chrono::steady_clock::now();
+        transformPixels(pixelData, imgData.width, imgData.height, imgData.isGrayscale() ? 1 : 3, transform,
+                        pixelRotated, rotatedWidth, rotatedHeight);
+        pixelStepMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+        decoded.swap(pixelData);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double pixelMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+    std::vector<uint8_t> dctRotated;
+    ImageData rotated;
+    double dctStepMs = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        rotated = header;
+        rotated.initializeBlocks(rotated.width, rotated.height);
+        DecodeStatus status = huffmanDecode(rotated.compressedData, rotated);
+        if (status != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << decodeStatusMessage(status) << std::endl;
+            return 1;
+        }
+        auto stepStart = std::chrono::steady_clock::now();
+        transformCoefficients(rotated, transform);
+        dctStepMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+        reconstructImage(rotated);
+        dctRotated.assign(bmpRowSize(rotated) * rotated.height, 0);
+        fillBMPRows(rotated, 0, rotated.mcuHeight, dctRotated);
+    }
+    end = std::chrono::steady_clock::now();
+    double dctMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+    // 逐像素找出对应的源像素：裁边后的源图宽高为 cropWidth x cropHeight（从左上角起）
+    bool transposed = transform == DctTransform::Transpose || transform == DctTransform::Rotate90 ||
+                      transform == DctTransform::Rotate270;
+    int cropWidth = transposed ? rotated.height : rotated.width;
+    int cropHeight = transposed ? rotated.width : rotated.height;
+    int channels = header.isGrayscale() ? 1 : 3;
+    size_t sourceRow = bmpRowSize(header), targetRow = bmpRowSize(rotated);
+    int maxError = 0;
+    for (int y = 0; y < rotated.height; ++y) {
+        for (int x = 0; x < rotated.width; ++x) {
+            int sx = x, sy = y;
+            switch (transform) {
+            case DctTransform::FlipHorizontal: sx = cropWidth - 1 - x; break;
+            case DctTransform::FlipVertical:   sy = cropHeight - 1 - y; break;
+            case DctTransform::Rotate180:      sx = cropWidth - 1 - x; sy = cropHeight - 1 - y; break;
+            case DctTransform::Transpose:      sx = y; sy = x; break;
+            case DctTransform::Rotate90:       sx = y; sy = cropHeight - 1 - x; break;
+            case DctTransform::Rotate270:      sx = cropWidth - 1 - y; sy = x; break;
+            default: break;
+            }
+            // BMP 行自下而上存放
+            const uint8_t *a = &dctRotated[(rotated.height - 1 - y) * targetRow + x * channels];
+            const uint8_t *b = &decoded[(header.height - 1 - sy) * sourceRow + sx * channels];
+            for (int c = 0; c < channels; ++c) maxError = std::max(maxError, std::abs(a[c] - b[c]));
+        }
+    }
+
+    std::cout << filename << " (" << header.width << "x" << header.height << " -> "
+              << rotated.width << "x" << rotated.height << ")" << std::endl;
+    std::cout << "  decode + pixel transform: " << pixelMs << " ms (transform " << pixelStepMs / iterations << " ms)" << std::endl;
+    std::cout << "  DCT transform + decode:   " << dctMs << " ms (transform " << dctStepMs / iterations << " ms)" << std::endl;
+    if (rotated.width != rotatedWidth || rotated.height != rotatedHeight) {
+        std::cout << "  edge MCUs trimmed, compared against the transformed " << cropWidth << "x" << cropHeight
+                  << " top-left crop" << std::endl;
+    }
+    std::cout << "  max pixel difference:     " << maxError << std::endl;
+    return maxError <= 1 ? 0 : 1;
+}
+
+// 编码吞吐：先用本解码器得到像素，再以不同采样方式、重启间隔和线程数重复编码；
+// 4:2:0 结果再解码回来与原像素比较 PSNR
+static int benchEncode(const std::string &filename, int iterations, int threadCount) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+    ImageData decoded;
+    {
+        QuietStdout quiet;
+        if (decodeCopy(header, decoded) != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+    }
+    int channels = decoded.isGrayscale() ? 1 : 3;
+    std::vector<uint8_t> pixelData(bmpRowSize(decoded) * decoded.height, 0);
+    fillBMPRows(decoded, 0, decoded.mcuHeight, pixelData);
+    RawImage image = rawImageFromBMPRows(pixelData, decoded.width, decoded.height, channels);
+
+    struct Config {
+        const char *name;
+        ChromaSubsampling subsampling;
+        bool restart;
+        int threads;
+    };
+    const Config configs[] = {
+        {"4:2:0", ChromaSubsampling::Yuv420, false, 1},
+        {"4:4:4", ChromaSubsampling::Yuv444, false, 1},
+        {"4:2:0 restart/row", ChromaSubsampling::Yuv420, true, 1},
+        {"4:2:0 restart/row parallel", ChromaSubsampling::Yuv420, true, threadCount},
+    };
+
+    std::cout << filename << " (" << image.width << "x" << image.height << ", " << iterations << " iterations, "
+              << threadCount << " threads)" << std::endl;
+    double megabytes = static_cast<double>(image.pixels.size()) / (1024.0 * 1024.0);
+    std::vector<uint8_t> encoded;
+    for (const Config &config : configs) {
+        EncodeOptions options;
+        options.subsampling = config.subsampling;
+        options.threadCount = config.threads;
+        if (config.restart) {
+            int mcuSize = channels == 1 || config.subsampling == ChromaSubsampling::Yuv444 ? 8 : 16;
+            options.restartInterval = (image.width + mcuSize - 1) / mcuSize;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            encodeJPEG(image, options, encoded);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+        std::cout << "  " << config.name << ": " << ms << " ms, " << megabytes / (ms / 1000.0) << " MB/s, "
+                  << encoded.size() << " bytes" << std::endl;
+    }
+
+    // 往返检查：本解码器只支持 4:2:0 彩色与灰度
+    EncodeOptions options;
+    encodeJPEG(image, options, encoded);
+    std::string tempFile = "jpeg_bench_encode.jpg";
+    std::ofstream(tempFile, std::ios::binary).write(reinterpret_cast<const char *>(encoded.data()), encoded.size());
+    ImageData roundTrip;
+    DecodeStatus status;
+    {
+        QuietStdout quiet;
+        roundTrip = parseJPEGHeader(tempFile);
+        roundTrip.initializeHuffmanTables();
+        roundTrip.initializeBlocks(roundTrip.width, roundTrip.height);
+        status = decodeJPEG(roundTrip, roundTrip.compressedData);
+    }
+    std::remove(tempFile.c_str());
+    if (status != DecodeStatus::Ok || roundTrip.width != decoded.width || roundTrip.height != decoded.height) {
+        std::cerr << "  round trip failed" << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> roundTripPixels(pixelData.size(), 0);
+    fillBMPRows(roundTrip, 0, roundTrip.mcuHeight, roundTripPixels);
+    double squaredError = 0;
+    for (size_t i = 0; i < pixelData.size(); ++i) {
+        double diff = static_cast<double>(pixelData[i]) - roundTripPixels[i];
+        squaredError += diff * diff;
+    }
+    double mse = squaredError / pixelData.size();
+    std::cout << "  round trip PSNR (quality 75): " << (mse > 0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0)
+              << " dB" << std::endl;
+    return 0;
+}
+
+// 只做熵解码，得到 Zig-Zag 顺序的量化系数
+static DecodeStatus decodeCoefficients(const std::string &filename, ImageData &imgData) {
+    QuietStdout quiet;
+    imgData = parseJPEGHeader(filename, false);
+    if (!imgData.width || !imgData.height) return DecodeStatus::InvalidHeader;
+    imgData.initializeHuffmanTables();
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    return huffmanDecode(imgData.compressedData, imgData);
+}
+
+// 哈夫曼表重新优化的吞吐与压缩率，并检查优化前后量化系数完全一致
+static int benchOptimize(const std::string &filename, int iterations) {
+    std::vector<uint8_t> output;
+    OptimizeReport report;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        report = optimizeJPEG(filename, output);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (report.status != DecodeStatus::Ok) {
+        std::cerr << "优化失败: " << decodeStatusMessage(report.status) << std::endl;
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+    std::string tempFile = "jpeg_bench_optimize.jpg";
+    std::ofstream(tempFile, std::ios::binary).write(reinterpret_cast<const char *>(output.data()), output.size());
+    ImageData original, optimized;
+    DecodeStatus originalStatus = decodeCoefficients(filename, original);
+    DecodeStatus optimizedStatus = decodeCoefficients(tempFile, optimized);
+    std::remove(tempFile.c_str());
+    bool identical = originalStatus == DecodeStatus::Ok && optimizedStatus == DecodeStatus::Ok &&
+                     original.Y == optimized.Y && original.Cb == optimized.Cb && original.Cr == optimized.Cr;
+
+    long saved = static_cast<long>(report.inputBytes) - static_cast<long>(report.outputBytes);
+    std::cout << filename << " (" << iterations << " iterations)" << std::endl;
+    std::cout << "  size:         " << report.inputBytes << " -> " << report.outputBytes << " bytes" << std::endl;
+    std::cout << "  saved:        " << saved << " bytes (" << 100.0 * saved / report.inputBytes << " %)" << std::endl;
+    std::cout << "  time:         " << ms << " ms, " << report.inputBytes / (1024.0 * 1024.0) / (ms / 1000.0)
+              << " MB/s" << std::endl;
+    std::cout << "  coefficients: " << (identical ? "identical" : "MISMATCH") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// 区域解码延迟：建立 MCU 索引后，随机取若干个方形区域，分别从扫描开头和从检查点开始解码，
+// 两种方式的输出必须一致
+static int benchTile(const std::string &filename, int tileSize, int tileCount, int interval) {
+    ImageData imgData;
+    {
+        QuietStdout quiet;
+        imgData = parseJPEGHeader(filename, false);
+    }
+    if (!imgData.width || !imgData.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+    imgData.initializeHuffmanTables();
+    imgData.initializeMcuLayout(imgData.width, imgData.height);
+
+    McuIndex index;
+    auto start = std::chrono::steady_clock::now();
+    DecodeStatus status = buildMcuIndex(imgData, interval, index);
+    auto end = std::chrono::steady_clock::now();
+    if (status != DecodeStatus::Ok) {
+        std::cerr << "建立索引失败: " << decodeStatusMessage(status) << std::endl;
+        return 1;
+    }
+    double indexMs = std::chrono::duration<double, std::milli>(end - start).count();
+    std::string indexFile = "jpeg_bench_tile.idx";
+    saveMcuIndex(indexFile, index);
+    std::ifstream indexStream(indexFile, std::ios::binary | std::ios::ate);
+    long indexBytes = static_cast<long>(indexStream.tellg());
+    indexStream.close();
+    McuIndex loaded;
+    bool roundTrip = loadMcuIndex(indexFile, loaded) && mcuIndexMatches(loaded, imgData);
+    std::remove(indexFile.c_str());
+
+    // 固定种子的线性同余序列，保证每次运行取同样的区域
+    uint32_t seed = 12345;
+    auto next = [&seed](int range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % static_cast<uint32_t>(std::max(range, 1)));
+    };
+
+    double scanMs = 0, indexedMs = 0;
+    bool identical = true;
+    for (int i = 0; i < tileCount; ++i) {
+        int x = next(imgData.width - tileSize);
+        int y = next(imgData.height - tileSize);
+        RawImage fromStart, fromCheckpoint;
+        start = std::chrono::steady_clock::now();
+        decodeRegion(imgData, nullptr, x, y, tileSize, tileSize, fromStart);
+        auto middle = std::chrono::steady_clock::now();
+        decodeRegion(imgData, &loaded, x, y, tileSize, tileSize, fromCheckpoint);
+        end = std::chrono::steady_clock::now();
+        scanMs += std::chrono::duration<double, std::milli>(middle - start).count();
+        indexedMs += std::chrono::duration<double, std::milli>(end - middle).count();
+        identical = identical && fromStart.pixels == fromCheckpoint.pixels;
+    }
+
+    std::cout << filename << " (" << imgData.width << "x" << imgData.height << ", "
+              << imgData.width * static_cast<double>(imgData.height) / 1e6 << " MP)" << std::endl;
+    std::cout << "  index: " << index.checkpoints.size() << " checkpoints every " << index.interval << " MCUs, "
+              << indexBytes << " bytes, built in " << indexMs << " ms" << (roundTrip ? "" : " (RELOAD FAILED)")
+              << std::endl;
+    std::cout << "  " << tileCount << " tiles of " << tileSize << "x" << tileSize << ":" << std::endl;
+    std::cout << "    from scan start: " << scanMs / tileCount << " ms/tile" << std::endl;
+    std::cout << "    from checkpoint: " << indexedMs / tileCount << " ms/tile" << std::endl;
+    std::cout << "    speedup:         " << scanMs / indexedMs << "x" << std::endl;
+    std::cout << "    output:          " << (identical ? "identical" : "MISMATCH") << std::endl;
+    return identical && roundTrip ? 0 : 1;
+}
+
+// 去掉 SOS 之前指定类型的标记段（模拟不带 DHT / DQT 的 MJPEG 帧）
+static std::vector<uint8_t> stripSegments(const std::vector<uint8_t> &jpeg, bool stripDht, bool stripDqt) {
+    std::vector<uint8_t> out(jpeg.begin(), jpeg.begin() + 2);
+    size_t pos = 2;
+    while (pos + 4 <= jpeg.size()) {
+        uint8_t marker = jpeg[pos + 1];
+        size_t length = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if (marker == SOS) break;
+        bool strip = (marker == DHT && stripDht) || (marker == DQT && stripDqt);
+        if (!strip) out.insert(out.end(), jpeg.begin() + pos, jpeg.begin() + pos + 2 + length);
+        pos += 2 + length;
+    }
+    out.insert(out.end(), jpeg.begin() + pos, jpeg.end());
+    return out;
+}
+
+// 独立解码一幅完整的 JPEG，得到 BMP 像素
+static bool decodeToBMPRows(const std::vector<uint8_t> &jpeg, std::vector<uint8_t> &pixelData) {
+    ImageData imgData = parseJPEGMemory(jpeg.data(), jpeg.size());
+    imgData.initializeHuffmanTables();
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    if (decodeJPEG(imgData, imgData.compressedData) != DecodeStatus::Ok) return false;
+    pixelData.assign(static_cast<size_t>(bmpRowSize(imgData)) * imgData.height, 0);
+    fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+    return true;
+}
+
+// MJPEG 流解码吞吐：把输入图像平铺成 1080p 与 4K 帧（每帧平移），编码成流，
+// 第一帧之后的帧去掉 DHT、奇数帧再去掉 DQT，分别用 1 个与 threadCount 个线程解码
+static int benchMjpeg(const std::string &filename, int frameCount, int threadCount) {
+    ImageData header = loadHeader(filename);
+    ImageData decoded;
+    {
+        QuietStdout quiet;
+        if (!header.width || !header.height || decodeCopy(header, decoded) != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+    }
+    int channels = decoded.isGrayscale() ? 1 : 3;
+    std::vector<uint8_t> sourcePixels(bmpRowSize(decoded) * decoded.height, 0);
+    fillBMPRows(decoded, 0, decoded.mcuHeight, sourcePixels);
+    RawImage source = rawImageFromBMPRows(sourcePixels, decoded.width, decoded.height, channels);
+
+    struct Resolution {
+        const char *name;
+        int width;
+        int height;
+    };
+    const Resolution resolutions[] = {{"1080p", 1920, 1080}, {"4K", 3840, 2160}};
+    const int distinctFrames = std::min(frameCount, 4);
+    bool ok = true;
+    for (const Resolution &resolution : resolutions) {
+        // 编码几幅不同平移量的帧，流中循环使用
+        std::vector<std::vector<uint8_t>> encoded(distinctFrames);
+        std::vector<std::vector<uint8_t>> references(distinctFrames);
+        for (int f = 0; f < distinctFrames; ++f) {
+            RawImage frame;
+            frame.width = resolution.width;
+            frame.height = resolution.height;
+            frame.channels = channels;
+            frame.pixels.resize(static_cast<size_t>(frame.width) * frame.height * channels);
+            for (int row = 0; row < frame.height; ++row) {
+                for (int col = 0; col < frame.width; ++col) {
+                    int srcRow = row % source.height;
+                    int srcCol = (col + f * 37) % source.width;
+                    std::memcpy(&frame.pixels[(static_cast<size_t>(row) * frame.width + col) * channels],
+                                &source.pixels[(static_cast<size_t>(srcRow) * source.width + srcCol) * channels],
+                                channels);
+                }
+            }
+            EncodeOptions options;
+            encodeJPEG(frame, options, encoded[f]);
+            decodeToBMPRows(encoded[f], references[f]);
+        }
+
+        std::vector<uint8_t> stream;
+        for (int i = 0; i < frameCount; ++i) {
+            const std::vector<uint8_t> &jpeg = encoded[i % distinctFrames];
+            std::vector<uint8_t> frame = i == 0 ? jpeg : stripSegments(jpeg, true, i % 2 == 1);
+            stream.insert(stream.end(), frame.begin(), frame.end());
+        }
+
+        std::cout << resolution.name << " (" << resolution.width << "x" << resolution.height << ", " << frameCount
+                  << " frames, " << stream.size() / 1024 << " KB)" << std::endl;
+        for (int threads : {1, threadCount}) {
+            MjpegDecodeOptions options;
+            options.threadCount = threads;
+            size_t expected = 0;
+            bool identical = true;
+            auto start = std::chrono::steady_clock::now();
+            MjpegStreamReport report =
+                decodeMjpegStream(stream.data(), stream.size(), options, [&](const DecodedFrame &frame) {
+                    identical = identical && frame.index == expected && frame.status == DecodeStatus::Ok &&
+                                frame.pixelData == references[frame.index % distinctFrames];
+                    expected++;
+                });
+            auto end = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            identical = identical && expected == static_cast<size_t>(frameCount) && report.failedFrames == 0;
+            std::cout << "  " << threads << " thread" << (threads > 1 ? "s" : " ") << ": " << report.frames / seconds
+                      << " frames/s (" << report.defaultTableFrames << " frames without DHT), "
+                      << (identical ? "in order, identical" : "MISMATCH") << std::endl;
+            ok = ok && identical;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// 把 data 按 chunkSizes 循环给出的块大小送入增量解码器，返回最终状态；
+// firstRowMs 为从开始送入到第一行像素就绪的时间
+static DecodeStatus decodeInChunks(const std::vector<uint8_t> &data, const std::vector<size_t> &chunkSizes,
+                                   std::vector<uint8_t> &pixelData, double &firstRowMs) {
+    auto start = std::chrono::steady_clock::now();
+    firstRowMs = -1;
+    IncrementalDecoder decoder([&](const DecodeEvent &event) {
+        if (event.type == DecodeEventType::RowsReady && firstRowMs < 0) {
+            firstRowMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    });
+    size_t pos = 0;
+    for (size_t i = 0; pos < data.size() && !decoder.done(); ++i) {
+        size_t size = std::min(chunkSizes[i % chunkSizes.size()], data.size() - pos);
+        decoder.feed(data.data() + pos, size);
+        pos += size;
+    }
+    DecodeStatus status = decoder.finish();
+    pixelData = decoder.pixelData();
+    return status;
+}
+
+// 增量解码一致性：每个文件（及其截断副本）按随机大小分块送入，
+// 结果必须与整文件解码的状态和像素一致；另外比较第一行像素就绪的时间
+static int benchChunked(const std::vector<std::string> &filenames, int rounds) {
+    uint32_t seed = 12345;
+    auto next = [&seed](int range) {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<int>((seed >> 8) % static_cast<uint32_t>(std::max(range, 1)));
+    };
+
+    int mismatches = 0;
+    for (const auto &filename : filenames) {
+        std::ifstream file(filename, std::ios::binary);
+        std::vector<uint8_t> whole((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (whole.empty()) {
+            std::cerr << "无法读取文件: " << filename << std::endl;
+            return 1;
+        }
+
+        for (bool truncate : {false, true}) {
+            std::vector<uint8_t> data = whole;
+            if (truncate) data.resize(data.size() / 2);
+
+            // 参考结果：整块数据一次解析、解码
+            auto start = std::chrono::steady_clock::now();
+            ImageData reference = parseJPEGMemory(data.data(), data.size());
+            DecodeStatus referenceStatus = DecodeStatus::InvalidHeader;
+            std::vector<uint8_t> referencePixels;
+            if (reference.width && reference.height) {
+                reference.initializeHuffmanTables();
+                reference.initializeBlocks(reference.width, reference.height);
+                referenceStatus = decodeJPEG(reference, reference.compressedData);
+                if (referenceStatus == DecodeStatus::Ok) {
+                    referencePixels.assign(static_cast<size_t>(bmpRowSize(reference)) * reference.height, 0);
+                    fillBMPRows(reference, 0, reference.mcuHeight, referencePixels);
+                }
+            }
+            double bufferedMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // 逐字节、整块、64 KB 块，以及 rounds 组随机块大小
+            std::vector<std::vector<size_t>> chunkings = {{1}, {data.size()}, {65536}};
+            for (int r = 0; r < rounds; ++r) {
+                std::vector<size_t> sizes;
+                for (int i = 0; i < 64; ++i) sizes.push_back(1 + next(r % 2 ? 64 : 8192));
+                chunkings.push_back(sizes);
+            }
+            int failed = 0;
+            double firstRowMs = 0;
+            for (size_t c = 0; c < chunkings.size(); ++c) {
+                std::vector<uint8_t> pixelData;
+                double ms = 0;
+                auto chunkStart = std::chrono::steady_clock::now();
+                DecodeStatus status = decodeInChunks(data, chunkings[c], pixelData, ms);
+                double totalMs =
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - chunkStart).count();
+                bool same = status == referenceStatus && (status != DecodeStatus::Ok || pixelData == referencePixels);
+                if (!same) failed++;
+                if (c == 2) {
+                    firstRowMs = ms;
+                    std::cout << filename << (truncate ? " (truncated)" : "") << ": "
+                              << decodeStatusMessage(referenceStatus) << std::endl;
+                    std::cout << "  buffered decode:       " << bufferedMs << " ms" << std::endl;
+                    std::cout << "  64 KB chunks:          " << totalMs << " ms, first row after " << firstRowMs
+                              << " ms" << std::endl;
+                }
+            }
+            std::cout << "  " << chunkings.size() << " chunkings: "
+                      << (failed ? std::to_string(failed) + " MISMATCH" : std::string("identical")) << std::endl;
+            mismatches += failed;
+        }
+    }
+    return mismatches ? 1 : 0;
+}
+
+// 多个客户端并发地各发 requests 次请求，打印吞吐与 p50/p99 延迟；request 返回 false 表示失败
+static bool runLoad(const char *name, int clients, int requests, const std::function<bool(int, int)> &request) {
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c]() {
+            for (int i = 0; i < requests; ++i) {
+                auto begin = std::chrono::steady_clock::now();
+                if (!request(c, i)) failures++;
+                latencies[c].push_back(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+            }
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const auto &perClient : latencies) all.insert(all.end(), perClient.begin(), perClient.end());
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+    std::cout << "  " << name << ": " << all.size() / seconds << " req/s, p50 " << percentile(0.5) << " ms, p99 "
+              << percentile(0.99) << " ms" << (failures ? ", " + std::to_string(failures.load()) + " FAILED" : "")
+              << std::endl;
+    return failures == 0;
+}
+
+// 解码服务压测：同一幅图像经 Unix 域套接字请求（返回像素 / 写 BMP 文件），
+// 与每次启动一个 jpeg_parser 进程比较。没有给出套接字时在本进程内启动服务，根目录为图像所在目录，
+// BMP 写在该目录下；外部服务须以包含图像的目录为 --root
+static int benchServer(const std::string &filename, int clients, int requests, const std::string &externalSocket,
+                       const std::string &parserPath) {
+    std::string input = std::filesystem::absolute(filename).string();
+    ImageData reference;
+    {
+        QuietStdout quiet;
+        ImageData header = loadHeader(input);
+        if (!header.width || !header.height || decodeCopy(header, reference) != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+    }
+    int channels = reference.isGrayscale() ? 1 : 3;
+    std::vector<uint8_t> referenceRows(bmpRowSize(reference) * reference.height, 0);
+    fillBMPRows(reference, 0, reference.mcuHeight, referenceRows);
+    RawImage expected = rawImageFromBMPRows(referenceRows, reference.width, reference.height, channels);
+
+    DecodeServer server;
+    DecodeLimits limits;
+    limits.rootDirectory = std::filesystem::path(input).parent_path().string();
+    std::thread serverThread;
+    std::string socketPath = externalSocket;
+    if (socketPath.empty()) {
+        socketPath = "jpeg_bench_server.sock";
+        if (!server.listen(socketPath)) {
+            std::cerr << "无法监听: " << socketPath << std::endl;
+            return 1;
+        }
+        serverThread = std::thread([&]() { server.run(clients, nullptr, limits); });
+    }
+
+    std::vector<int> fds(clients, -1);
+    std::vector<std::unique_ptr<FdReader>> readers;
+    for (int c = 0; c < clients; ++c) {
+        fds[c] = connectDecodeServer(socketPath);
+        if (fds[c] < 0) {
+            std::cerr << "无法连接: " << socketPath << std::endl;
+            return 1;
+        }
+        readers.push_back(std::make_unique<FdReader>(fds[c]));
+    }
+
+    std::cout << filename << " (" << reference.width << "x" << reference.height << ", " << clients << " clients x "
+              << requests << " requests)" << std::endl;
+    bool ok = true;
+    ok = runLoad("socket, pixels in response", clients, requests, [&](int c, int) {
+        std::string status;
+        std::vector<uint8_t> payload;
+        return sendDecodeRequest(fds[c], *readers[c], "decode " + input, nullptr, status, payload) &&
+               payload == expected.pixels;
+    }) && ok;
+    ok = runLoad("socket, BMP file        ", clients, requests, [&](int c, int) {
+        std::string status;
+        std::vector<uint8_t> payload;
+        std::string output = limits.rootDirectory + "/jpeg_bench_server_" + std::to_string(c) + ".bmp";
+        return sendDecodeRequest(fds[c], *readers[c], "decode " + input + " out=" + output, nullptr, status,
+                                 payload) &&
+               status.rfind("ok ", 0) == 0;
+    }) && ok;
+    for (int fd : fds) ::close(fd);
+
+    if (std::filesystem::exists(parserPath)) {
+        ok = runLoad("process per image       ", clients, requests, [&](int c, int) {
+            std::string output = "jpeg_bench_server_" + std::to_string(c) + ".bmp";
+            std::string command = "\"" + parserPath + "\" --stdin " + output + " < \"" + input + "\" 2>/dev/null";
+            return std::system(command.c_str()) == 0;
+        }) && ok;
+    } else {
+        std::cout << "  process per image: " << parserPath << " not found, skipped" << std::endl;
+    }
+    for (int c = 0; c < clients; ++c) {
+        std::remove(("jpeg_bench_server_" + std::to_string(c) + ".bmp").c_str());
+        std::remove((limits.rootDirectory + "/jpeg_bench_server_" + std::to_string(c) + ".bmp").c_str());
+    }
+
+    if (serverThread.joinable()) {
+        server.stop();
+        serverThread.join();
+    }
+    return ok ? 0 : 1;
+}
+
+// 解码结果缓存：把输入按不同质量与重启间隔重新编码成 catalogSize 幅内容不同的 JPEG（奇数项只取亮度），
+// 每个线程按 Zipf 分布（指数 zipfExponent）请求，比较无缓存、内存 LRU、内存 LRU + 磁盘层的吞吐与延迟。
+// memoryMB 为 0 时内存层取全部结果大小的 1/10；最后检查缓存返回的数据与直接解码一致
+static int benchCache(const std::string &filename, int threadCount, int requests, int catalogSize,
+                      double zipfExponent, int memoryMB) {
+    ImageData header = loadHeader(filename);
+    ImageData decoded;
+    {
+        QuietStdout quiet;
+        if (!header.width || !header.height || decodeCopy(header, decoded) != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+    }
+    std::vector<uint8_t> rows(static_cast<size_t>(bmpRowSize(decoded)) * decoded.height, 0);
+    fillBMPRows(decoded, 0, decoded.mcuHeight, rows);
+    RawImage image = rawImageFromBMPRows(rows, decoded.width, decoded.height, decoded.isGrayscale() ? 1 : 3);
+
+    std::vector<std::vector<uint8_t>> catalog(catalogSize);
+    std::vector<DecodeRequest> catalogRequests(catalogSize);
+    for (int i = 0; i < catalogSize; ++i) {
+        EncodeOptions options;
+        options.quality = 40 + i % 60;
+        options.restartInterval = i / 60;  // 质量相同的条目用不同的重启间隔区分内容
+        encodeJPEG(image, options, catalog[i]);
+        catalogRequests[i].lumaOnly = i % 2 == 1;
+    }
+
+    // 参考结果：不经缓存逐幅解码
+    std::vector<std::shared_ptr<const CachedImage>> expected(catalogSize);
+    uint64_t catalogBytes = 0;
+    {
+        DecodeWorkerBuffers buffers;
+        for (int i = 0; i < catalogSize; ++i) {
+            std::string error;
+            buffers.input = catalog[i];
+            expected[i] = decodeRequestImage(catalogRequests[i], buffers, nullptr, error);
+            if (!expected[i]) {
+                std::cerr << "解码失败: " << error << std::endl;
+                return 1;
+            }
+            catalogBytes += expected[i]->size();
+        }
+    }
+    uint64_t memoryBytes = memoryMB > 0 ? static_cast<uint64_t>(memoryMB) << 20 : catalogBytes / 10;
+
+    // Zipf 分布：第 k 个条目的概率正比于 1 / (k + 1)^s，各线程的请求序列预先生成，各配置相同
+    std::vector<double> cdf(catalogSize);
+    double sum = 0;
+    for (int k = 0; k < catalogSize; ++k) cdf[k] = sum += 1.0 / std::pow(k + 1, zipfExponent);
+    std::vector<std::vector<int>> trace(threadCount, std::vector<int>(requests));
+    for (int c = 0; c < threadCount; ++c) {
+        std::mt19937_64 random(c + 1);
+        std::uniform_real_distribution<double> uniform(0, sum);
+        for (int &item : trace[c]) {
+            item = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin());
+            item = std::min(item, catalogSize - 1);
+        }
+    }
+
+    std::cout << filename << " (" << catalogSize << " images, " << catalogBytes / (1 << 20) << " MB decoded, Zipf s="
+              << zipfExponent << ", " << threadCount << " threads x " << requests << " requests, memory tier "
+              << memoryBytes / (1 << 20) << " MB)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::string diskDirectory = (std::filesystem::temp_directory_path() / "jpeg_bench_cache").string();
+    std::filesystem::remove_all(diskDirectory);
+    bool ok = true;
+    for (int config = 0; config < 3; ++config) {
+        std::unique_ptr<DecodeCache> cache;
+        if (config > 0) {
+            DecodeCacheOptions options;
+            options.memoryBytes = memoryBytes;
+            if (config == 2) options.diskDirectory = diskDirectory;
+            cache = std::make_unique<DecodeCache>(options);
+        }
+        std::vector<DecodeWorkerBuffers> buffers(threadCount);
+        const char *name = config == 0 ? "no cache      " : config == 1 ? "memory LRU    " : "memory + disk ";
+        ok = runLoad(name, threadCount, requests, [&](int c, int i) {
+            int item = trace[c][i];
+            std::string error;
+            buffers[c].input = catalog[item];
+            auto result = decodeRequestImage(catalogRequests[item], buffers[c], cache.get(), error);
+            return result && result->size() == expected[item]->size();
+        }) && ok;
+        if (!cache) continue;
+
+        DecodeCacheStats stats = cache->stats();
+        uint64_t lookups = stats.hits + stats.diskHits + stats.misses;
+        std::cout << "    hits " << stats.hits << ", disk hits " << stats.diskHits << ", misses " << stats.misses
+                  << " (hit rate " << 100.0 * (stats.hits + stats.diskHits) / lookups << "%), evictions "
+                  << stats.evictions << ", disk writes " << stats.diskWrites << ", memory "
+                  << stats.memoryBytes / (1 << 20) << " MB / " << stats.memoryEntries << " entries";
+        if (config == 2) {
+            std::cout << ", disk " << stats.diskBytes / (1 << 20) << " MB / " << stats.diskEntries << " files";
+        }
+        std::cout << std::endl;
+
+        for (int i = 0; i < catalogSize; ++i) {
+            std::string error;
+            buffers[0].input = catalog[i];
+            auto result = decodeRequestImage(catalogRequests[i], buffers[0], cache.get(), error);
+            ok = ok && result && result->size() == expected[i]->size() &&
+                 std::equal(result->data(), result->data() + result->size(), expected[i]->data());
+        }
+    }
+    std::filesystem::remove_all(diskDirectory);
+    std::cout << "  cached results identical to direct decode: " << (ok ? "yes" : "no") << std::endl;
+    return ok ? 0 : 1;
+}
+
+// 当前常驻内存字节数（/proc/self/statm 第二项），无法读取时返回 -1
+static long residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    long pages, resident;
+    if (!(statm >> pages >> resident)) return -1;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// 逆量化：按 32 位系数存储的原实现 vs 16 位系数的标量 / SSE2 / AVX2 实现。
+// 每次计时前从熵解码结果恢复系数（不计时），报告两种存储实测的内存、带宽、每块缓存未命中，并检查各实现结果一致
+static int benchDequant(const std::string &filename, int iterations) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height || !header.hasSupportedSampling()) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+    ImageData decoded = header;
+    decoded.initializeBlocks(decoded.width, decoded.height);
+    if (huffmanDecode(decoded.compressedData, decoded) != DecodeStatus::Ok) {
+        std::cerr << "熵解码失败: " << filename << std::endl;
+        return 1;
+    }
+    long blocks = static_cast<long>(decoded.Y.size() + decoded.Cb.size() + decoded.Cr.size());
+
+    PerfCounters counters;
+    auto report = [&](const char *name, size_t coefficientBytes, double ms, const PerfSample &sample) {
+        double megabytes = 2.0 * blocks * 64 * coefficientBytes / 1e6;  // 读 + 写
+        std::cout << "  " << std::left << std::setw(8) << name << std::right << std::setw(10) << ms << " ms"
+                  << std::setw(10) << megabytes / ms << " GB/s";
+        for (PerfEvent event : {PerfEvent::L1dMisses, PerfEvent::LlcMisses}) {
+            std::cout << "  " << perfEventName(event) << "/block ";
+            if (sample.has(event)) {
+                std::cout << static_cast<double>(sample.value(event)) / iterations / blocks;
+            } else {
+                std::cout << "n/a";
+            }
+        }
+        std::cout << std::endl;
+    };
+
+    std::cout << filename << " (" << header.width << "x" << header.height << ", " << blocks << " blocks)" << std::endl;
+
+    // 原实现：32 位系数逐个相乘
+    std::vector<std::vector<int>> wide[3];
+    const std::vector<std::vector<Coefficient>> *planes[3] = {&decoded.Y, &decoded.Cb, &decoded.Cr};
+    int tableIds[3] = {decoded.yQuantTableId, decoded.crCbQuantTableId, decoded.crCbQuantTableId};
+    auto restoreWide = [&]() {
+        for (int c = 0; c < 3; ++c) {
+            wide[c].assign(planes[c]->size(), std::vector<int>(64));
+            for (size_t b = 0; b < planes[c]->size(); ++b) {
+                std::copy((*planes[c])[b].begin(), (*planes[c])[b].end(), wide[c][b].begin());
+            }
+        }
+    };
+
+    // 两种存储各新建一份系数，按常驻内存的增量计（含每块 vector 的头部与堆分配开销），括号中为系数本身的字节数
+    long residentBefore = residentBytes();
+    restoreWide();
+    long residentWide = residentBytes();
+    {
+        std::vector<std::vector<Coefficient>> narrow[3] = {decoded.Y, decoded.Cb, decoded.Cr};
+        long residentNarrow = residentBytes();
+        std::cout << "  coefficient storage (RSS): ";
+        if (residentBefore < 0 || residentNarrow < 0) {
+            std::cout << "n/a";
+        } else {
+            std::cout << "int32 " << (residentWide - residentBefore) / 1e6 << " MB, int16 "
+                      << (residentNarrow - residentWide) / 1e6 << " MB";
+        }
+        std::cout << " (payload " << blocks * 64 * 4 / 1e6 << " / " << blocks * 64 * 2 / 1e6 << " MB)" << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(3);
+
+    double ms = 0;
+    PerfSample total;
+    for (int i = 0; i < iterations; ++i) {
+        restoreWide();
+        auto start = std::chrono::steady_clock::now();
+        counters.start();
+        for (int c = 0; c < 3; ++c) {
+            const std::vector<int> &table = decoded.quantizationTables.at(tableIds[c]);
+            for (std::vector<int> &block : wide[c]) {
+                for (int k = 0; k < 64; ++k) block[k] *= table[k];
+            }
+        }
+        PerfSample sample = counters.stop();
+        ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0) {
+            total = sample;
+        } else {
+            total += sample;
+        }
+    }
+    report("int32", 4, ms / iterations, total);
+
+    bool identical = true;
+    std::vector<std::vector<Coefficient>> expected[3];
+    for (DequantizeKernel kernel : {DequantizeKernel::Scalar, DequantizeKernel::Sse2, DequantizeKernel::Avx2}) {
+        if (!dequantizeKernelSupported(kernel)) {
+            std::cout << "  " << std::left << std::setw(8) << dequantizeKernelName(kernel) << std::right
+                      << "not supported on this CPU" << std::endl;
+            continue;
+        }
+        ms = 0;
+        ImageData imgData = decoded;
+        for (int i = 0; i < iterations; ++i) {
+            imgData.Y = decoded.Y;
+            imgData.Cb = decoded.Cb;
+            imgData.Cr = decoded.Cr;
+            auto start = std::chrono::steady_clock::now();
+            counters.start();
+            inverseQuantize(imgData, 0, imgData.mcuHeight, kernel);
+            PerfSample sample = counters.stop();
+            ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (i == 0) {
+                total = sample;
+            } else {
+                total += sample;
+            }
+        }
+        report(dequantizeKernelName(kernel), 2, ms / iterations, total);
+
+        if (kernel == DequantizeKernel::Scalar) {
+            expected[0] = imgData.Y;
+            expected[1] = imgData.Cb;
+            expected[2] = imgData.Cr;
+            // 正常数据不会饱和，16 位结果应与 32 位结果相同
+            for (int c = 0; c < 3; ++c) {
+                for (size_t b = 0; b < wide[c].size(); ++b) {
+                    identical = identical && std::equal(wide[c][b].begin(), wide[c][b].end(), expected[c][b].begin());
+                }
+            }
+        } else {
+            identical = identical && imgData.Y == expected[0] && imgData.Cb == expected[1] && imgData.Cr == expected[2];
+        }
+    }
+    std::cout << "  results identical: " << (identical ? "yes" : "no") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// 输出格式：对同一幅已重建的图像，计时转换到内存缓冲区与写出文件的耗时。
+// "bmp->rgba" 为以前下游的做法：先生成 BMP 像素，再翻转行序并把 B,G,R 重排为 R,G,B,A
+static int benchOutput(const std::string &filename, int iterations) {
+    ImageData header = loadHeader(filename);
+    ImageData decoded;
+    {
+        QuietStdout quiet;
+        if (!header.width || !header.height || decodeCopy(header, decoded) != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+    }
+    int width = decoded.width, height = decoded.height;
+    std::cout << filename << " (" << width << "x" << height << ", " << iterations << " iterations)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::vector<uint8_t> bmp(static_cast<size_t>(bmpRowSize(decoded)) * height);
+    std::vector<uint8_t> repacked(static_cast<size_t>(width) * height * 4);
+    // 缓冲区在计时前分配好，只计转换本身
+    int alignedStride = (width * 4 + 63) / 64 * 64;
+    std::vector<uint8_t> packed(static_cast<size_t>(alignedStride) * height);
+    std::vector<uint8_t> planar;
+    uint8_t *planes[3] = {nullptr, nullptr, nullptr};
+    int strides[3] = {0, 0, 0};
+    {
+        size_t offsets[3] = {0, 0, 0}, size = 0;
+        for (int c = 0; c < yuvPlaneCount(decoded); ++c) {
+            int planeHeight = 0;
+            yuvPlaneSize(decoded, c, strides[c], planeHeight);
+            offsets[c] = size;
+            size += static_cast<size_t>(strides[c]) * planeHeight;
+        }
+        planar.resize(size);
+        for (int c = 0; c < yuvPlaneCount(decoded); ++c) planes[c] = planar.data() + offsets[c];
+    }
+    auto bmpToRgba = [&]() {
+        bool gray = bmpRowSize(decoded) < width * 3;
+        for (int y = 0; y < height; ++y) {
+            const uint8_t *src = &bmp[static_cast<size_t>(height - 1 - y) * bmpRowSize(decoded)];
+            uint8_t *dst = &repacked[static_cast<size_t>(y) * width * 4];
+            for (int x = 0; x < width; ++x, dst += 4) {
+                if (gray) {
+                    dst[0] = dst[1] = dst[2] = src[x];
+                } else {
+                    dst[0] = src[x * 3 + 2];
+                    dst[1] = src[x * 3 + 1];
+                    dst[2] = src[x * 3];
+                }
+                dst[3] = 255;
+            }
+        }
+    };
+    auto fillPacked = [&](OutputFormat format, int stride) {
+        fillPackedRows(decoded, 0, decoded.mcuHeight, format, packed.data(), stride);
+    };
+    auto fillPlanar = [&]() { fillYuvPlanes(decoded, 0, decoded.mcuHeight, planes, strides); };
+
+    struct Variant {
+        const char *name;
+        std::function<void()> convert;
+        OutputFormat format;  // 写文件时使用的格式
+        size_t bytes;
+        int stride;
+    };
+    const Variant variants[] = {
+        {"bmp", [&]() { fillBMPRows(decoded, 0, decoded.mcuHeight, bmp); }, OutputFormat::Bmp, bmp.size(), 0},
+        {"bmp->rgba", [&]() { fillBMPRows(decoded, 0, decoded.mcuHeight, bmp); bmpToRgba(); }, OutputFormat::Rgba,
+         repacked.size(), 0},
+        {"rgb", [&]() { fillPacked(OutputFormat::Rgb, width * 3); }, OutputFormat::Rgb,
+         static_cast<size_t>(width) * 3 * height, 0},
+        {"rgba", [&]() { fillPacked(OutputFormat::Rgba, width * 4); }, OutputFormat::Rgba, repacked.size(), 0},
+        {"rgba stride64", [&]() { fillPacked(OutputFormat::Rgba, alignedStride); }, OutputFormat::Rgba,
+         packed.size(), alignedStride},
+        {"yuv420p", fillPlanar, OutputFormat::Yuv420p, planar.size(), 0},
+    };
+
+    std::string outputFile = (std::filesystem::temp_directory_path() / "jpeg_bench_output.raw").string();
+    double megapixels = static_cast<double>(width) * height / 1e6;
+    bool identical = true;
+    for (const Variant &variant : variants) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) variant.convert();
+        double convertMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) saveDecodedImage(outputFile, decoded, variant.format, variant.stride);
+        double saveMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+        std::cout << "  " << std::left << std::setw(14) << variant.name << std::right << std::setw(9) << convertMs
+                  << " ms" << std::setw(9) << megapixels / convertMs * 1000.0 << " MP/s" << std::setw(10)
+                  << variant.bytes / 1024 << " KB   save to file " << saveMs << " ms" << std::endl;
+        if (std::string(variant.name) == "rgba") {
+            identical = std::equal(repacked.begin(), repacked.end(), packed.begin());
+        }
+    }
+    std::remove(outputFile.c_str());
+    std::cout << "  rgba identical to bmp->rgba: " << (identical ? "yes" : "no") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// 快速无损输出：每幅图像解码后分别写 BMP 与流式 QOI，比较端到端耗时（解码 + 写文件）与写出字节数，
+// 并单独计时内存中的 QOI 编码；读回 QOI 与直接输出的 RGB 比较确认无损
+static int benchQoi(const std::vector<std::string> &filenames, int iterations) {
+    std::string bmpFile = (std::filesystem::temp_directory_path() / "jpeg_bench_qoi.bmp").string();
+    std::string qoiFile = (std::filesystem::temp_directory_path() / "jpeg_bench_qoi.qoi").string();
+    auto elapsedMs = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::cout << std::fixed << std::setprecision(2);
+
+    double totalDecode = 0, totalBmp = 0, totalQoi = 0;
+    uintmax_t totalBmpBytes = 0, totalQoiBytes = 0;
+    int decodedImages = 0;
+    bool lossless = true;
+    for (const auto &filename : filenames) {
+        ImageData header = loadHeader(filename);
+        ImageData decoded;
+        double decodeMs = 0, bmpMs = 0, qoiMs = 0;
+        for (int i = 0; i < iterations; ++i) {
+            QuietStdout quiet;
+            auto start = std::chrono::steady_clock::now();
+            if (!header.width || !header.height || decodeCopy(header, decoded) != DecodeStatus::Ok) break;
+            decodeMs += elapsedMs(start);
+            start = std::chrono::steady_clock::now();
+            saveDecodedImage(bmpFile, decoded, OutputFormat::Bmp);
+            bmpMs += elapsedMs(start);
+            start = std::chrono::steady_clock::now();
+            saveAsQOI(qoiFile, decoded);
+            qoiMs += elapsedMs(start);
+        }
+        if (decodeMs == 0) {
+            std::cerr << "解码失败，跳过: " << filename << std::endl;
+            continue;
+        }
+        decodeMs /= iterations;
+        bmpMs /= iterations;
+        qoiMs /= iterations;
+
+        // 内存中编码整幅 RGB，不含颜色转换与写文件
+        int stride = decoded.width * 3;
+        std::vector<uint8_t> rgb(static_cast<size_t>(stride) * decoded.height);
+        fillPackedRows(decoded, 0, decoded.mcuHeight, OutputFormat::Rgb, rgb.data(), stride);
+        std::vector<uint8_t> encoded;
+        encoded.reserve(rgb.size() * 4 / 3 + 64);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            encoded.clear();
+            QoiEncoder encoder(decoded.width, decoded.height, 3, encoded);
+            encoder.encodeRows(rgb.data(), decoded.height, stride);
+            encoder.finish();
+        }
+        double encodeMs = elapsedMs(start) / iterations;
+
+        std::ifstream file(qoiFile, std::ios::binary);
+        std::vector<uint8_t> written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        RawImage roundTrip;
+        bool same = written == encoded && decodeQOI(written, roundTrip) && roundTrip.pixels == rgb;
+        lossless = lossless && same;
+
+        uintmax_t bmpBytes = std::filesystem::file_size(bmpFile);
+        uintmax_t qoiBytes = written.size();
+        std::cout << filename << " (" << decoded.width << "x" << decoded.height << ", " << iterations
+                  << " iterations)" << std::endl;
+        std::cout << "  decode " << decodeMs << " ms" << std::endl;
+        std::cout << "  bmp  save " << std::setw(8) << bmpMs << " ms  end-to-end " << std::setw(8)
+                  << decodeMs + bmpMs << " ms  " << std::setw(9) << bmpBytes / 1024 << " KB" << std::endl;
+        std::cout << "  qoi  save " << std::setw(8) << qoiMs << " ms  end-to-end " << std::setw(8)
+                  << decodeMs + qoiMs << " ms  " << std::setw(9) << qoiBytes / 1024 << " KB ("
+                  << 100.0 * qoiBytes / bmpBytes << "% of bmp)" << std::endl;
+        std::cout << "  qoi encode in memory " << encodeMs << " ms, " << rgb.size() / encodeMs / 1e3
+                  << " MB/s of RGB, lossless: " << (same ? "yes" : "no") << std::endl;
+
+        ++decodedImages;
+        totalDecode += decodeMs;
+        totalBmp += bmpMs;
+        totalQoi += qoiMs;
+        totalBmpBytes += bmpBytes;
+        totalQoiBytes += qoiBytes;
+    }
+    std::remove(bmpFile.c_str());
+    std::remove(qoiFile.c_str());
+    if (decodedImages > 1) {
+        std::cout << "all " << decodedImages << " images: end-to-end bmp " << totalDecode + totalBmp
+                  << " ms, qoi " << totalDecode + totalQoi << " ms; bytes bmp " << totalBmpBytes / 1024
+                  << " KB, qoi " << totalQoiBytes / 1024 << " KB (" << 100.0 * totalQoiBytes / totalBmpBytes
+                  << "%)" << std::endl;
+    }
+    return lossless ? 0 : 1;
+}
+
+// 按 scale x scale 取平均缩小（边缘不足的区域按实际像素数平均）
+static RawImage boxDownscale(const RawImage &image, int scale) {
+    RawImage result;
+    result.channels = image.channels;
+    result.width = pyramidLevelSize(image.width, scale);
+    result.height = pyramidLevelSize(image.height, scale);
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * result.channels);
+    for (int y = 0; y < result.height; ++y) {
+        for (int x = 0; x < result.width; ++x) {
+            int rows = std::min(scale, image.height - y * scale), cols = std::min(scale, image.width - x * scale);
+            for (int c = 0; c < image.channels; ++c) {
+                int sum = 0;
+                for (int dy = 0; dy < rows; ++dy) {
+                    for (int dx = 0; dx < cols; ++dx) {
+                        sum += image.pixels[(static_cast<size_t>(y * scale + dy) * image.width + x * scale + dx) *
+                                                image.channels + c];
+                    }
+                }
+                result.pixels[(static_cast<size_t>(y) * result.width + x) * result.channels + c] =
+                    static_cast<uint8_t>((sum + rows * cols / 2) / (rows * cols));
+            }
+        }
+    }
+    return result;
+}
+
+// 多级缩小输出：每个尺寸各完整解码一次再缩小、每个尺寸各做一次缩小解码、一次解码输出所有级别，
+// 三种方式都写出 BMP 文件；另报告各缩小级与完整解码后取平均缩小的 PSNR
+static int benchPyramid(const std::string &filename, int iterations, const std::vector<int> &scales) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height || !header.hasSupportedSampling()) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+    std::string directory = std::filesystem::temp_directory_path().string();
+    std::vector<std::string> filenames;
+    for (int scale : scales) {
+        filenames.push_back((std::filesystem::path(directory) / ("jpeg_bench_pyramid_" + std::to_string(scale) + ".bmp"))
+                                .string());
+    }
+    int channels = header.isGrayscale() ? 1 : 3;
+
+    // 完整解码后的 RGB / 灰度像素
+    auto decodeFull = [&](RawImage &image) {
+        ImageData decoded;
+        if (decodeCopy(header, decoded) != DecodeStatus::Ok) return false;
+        image.width = decoded.width;
+        image.height = decoded.height;
+        image.channels = 3;
+        image.pixels.resize(static_cast<size_t>(decoded.width) * decoded.height * 3);
+        fillPackedRows(decoded, 0, decoded.mcuHeight, OutputFormat::Rgb, image.pixels.data(), decoded.width * 3);
+        if (channels == 1) {
+            for (size_t i = 0; i < image.pixels.size() / 3; ++i) image.pixels[i] = image.pixels[i * 3];
+            image.pixels.resize(image.pixels.size() / 3);
+            image.channels = 1;
+        }
+        return true;
+    };
+    auto writeImage = [](const std::string &file, const RawImage &image) {
+        ImageData layout;
+        layout.width = image.width;
+        layout.height = image.height;
+        layout.colorComponents = image.channels;
+        std::vector<uint8_t> rows;
+        bmpRowsFromRawImage(image, rows);
+        return writeBMP(file, layout, rows);
+    };
+    auto savePyramidCopy = [&](const std::vector<int> &levelScales, const std::vector<std::string> &levelFiles) {
+        ImageData imgData = header;
+        imgData.initializeBlocks(imgData.width, imgData.height);
+        DecodeStatus status;
+        return savePyramid(imgData, levelScales, levelFiles, OutputFormat::Bmp, status);
+    };
+
+    struct Variant {
+        const char *name;
+        std::function<bool()> run;
+    };
+    const Variant variants[] = {
+        {"full decode per size + box downscale", [&]() {
+             for (size_t level = 0; level < scales.size(); ++level) {
+                 RawImage image;
+                 if (!decodeFull(image)) return false;
+                 if (!writeImage(filenames[level], scales[level] == 1 ? image : boxDownscale(image, scales[level]))) {
+                     return false;
+                 }
+             }
+             return true;
+         }},
+        {"scaled decode per size", [&]() {
+             for (size_t level = 0; level < scales.size(); ++level) {
+                 if (!savePyramidCopy({scales[level]}, {filenames[level]})) return false;
+             }
+             return true;
+         }},
+        {"pyramid, one pass", [&]() { return savePyramidCopy(scales, filenames); }},
+    };
+
+    std::cout << filename << " (" << header.width << "x" << header.height << ", " << scales.size() << " levels, "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    double baselineMs = 0;
+    for (const Variant &variant : variants) {
+        bool ok = true;
+        auto start = std::chrono::steady_clock::now();
+        {
+            QuietStdout quiet;
+            for (int i = 0; i < iterations && ok; ++i) ok = variant.run();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                    iterations;
+        if (!ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+        if (baselineMs == 0) baselineMs = ms;
+        std::cout << "  " << std::left << std::setw(38) << variant.name << std::right << std::setw(9) << ms
+                  << " ms  (" << baselineMs / ms << "x)" << std::endl;
+    }
+
+    // 缩小级的误差：与完整解码后取平均缩小的结果比较
+    RawImage full;
+    {
+        QuietStdout quiet;
+        decodeFull(full);
+    }
+    std::vector<RawImage> levels(scales.size());
+    ImageData imgData = header;
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    decodePyramid(imgData, scales, OutputFormat::Rgb,
+                  [&](int level, const uint8_t *pixels, int firstRow, int rowCount, int stride) {
+                      RawImage &image = levels[level];
+                      image.width = stride / 3;
+                      image.channels = channels;
+                      for (int y = 0; y < rowCount; ++y) {
+                          for (int x = 0; x < image.width; ++x) {
+                              for (int c = 0; c < channels; ++c) image.pixels.push_back(pixels[y * stride + x * 3 + c]);
+                          }
+                      }
+                      image.height = firstRow + rowCount;
+                  });
+    bool identical = true;
+    for (size_t level = 0; level < scales.size(); ++level) {
+        RawImage reference = scales[level] == 1 ? full : boxDownscale(full, scales[level]);
+        if (scales[level] == 1) {
+            identical = levels[level].pixels == reference.pixels;
+            continue;
+        }
+        double squared = 0;
+        for (size_t i = 0; i < reference.pixels.size(); ++i) {
+            double diff = static_cast<double>(levels[level].pixels[i]) - reference.pixels[i];
+            squared += diff * diff;
+        }
+        double mse = squared / reference.pixels.size();
+        std::cout << "  1/" << scales[level] << " (" << reference.width << "x" << reference.height
+                  << ") PSNR vs box-downscaled full decode: "
+                  << (mse > 0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0) << " dB" << std::endl;
+    }
+    for (const std::string &file : filenames) std::remove(file.c_str());
+    if (std::find(scales.begin(), scales.end(), 1) != scales.end()) {
+        std::cout << "  1/1 identical to full decode: " << (identical ? "yes" : "no") << std::endl;
+    }
+    return identical ? 0 : 1;
+}
+
+// 推测式并行熵解码：把输入平铺（隔块镜像）成 20–100 MP 的图像，编码为无重启间隔的 JPEG，
+// 只计时熵解码，比较串行与 threadCount 个线程的耗时，报告同步的段数与重新解码的块比例
+static int benchSpeculative(const std::string &filename, int threadCount, const std::vector<int> &megapixels) {
+    ImageData header = loadHeader(filename);
+    ImageData decoded;
+    {
+        QuietStdout quiet;
+        if (!header.width || !header.height || decodeCopy(header, decoded) != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+    }
+    int channels = decoded.isGrayscale() ? 1 : 3;
+    std::vector<uint8_t> sourcePixels(bmpRowSize(decoded) * decoded.height, 0);
+    fillBMPRows(decoded, 0, decoded.mcuHeight, sourcePixels);
+    RawImage source = rawImageFromBMPRows(sourcePixels, decoded.width, decoded.height, channels);
+
+    std::cout << filename << " tiled, " << threadCount << " threads" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    bool identical = true;
+    for (int mp : megapixels) {
+        std::vector<uint8_t> encoded;
+        {
+            RawImage image;
+            image.width = static_cast<int>(std::sqrt(mp * 1e6 * 4 / 3));
+            image.height = static_cast<int>(mp * 1e6 / image.width);
+            image.channels = channels;
+            image.pixels.resize(static_cast<size_t>(image.width) * image.height * channels);
+            for (int row = 0; row < image.height; ++row) {
+                int tileRow = row / source.height, srcRow = row % source.height;
+                if (tileRow % 2) srcRow = source.height - 1 - srcRow;
+                for (int col = 0; col < image.width; ++col) {
+                    int tileCol = col / source.width, srcCol = col % source.width;
+                    if (tileCol % 2) srcCol = source.width - 1 - srcCol;
+                    std::memcpy(&image.pixels[(static_cast<size_t>(row) * image.width + col) * channels],
+                                &source.pixels[(static_cast<size_t>(srcRow) * source.width + srcCol) * channels],
+                                channels);
+                }
+            }
+            EncodeOptions options;
+            options.quality = 90;
+            encodeJPEG(image, options, encoded);
+        }
+        ImageData parsed = parseJPEGMemory(encoded.data(), encoded.size());
+        parsed.initializeHuffmanTables();
+        // 只分配熵解码写入的一维系数存储
+        parsed.initializeMcuLayout(parsed.width, parsed.height);
+        auto allocate = [&](ImageData &imgData) {
+            imgData.Y.assign(imgData.totalYBlocks, std::vector<Coefficient>(64, 0));
+            imgData.Cb.assign(imgData.hasChroma() ? imgData.totalCrCbBlocks : 0, std::vector<Coefficient>(64, 0));
+            imgData.Cr.assign(imgData.hasChroma() ? imgData.totalCrCbBlocks : 0, std::vector<Coefficient>(64, 0));
+        };
+        std::cout << "  " << mp << " MP (" << parsed.width << "x" << parsed.height << ", "
+                  << encoded.size() / (1024 * 1024) << " MB)" << std::endl;
+
+        ImageData serial = parsed;
+        allocate(serial);
+        auto start = std::chrono::steady_clock::now();
+        DecodeStatus serialStatus = huffmanDecode(serial.compressedData, serial);
+        double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        ImageData parallel = parsed;
+        parsed = ImageData();
+        allocate(parallel);
+        SpeculativeDecodeStats stats;
+        start = std::chrono::steady_clock::now();
+        DecodeStatus parallelStatus = speculativeHuffmanDecode(parallel.compressedData, parallel, threadCount, &stats);
+        double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        bool same = serialStatus == parallelStatus && serial.Y == parallel.Y && serial.Cb == parallel.Cb &&
+                    serial.Cr == parallel.Cr;
+        identical = identical && same;
+        std::cout << "    serial       " << std::setw(8) << serialMs << " ms" << std::endl;
+        std::cout << "    speculative  " << std::setw(8) << parallelMs << " ms  " << serialMs / parallelMs
+                  << "x, " << stats.syncedChunks << "/" << stats.chunks << " chunks synced, re-decoded "
+                  << stats.redecodedBlocks << " of " << stats.blocks << " blocks ("
+                  << std::setprecision(3) << 100.0 * stats.redecodedBlocks / std::max(stats.blocks, 1L) << "%)"
+                  << std::setprecision(1) << (same ? "" : "  MISMATCH") << std::endl;
+        std::cout << "      guess " << stats.guessMs << " ms, sync " << stats.syncMs << " ms (serial), decode "
+                  << stats.decodeMs << " ms" << std::endl;
+    }
+    std::cout << "  results identical: " << (identical ? "yes" : "no") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// 将输入按不同质量重新编码，只计时熵解码，比较逐位、单符号查表与多符号查表的符号吞吐；
+// 质量越低短码越多，多符号查表一次能解出两个符号的比例越高
+static int benchHuffman(const std::string &filename, int iterations) {
+    ImageData header = loadHeader(filename);
+    if (!header.width || !header.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return 1;
+    }
+    ImageData decoded;
+    {
+        QuietStdout quiet;
+        if (decodeCopy(header, decoded) != DecodeStatus::Ok) {
+            std::cerr << "解码失败: " << filename << std::endl;
+            return 1;
+        }
+    }
+    int channels = decoded.isGrayscale() ? 1 : 3;
+    std::vector<uint8_t> pixelData(bmpRowSize(decoded) * decoded.height, 0);
+    fillBMPRows(decoded, 0, decoded.mcuHeight, pixelData);
+    RawImage image = rawImageFromBMPRows(pixelData, decoded.width, decoded.height, channels);
+
+    std::cout << filename << " (" << image.width << "x" << image.height << ", " << iterations << " iterations)"
+              << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    const HuffmanDecodeMode modes[] = {HuffmanDecodeMode::BitSerial, HuffmanDecodeMode::SingleSymbol,
+                                       HuffmanDecodeMode::MultiSymbol};
+    bool identical = true;
+    for (int quality : {50, 75, 90, 95, 100}) {
+        EncodeOptions options;
+        options.quality = quality;
+        std::vector<uint8_t> encoded;
+        if (!encodeJPEG(image, options, encoded)) {
+            std::cerr << "编码失败: quality " << quality << std::endl;
+            return 1;
+        }
+        ImageData parsed = parseJPEGMemory(encoded.data(), encoded.size());
+        parsed.initializeHuffmanTables();
+
+        // 符号数：按编码器的规则统计解码出的系数会产生的 DC / AC 符号
+        ImageData reference = parsed;
+        reference.initializeBlocks(reference.width, reference.height);
+        if (huffmanDecode(reference.compressedData, reference, HuffmanDecodeMode::BitSerial) != DecodeStatus::Ok) {
+            std::cerr << "熵解码失败: quality " << quality << std::endl;
+            return 1;
+        }
+        HuffmanStatistics dcStats, acStats;
+        int previousDc[3] = {0, 0, 0};
+        for (int mcu = 0; mcu < reference.mcuWidth * reference.mcuHeight; ++mcu) {
+            if (reference.isGrayscale()) {
+                countBlockSymbols(reference.Y[mcu].data(), previousDc[0], dcStats, acStats);
+                continue;
+            }
+            for (int b = 0; b < 4; ++b) countBlockSymbols(reference.Y[mcu * 4 + b].data(), previousDc[0], dcStats, acStats);
+            countBlockSymbols(reference.Cb[mcu].data(), previousDc[1], dcStats, acStats);
+            countBlockSymbols(reference.Cr[mcu].data(), previousDc[2], dcStats, acStats);
+        }
+        long symbols = 0;
+        for (int s = 0; s < 256; ++s) symbols += dcStats.counts[s] + acStats.counts[s];
+
+        std::cout << "  quality " << quality << ": " << encoded.size() / 1024 << " KB, " << symbols << " symbols, "
+                  << 8.0 * parsed.compressedData.size() / symbols << " bits/symbol" << std::endl;
+        for (HuffmanDecodeMode mode : modes) {
+            double ms = 0;
+            ImageData imgData = parsed;
+            for (int i = 0; i < iterations; ++i) {
+                imgData.initializeBlocks(imgData.width, imgData.height);
+                auto start = std::chrono::steady_clock::now();
+                huffmanDecode(imgData.compressedData, imgData, mode);
+                ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            ms /= iterations;
+            identical = identical && imgData.Y == reference.Y && imgData.Cb == reference.Cb && imgData.Cr == reference.Cr;
+            std::cout << "    " << std::left << std::setw(14) << huffmanDecodeModeName(mode) << std::right
+                      << std::setw(9) << ms << " ms" << std::setw(9) << symbols / ms / 1000.0 << " Msymbols/s"
+                      << std::endl;
+        }
+    }
+    std::cout << "  results identical: " << (identical ? "yes" : "no") << std::endl;
+    return identical ? 0 : 1;
+}
+
+// 每幅图像重复解码 iterations 次，逐阶段采样硬件计数器；先报告每幅图像，再报告整个语料的合计
+static int benchPerf(const std::vector<std::string> &filenames, int iterations) {
+    PerfCounters counters;
+    if (!counters.available()) {
+        std::cout << "hardware counters unavailable (" << counters.error() << "), reporting wall time only"
+                  << std::endl;
+    }
+    DecodeStageProfile corpus;
+    for (const auto &filename : filenames) {
+        ImageData header = loadHeader(filename);
+        if (!header.width || !header.height || !header.hasSupportedSampling()) {
+            std::cerr << "解析图像头部失败: " << filename << std::endl;
+            return 1;
+        }
+        DecodeStageProfile image;
+        std::vector<uint8_t> pixelData(static_cast<size_t>(bmpRowSize(header)) * header.height, 0);
+        for (int i = 0; i < iterations; ++i) {
+            ImageData imgData = header;
+            imgData.initializeBlocks(imgData.width, imgData.height);
+            DecodeStageProfile profile;
+            DecodeStatus status = decodeJPEGProfiled(imgData, pixelData, counters, profile);
+            if (status != DecodeStatus::Ok) {
+                std::cerr << filename << ": 解码失败: " << decodeStatusMessage(status) << std::endl;
+                return 1;
+            }
+            image += profile;
+        }
+        std::cout << filename << " (" << header.width << "x" << header.height << ", " << iterations
+                  << " decodes, totals):" << std::endl;
+        printDecodeStageProfile(std::cout, image);
+        corpus += image;
+    }
+    if (filenames.size() > 1) {
+        std::cout << "all " << filenames.size() << " images (" << corpus.images << " decodes, totals):" << std::endl;
+        printDecodeStageProfile(std::cout, corpus);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    // 用法: jpeg_bench <mode> ...
+    //   luma   [输入 JPEG] [迭代次数]                 完整解码 vs 仅亮度解码
+    //   stress <线程数> <每线程迭代次数> <JPEG...>    多线程并发解码一致性检查
+    //   verify [输入 JPEG] [迭代次数]                 熵数据校验 vs 完整解码
+    //   phash [输入 JPEG] [迭代次数]                  解码后哈希 vs DCT 域哈希
+    //   rotate [输入 JPEG] [迭代次数] [变换]          像素域旋转 vs DCT 域无损旋转（默认 rot90）
+    //   encode [输入 JPEG] [迭代次数] [线程数]        编码吞吐（4:2:0 / 4:4:4 / 重启间隔并行）
+    //   optimize [输入 JPEG] [迭代次数]               无损哈夫曼表重新优化的压缩率与吞吐
+    //   tile [输入 JPEG] [区域边长] [区域数] [检查点间隔]  有无 MCU 索引时的区域解码延迟
+    //   pipeline [输入 JPEG] [迭代次数] [重建线程数] [环形队列深度]  单线程 vs 流水线解码
+    //   mjpeg [输入 JPEG] [帧数] [线程数]             1080p / 4K MJPEG 流的持续解码帧率
+    //   chunked [随机分块轮数] [JPEG...]              分块送入增量解码器，结果与整文件解码一致性检查
+    //   server [输入 JPEG] [客户端数] [每客户端请求数] [套接字]  解码服务 vs 每图一个进程的吞吐与延迟
+    //   trace [输入 JPEG] [迭代次数] [重建线程数] [输出 JSON]  追踪关闭 / 开启时的流水线解码耗时，写出时间线
+    //   dequant [输入 JPEG] [迭代次数]                32 位系数逆量化 vs 16 位标量 / SSE2 / AVX2 的带宽与缓存未命中
+    //   perf [迭代次数] [JPEG...]                     各解码阶段的耗时、IPC 与每 MCU 的分支预测失败 / 缓存未命中
+    //   huffman [输入 JPEG] [迭代次数]                不同质量下逐位 / 单符号查表 / 多符号查表熵解码的符号吞吐
+    //   output [输入 JPEG] [迭代次数]                 BMP、BMP 再转 RGBA、直接输出 RGB / RGBA / YUV 平面的耗时
+    //   speculative [输入 JPEG] [线程数] [百万像素...]  无重启间隔的 20–100 MP 图像上串行 vs 推测式并行熵解码
+    //   cache [输入 JPEG] [线程数] [每线程请求数] [图像数] [Zipf 指数] [内存层 MB]  Zipf 请求序列下无缓存 / 内存 LRU / 加磁盘层的吞吐与命中率
+    //   pyramid [输入 JPEG] [迭代次数] [比例列表]     每个尺寸各解码一次 vs 一次解码输出 1/1、1/2、1/4、1/8 多级图像
+    //   qoi [迭代次数] [JPEG...]                      解码后写 BMP vs 流式 QOI 的端到端耗时与写出字节数
+    std::string mode = argc > 1 ? argv[1] : "luma";
+
+    if (mode == "luma") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 10;
+        return benchLuma(filename, iterations);
+    }
+    if (mode == "verify") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        return benchVerify(filename, iterations);
+    }
+    if (mode == "phash") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        return benchPhash(filename, iterations);
+    }
+    if (mode == "rotate") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        DctTransform transform = DctTransform::Rotate90;
+        if (argc > 4 && !parseDctTransform(argv[4], transform)) {
+            std::cerr << "未知变换: " << argv[4] << std::endl;
+            return 1;
+        }
+        return benchRotate(filename, iterations, transform);
+    }
+    if (mode == "encode") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 10;
+        int threadCount = argc > 4 ? std::stoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency());
+        return benchEncode(filename, iterations, std::max(threadCount, 1));
+    }
+    if (mode == "optimize") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        return benchOptimize(filename, iterations);
+    }
+    if (mode == "tile") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int tileSize = argc > 3 ? std::stoi(argv[3]) : 256;
+        int tileCount = argc > 4 ? std::stoi(argv[4]) : 20;
+        int interval = argc > 5 ? std::stoi(argv[5]) : 0;
+        return benchTile(filename, tileSize, tileCount, interval);
+    }
+    if (mode == "pipeline") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        int threadCount = argc > 4 ? std::stoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency()) - 1;
+        int ringDepth = argc > 5 ? std::stoi(argv[5]) : 8;
+        return benchPipeline(filename, iterations, std::max(threadCount, 1), ringDepth);
+    }
+    if (mode == "mjpeg") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int frameCount = argc > 3 ? std::stoi(argv[3]) : 12;
+        int threadCount = argc > 4 ? std::stoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency());
+        return benchMjpeg(filename, std::max(frameCount, 1), std::max(threadCount, 1));
+    }
+    if (mode == "chunked") {
+        int rounds = argc > 2 ? std::stoi(argv[2]) : 8;
+        std::vector<std::string> filenames(argv + std::min(argc, 3), argv + argc);
+        if (filenames.empty()) filenames.push_back("../input/lena.jpg");
+        return benchChunked(filenames, rounds);
+    }
+    if (mode == "server") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int clients = argc > 3 ? std::stoi(argv[3]) : 4;
+        int requests = argc > 4 ? std::stoi(argv[4]) : 50;
+        std::string socketPath = argc > 5 ? argv[5] : "";
+        std::string parserPath = (std::filesystem::path(argv[0]).parent_path() / "jpeg_parser").string();
+        return benchServer(filename, std::max(clients, 1), std::max(requests, 1), socketPath, parserPath);
+    }
+    if (mode == "trace") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        int threadCount = argc > 4 ? std::stoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency()) - 1;
+        std::string traceFile = argc > 5 ? argv[5] : "jpeg_bench_trace.json";
+        return benchTrace(filename, std::max(iterations, 1), std::max(threadCount, 1), traceFile);
+    }
+    if (mode == "dequant") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 10;
+        return benchDequant(filename, std::max(iterations, 1));
+    }
+    if (mode == "output") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 10;
+        return benchOutput(filename, std::max(iterations, 1));
+    }
+    if (mode == "speculative") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int threadCount = argc > 3 ? std::stoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+        std::vector<int> megapixels;
+        for (int i = 4; i < argc; ++i) megapixels.push_back(std::stoi(argv[i]));
+        if (megapixels.empty()) megapixels = {20, 50, 100};
+        return benchSpeculative(filename, std::max(threadCount, 1), megapixels);
+    }
+    if (mode == "huffman") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        return benchHuffman(filename, std::max(iterations, 1));
+    }
+    if (mode == "cache") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int threadCount = argc > 3 ? std::stoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+        int requests = argc > 4 ? std::stoi(argv[4]) : 200;
+        int catalogSize = argc > 5 ? std::stoi(argv[5]) : 240;
+        double zipfExponent = argc > 6 ? std::stod(argv[6]) : 1.0;
+        int memoryMB = argc > 7 ? std::stoi(argv[7]) : 0;
+        return benchCache(filename, std::max(threadCount, 1), std::max(requests, 1), std::max(catalogSize, 1),
+                          zipfExponent, memoryMB);
+    }
+    if (mode == "pyramid") {
+        std::string filename = argc > 2 ? argv[2] : "../input/lena.jpg";
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 5;
+        std::vector<int> scales;
+        if (!parsePyramidScales(argc > 4 ? argv[4] : "1,2,4,8", scales)) {
+            std::cerr << "无效的比例列表: " << argv[4] << std::endl;
+            return 1;
+        }
+        return benchPyramid(filename, std::max(iterations, 1), scales);
+    }
+    if (mode == "qoi") {
+        int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+        std::vector<std::string> filenames(argv + std::min(argc, 3), argv + argc);
+        if (filenames.empty()) filenames.push_back("../input/lena.jpg");
+        return benchQoi(filenames, std::max(iterations, 1));
+    }
+    if (mode == "perf") {
+        int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+        std::vector<std::string> filenames(argv + std::min(argc, 3), argv + argc);
+        if (filenames.empty()) filenames.push_back("../input/lena.jpg");
+        return benchPerf(filenames, std::max(iterations, 1));
+    }
+    if (mode == "stress") {
+        int threadCount = argc > 2 ? std::stoi(argv[2]) : 8;
+        int iterations = argc > 3 ? std::stoi(argv[3]) : 4;
+        std::vector<std::string> filenames(argv + std::min(argc, 4), argv + argc);
+        if (filenames.empty()) filenames.push_back("../input/lena.jpg");
+        return benchStress(filenames, threadCount, iterations);
+    }
+
+    std::cerr << "未知模式: " << mode << std::endl;
+    return 1;
+}
@@ -0,0 +1,260 @@
+#include "jpeg_header_parser.h"
+#include "jpeg_decoder.h"
+#include "jpeg_encoder.h"
+#include "save_as_bmp.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+
+// libjpeg 出错时跳回调用处，而不是默认的 exit()
+struct LibjpegError {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+};
+
+static void libjpegErrorExit(j_common_ptr info) {
+    std::longjmp(reinterpret_cast<LibjpegError *>(info->err)->jump, 1);
+}
+
+// 不打印消息，只统计警告（默认实现在 msg_level 为 -1 时累加 num_warnings）
+static void libjpegCountWarnings(j_common_ptr info, int level) {
+    if (level < 0) info->err->num_warnings++;
+}
+
+// 用 libjpeg 解码到自上而下、紧密排列的像素。matched 为 true 时使用与本解码器相同的
+// 浮点 IDCT 与不插值的色度上采样，作为逐像素比较的参考；否则用默认设置计时。
+// 有警告（数据损坏）或出错时返回 false
+static bool decodeWithLibjpeg(const std::vector<uint8_t> &data, bool matched, RawImage &image) {
+    jpeg_decompress_struct info;
+    LibjpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = libjpegErrorExit;
+    error.manager.emit_message = libjpegCountWarnings;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, const_cast<unsigned char *>(data.data()), data.size());
+    jpeg_read_header(&info, TRUE);
+    if (matched) {
+        info.dct_method = JDCT_FLOAT;
+        info.do_fancy_upsampling = FALSE;
+    }
+    jpeg_start_decompress(&info);
+    image.width = info.output_width;
+    image.height = info.output_height;
+    image.channels = info.output_components;
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * image.channels);
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = &image.pixels[static_cast<size_t>(info.output_scanline) * image.width * image.channels];
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_decompress(&info);
+    bool clean = error.manager.num_warnings == 0;
+    jpeg_destroy_decompress(&info);
+    return clean;
+}
+
+// 本解码器：从内存解析、解码并转换为与 libjpeg 相同的像素布局
+static DecodeStatus decodeWithCore(const std::vector<uint8_t> &data, RawImage &image) {
+    ImageData imgData = parseJPEGMemory(data.data(), data.size());
+    if (!imgData.width || !imgData.height || !imgData.hasSupportedSampling() || !imgData.hasRequiredQuantTables()) {
+        return DecodeStatus::InvalidHeader;
+    }
+    imgData.initializeHuffmanTables();
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    DecodeStatus status = decodeJPEG(imgData, imgData.compressedData);
+    if (status != DecodeStatus::Ok) return status;
+    std::vector<uint8_t> pixelData(static_cast<size_t>(bmpRowSize(imgData)) * imgData.height, 0);
+    fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+    image = rawImageFromBMPRows(pixelData, imgData.width, imgData.height, imgData.isGrayscale() ? 1 : 3);
+    return DecodeStatus::Ok;
+}
+
+// 重复 iterations 次取最快的一次（秒），减少调度噪声
+template <typename Decode>
+static double fastestSeconds(int iterations, Decode decode) {
+    double best = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        decode();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+static bool isJPEGFile(const std::filesystem::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".jpg" || extension == ".jpeg";
+}
+
+// 基线文件：每行 "<路径> <相对 libjpeg 的速度比>"，# 开头为注释
+static std::map<std::string, double> loadBaseline(const std::string &filename) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t space = line.rfind(' ');
+        if (space == std::string::npos) continue;
+        baseline[line.substr(0, space)] = std::stod(line.substr(space + 1));
+    }
+    return baseline;
+}
+
+int main(int argc, char *argv[]) {
+    // 用法: jpeg_compare [选项] <JPEG 或目录...>
+    // 用本解码器与 libjpeg 分别解码语料，报告逐图 PSNR / 最大绝对误差与两者的 MP/s
+    // --min-psnr D: PSNR 低于 D dB 判为失败，默认 40
+    // --max-error N: 最大绝对误差超过 N 判为失败，默认 10
+    // --iterations N: 每个解码器计时 N 次取最快，默认 3
+    // --baseline F: 与 F 中记录的速度比（本解码器 / libjpeg）比较，下降超过 --tolerance 判为失败
+    // --tolerance T: 允许的速度比下降比例，默认 0.25
+    // --save-baseline F: 把本次的速度比写入 F
+    double minPsnr = 40.0;
+    int maxError = 10;
+    int iterations = 3;
+    double tolerance = 0.25;
+    std::string baselineFile, saveBaselineFile;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--min-psnr" && i + 1 < argc) {
+            minPsnr = std::stod(argv[++i]);
+        } else if (arg == "--max-error" && i + 1 < argc) {
+            maxError = std::stoi(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(std::stoi(argv[++i]), 1);
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselineFile = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = std::stod(argv[++i]);
+        } else if (arg == "--save-baseline" && i + 1 < argc) {
+            saveBaselineFile = argv[++i];
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            // 未知选项或缺少参数值的选项，不当作文件名
+            std::cerr << "未知选项: " << arg << std::endl;
+            std::cerr << "用法: jpeg_compare [--min-psnr D] [--max-error N] [--iterations N] [--baseline F] "
+                         "[--tolerance T] [--save-baseline F] [JPEG 或目录...]" << std::endl;
+            return -1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) inputs.push_back("../input");
+
+    std::vector<std::string> files;
+    for (const std::string &input : inputs) {
+        std::error_code error;
+        if (std::filesystem::is_directory(input, error)) {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(input, error)) {
+                if (entry.is_regular_file() && isJPEGFile(entry.path())) files.push_back(entry.path().string());
+            }
+        } else {
+            files.push_back(input);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    std::map<std::string, double> baseline;
+    if (!baselineFile.empty()) baseline = loadBaseline(baselineFile);
+
+    std::cout << std::left << std::setw(40) << "file" << std::right << std::setw(12) << "size" << std::setw(9)
+              << "PSNR" << std::setw(8) << "maxerr" << std::setw(11) << "ours MP/s" << std::setw(14) << "libjpeg MP/s"
+              << std::setw(8) << "ratio" << "  result" << std::endl;
+    std::cout << std::fixed;
+
+    int failed = 0, skipped = 0, passed = 0;
+    std::ostringstream savedBaseline;
+    savedBaseline << "# jpeg_compare baseline: <path> <decode speed relative to libjpeg>\n";
+    for (const std::string &file : files) {
+        std::ifstream stream(file, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        std::cout << std::left << std::setw(40) << file << std::right;
+        if (!stream.is_open()) {
+            std::cout << "  FAIL: cannot open file" << std::endl;
+            failed++;
+            continue;
+        }
+
+        RawImage reference, ours;
+        if (!decodeWithLibjpeg(data, true, reference)) {
+            std::cout << "  skipped: libjpeg reports corrupt data" << std::endl;
+            skipped++;
+            continue;
+        }
+        DecodeStatus status = decodeWithCore(data, ours);
+        if (status == DecodeStatus::InvalidHeader) {
+            std::cout << "  skipped: unsupported by this decoder" << std::endl;
+            skipped++;
+            continue;
+        }
+        if (status != DecodeStatus::Ok || ours.width != reference.width || ours.height != reference.height ||
+            ours.channels != reference.channels) {
+            std::cout << "  FAIL: " << (status != DecodeStatus::Ok ? decodeStatusMessage(status) : "size mismatch")
+                      << std::endl;
+            failed++;
+            continue;
+        }
+
+        double squaredError = 0;
+        int worst = 0;
+        for (size_t i = 0; i < ours.pixels.size(); ++i) {
+            int diff = std::abs(static_cast<int>(ours.pixels[i]) - reference.pixels[i]);
+            squaredError += static_cast<double>(diff) * diff;
+            worst = std::max(worst, diff);
+        }
+        double mse = squaredError / ours.pixels.size();
+        double psnr = mse > 0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+
+        RawImage scratch;
+        double oursSeconds = fastestSeconds(iterations, [&]() { decodeWithCore(data, scratch); });
+        double libjpegSeconds = fastestSeconds(iterations, [&]() { decodeWithLibjpeg(data, false, scratch); });
+        double megapixels = static_cast<double>(ours.width) * ours.height / 1e6;
+        double ratio = libjpegSeconds / oursSeconds;
+        savedBaseline << file << " " << ratio << "\n";
+
+        std::string result = "ok";
+        if (psnr < minPsnr || worst > maxError) {
+            result = "FAIL: error above threshold";
+        } else if (baseline.count(file) && ratio < baseline[file] * (1.0 - tolerance)) {
+            std::ostringstream message;
+            message << std::fixed << std::setprecision(3) << "FAIL: speed ratio fell from " << baseline[file];
+            result = message.str();
+        }
+        std::string size = std::to_string(ours.width) + "x" + std::to_string(ours.height);
+        std::cout << std::setw(12) << size << std::setprecision(2) << std::setw(9) << psnr << std::setw(8) << worst
+                  << std::setw(11) << megapixels / oursSeconds << std::setw(14) << megapixels / libjpegSeconds
+                  << std::setprecision(3) << std::setw(8) << ratio << "  " << result << std::endl;
+        if (result == "ok") {
+            passed++;
+        } else {
+            failed++;
+        }
+    }
+
+    if (!saveBaselineFile.empty()) {
+        std::ofstream(saveBaselineFile) << savedBaseline.str();
+    }
+    std::cout << passed << " passed, " << failed << " failed, " << skipped << " skipped" << std::endl;
+    if (!passed && !failed) {
+        std::cerr << "没有可比较的图像" << std::endl;
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
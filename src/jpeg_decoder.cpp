@@ -1,13 +1,21 @@
 #include "jpeg_decoder.h"
 #include "huffman_decoder.h"
+#include "decode_trace.h"
 #include "jpeg_parser_helpers.h"
 #include "inverse_dct.h"   // 假设逆DCT放在此文件中
 #include "inverse_quantize.h" // 假设逆量化放在此文件中
 #include "inverse_zigzag.h"
 
-void decodeJPEG(ImageData &imgData, const std::vector<uint8_t> &compressedData) {
+DecodeStatus decodeJPEG(ImageData &imgData, const std::vector<uint8_t> &compressedData) {
     // Step 1: 哈夫曼解码
-    huffmanDecode(compressedData, imgData);
+    DecodeStatus status = huffmanDecode(compressedData, imgData);
+    if (status != DecodeStatus::Ok) return status;
+    reconstructImage(imgData);
+    return DecodeStatus::Ok;
+}
+
+void reconstructImage(ImageData &imgData) {
+    TraceScope trace("reconstruct");
     // Step 2: 逆量化
     inverseQuantize(imgData); // 使用量化表
     // step 3: zigzag
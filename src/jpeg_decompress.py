@@ -1,5 +1,7 @@
 from struct import unpack
 
+import jpeg_native
+
 marker_mapping = {
     0xffd8: "Start of Image",
     0xffe0: "Application Default Header",
@@ -16,29 +18,22 @@ class JPEG:
             self.img_data = f.read()
     
     def decode(self):
+        """打印各标记段，然后在进程内解码并返回像素（见 jpeg_native.py）"""
         data = self.img_data
-        sos_data = None  # 用于保存 Start of Scan 数据
-        while True:
+        while len(data) >= 2:
             marker, = unpack(">H", data[0:2])
             print(marker_mapping.get(marker))
 
             if marker == 0xffd8:
                 data = data[2:]
-            elif marker == 0xffd9:
-                return
-            elif marker == 0xffda:
-                sos_data = data[2:-2]  # 提取 SOS 段数据，忽略文件末尾的 EOI（End of Image）
-                breakpoint()
-                with open("../input/sos_segment.bin", "wb") as f:
-                    f.write(sos_data)  # 将 SOS 段数据写入 .bin 文件
-                return
+            elif marker in (0xffd9, 0xffda):
+                break
             else:
                 lenchunk, = unpack(">H", data[2:4])
-                data = data[2+lenchunk:]            
-
-            if len(data) == 0:
-                break
+                data = data[2+lenchunk:]
+        return jpeg_native.decode(self.img_data)
 
 if __name__ == "__main__":
     img = JPEG('../input/lena.jpg')
-    img.decode()
+    pixels = img.decode()
+    print(pixels.shape)
@@ -0,0 +1,61 @@
+#include "jpeg_encoder.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+    // 用法: jpeg_encode [选项] <输入 BMP 或 RGB> <输出 JPEG>
+    // --quality Q: 质量 1..100，默认 75
+    // --444: 不做色度下采样（默认 4:2:0）
+    // --restart N: 每 N 个 MCU 插入重启标记
+    // --threads N: 有重启标记时并行编码各间隔
+    // --raw WxH: 输入为紧密排列的 RGB 原始像素；--gray 时为单通道
+    EncodeOptions options;
+    int rawWidth = 0, rawHeight = 0;
+    int rawChannels = 3;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quality" && i + 1 < argc) {
+            options.quality = std::stoi(argv[++i]);
+        } else if (arg == "--444") {
+            options.subsampling = ChromaSubsampling::Yuv444;
+        } else if (arg == "--restart" && i + 1 < argc) {
+            options.restartInterval = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threadCount = std::stoi(argv[++i]);
+        } else if (arg == "--raw" && i + 1 < argc) {
+            std::string size = argv[++i];
+            size_t x = size.find('x');
+            if (x == std::string::npos) {
+                std::cerr << "无效的尺寸: " << size << std::endl;
+                return -1;
+            }
+            rawWidth = std::stoi(size.substr(0, x));
+            rawHeight = std::stoi(size.substr(x + 1));
+        } else if (arg == "--gray") {
+            rawChannels = 1;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.size() < 2) {
+        std::cerr << "用法: jpeg_encode [--quality Q] [--444] [--restart N] [--threads N] [--raw WxH [--gray]] "
+                     "<输入> <输出 JPEG>" << std::endl;
+        return -1;
+    }
+
+    RawImage image;
+    bool loaded = rawWidth > 0 ? loadRawImage(args[0], rawWidth, rawHeight, rawChannels, image)
+                               : loadBMP(args[0], image);
+    if (!loaded) {
+        std::cerr << "无法读取输入图像: " << args[0] << std::endl;
+        return -1;
+    }
+    if (!saveAsJPEG(args[1], image, options)) {
+        std::cerr << "编码失败: " << args[1] << std::endl;
+        return -1;
+    }
+    std::cout << "已编码 " << image.width << "x" << image.height << " -> " << args[1] << std::endl;
+    return 0;
+}
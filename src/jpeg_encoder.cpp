@@ -0,0 +1,659 @@
+#include "jpeg_encoder.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+// 自然顺序下标 -> Zig-Zag 下标
+static const int zigzagIndex[64] = {
+     0,  1,  5,  6, 14, 15, 27, 28,
+     2,  4,  7, 13, 16, 26, 29, 42,
+     3,  8, 12, 17, 25, 30, 41, 43,
+     9, 11, 18, 24, 31, 40, 44, 53,
+    10, 19, 23, 32, 39, 45, 52, 54,
+    20, 22, 33, 38, 46, 51, 55, 60,
+    21, 34, 37, 47, 50, 56, 59, 61,
+    35, 36, 48, 49, 57, 58, 62, 63};
+
+// 标准量化表（JPEG 标准附录 K.1），自然顺序
+static const int standardQuantTables[2][64] = {
+    {16, 11, 10, 16, 24, 40, 51, 61,
+     12, 12, 14, 19, 26, 58, 60, 55,
+     14, 13, 16, 24, 40, 57, 69, 56,
+     14, 17, 22, 29, 51, 87, 80, 62,
+     18, 22, 37, 56, 68, 109, 103, 77,
+     24, 35, 55, 64, 81, 104, 113, 92,
+     49, 64, 78, 87, 103, 121, 120, 101,
+     72, 92, 95, 98, 112, 100, 103, 99},
+    {17, 18, 24, 47, 99, 99, 99, 99,
+     18, 21, 26, 66, 99, 99, 99, 99,
+     24, 26, 56, 99, 99, 99, 99, 99,
+     47, 66, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99}};
+
+// 标准哈夫曼表（JPEG 标准附录 K.3）：各码长的码字个数与符号
+static const int dcLumaLengths[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const int dcChromaLengths[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+static const int dcSymbols[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const int acLumaLengths[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+static const int acLumaSymbols[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa};
+
+static const int acChromaLengths[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+static const int acChromaSymbols[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa};
+
+void buildHuffmanEncodeTable(const std::vector<int> &lengths, const std::vector<int> &symbols, int tableClass,
+                             int tableId, HuffmanEncodeTable &table) {
+    table.spec.tableClass = tableClass;
+    table.spec.tableId = tableId;
+    table.spec.lengths = lengths;
+    table.spec.symbols = symbols;
+
+    // 规范哈夫曼码：同一码长内码字依次加一，码长增加时左移一位
+    int code = 0;
+    size_t symbolIndex = 0;
+    for (int length = 1; length <= 16; ++length) {
+        for (int i = 0; i < lengths[length - 1] && symbolIndex < symbols.size(); ++i) {
+            int symbol = symbols[symbolIndex++];
+            table.code[symbol] = static_cast<uint16_t>(code++);
+            table.size[symbol] = static_cast<uint8_t>(length);
+        }
+        code <<= 1;
+    }
+}
+
+static HuffmanEncodeTable makeStandardTable(const int *lengths, const int *symbols, int tableClass, int tableId) {
+    std::vector<int> lengthVector(lengths, lengths + 16);
+    int count = 0;
+    for (int len : lengthVector) count += len;
+    HuffmanEncodeTable table;
+    buildHuffmanEncodeTable(lengthVector, std::vector<int>(symbols, symbols + count), tableClass, tableId, table);
+    return table;
+}
+
+const HuffmanEncodeTable &standardDcTable(int tableId) {
+    static const HuffmanEncodeTable tables[2] = {makeStandardTable(dcLumaLengths, dcSymbols, 0, 0),
+                                                 makeStandardTable(dcChromaLengths, dcSymbols, 0, 1)};
+    return tables[tableId ? 1 : 0];
+}
+
+const HuffmanEncodeTable &standardAcTable(int tableId) {
+    static const HuffmanEncodeTable tables[2] = {makeStandardTable(acLumaLengths, acLumaSymbols, 1, 0),
+                                                 makeStandardTable(acChromaLengths, acChromaSymbols, 1, 1)};
+    return tables[tableId ? 1 : 0];
+}
+
+std::vector<int> scaledQuantTable(int tableId, int quality) {
+    quality = std::max(1, std::min(100, quality));
+    int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    std::vector<int> table(64);
+    for (int i = 0; i < 64; ++i) {
+        int value = (standardQuantTables[tableId ? 1 : 0][i] * scale + 50) / 100;
+        table[zigzagIndex[i]] = std::max(1, std::min(255, value));  // 基线 JPEG 量化值为 8 位
+    }
+    return table;
+}
+
+void JpegBitWriter::emitWord() {
+    uint32_t word = static_cast<uint32_t>(buffer >> (bitCount - 32));
+    bitCount -= 32;
+
+    // 快速路径：4 个字节都不是 0xFF 时不需要填充
+    uint32_t inverted = ~word;
+    if (((inverted - 0x01010101u) & ~inverted & 0x80808080u) == 0) {
+        out.push_back(static_cast<uint8_t>(word >> 24));
+        out.push_back(static_cast<uint8_t>(word >> 16));
+        out.push_back(static_cast<uint8_t>(word >> 8));
+        out.push_back(static_cast<uint8_t>(word));
+        return;
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        uint8_t byte = static_cast<uint8_t>(word >> shift);
+        out.push_back(byte);
+        if (byte == 0xFF) out.push_back(0x00);
+    }
+}
+
+void JpegBitWriter::flush() {
+    int padding = (8 - bitCount % 8) % 8;
+    if (padding) putBits((1u << padding) - 1, padding);
+    while (bitCount > 0) {
+        uint8_t byte = static_cast<uint8_t>(buffer >> (bitCount - 8));
+        bitCount -= 8;
+        out.push_back(byte);
+        if (byte == 0xFF) out.push_back(0x00);
+    }
+    buffer = 0;
+}
+
+// 幅值的位数（JPEG 的 SSSS 类别）
+static int magnitudeBits(int value) {
+    int bits = 0;
+    while (value) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+void encodeBlock(JpegBitWriter &writer, const Coefficient *block, int &previousDc,
+                 const HuffmanEncodeTable &dcTable, const HuffmanEncodeTable &acTable) {
+    // DC 差分：哈夫曼码与附加比特合并写出；负数写 value-1 的低位
+    int diff = block[0] - previousDc;
+    previousDc = block[0];
+    int magnitude = diff < 0 ? -diff : diff;
+    int bits = magnitudeBits(magnitude);
+    uint32_t extra = static_cast<uint32_t>(diff < 0 ? diff - 1 : diff) & ((1u << bits) - 1);
+    writer.putBits((static_cast<uint32_t>(dcTable.code[bits]) << bits) | extra, dcTable.size[bits] + bits);
+
+    int run = 0;
+    for (int k = 1; k < 64; ++k) {
+        int value = block[k];
+        if (value == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {  // ZRL：16 个零
+            writer.putBits(acTable.code[0xF0], acTable.size[0xF0]);
+            run -= 16;
+        }
+        magnitude = value < 0 ? -value : value;
+        bits = magnitudeBits(magnitude);
+        extra = static_cast<uint32_t>(value < 0 ? value - 1 : value) & ((1u << bits) - 1);
+        int symbol = (run << 4) | bits;
+        writer.putBits((static_cast<uint32_t>(acTable.code[symbol]) << bits) | extra, acTable.size[symbol] + bits);
+        run = 0;
+    }
+    if (run > 0) {
+        writer.putBits(acTable.code[0x00], acTable.size[0x00]);  // EOB
+    }
+}
+
+static void putMarker(std::vector<uint8_t> &out, uint8_t marker) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+}
+
+static void putBigEndian16(std::vector<uint8_t> &out, int value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void writeHuffmanTable(std::vector<uint8_t> &out, const HuffmanEncodeTable &table) {
+    putMarker(out, DHT);
+    putBigEndian16(out, 2 + 1 + 16 + static_cast<int>(table.spec.symbols.size()));
+    out.push_back(static_cast<uint8_t>((table.spec.tableClass << 4) | table.spec.tableId));
+    for (int len : table.spec.lengths) out.push_back(static_cast<uint8_t>(len));
+    for (int symbol : table.spec.symbols) out.push_back(static_cast<uint8_t>(symbol));
+}
+
+void writeJPEGHeaders(std::vector<uint8_t> &out, int width, int height, int components, ChromaSubsampling subsampling,
+                      const std::vector<int> *quantTables[2], const HuffmanEncodeTable *dcTables[2],
+                      const HuffmanEncodeTable *acTables[2], int restartInterval) {
+    putMarker(out, SOI);
+
+    // APP0 (JFIF 1.01，无缩略图)
+    static const uint8_t jfif[] = {0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01,
+                                   0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+    out.insert(out.end(), jfif, jfif + sizeof(jfif));
+
+    int tableCount = components == 1 ? 1 : 2;
+    for (int t = 0; t < tableCount; ++t) {
+        putMarker(out, DQT);
+        putBigEndian16(out, 2 + 1 + 64);
+        out.push_back(static_cast<uint8_t>(t));  // 8 位精度
+        for (int q : *quantTables[t]) out.push_back(static_cast<uint8_t>(q));
+    }
+
+    putMarker(out, SOF0);
+    putBigEndian16(out, 8 + 3 * components);
+    out.push_back(8);
+    putBigEndian16(out, height);
+    putBigEndian16(out, width);
+    out.push_back(static_cast<uint8_t>(components));
+    for (int c = 0; c < components; ++c) {
+        int sampling = (c == 0 && subsampling == ChromaSubsampling::Yuv420 && components == 3) ? 0x22 : 0x11;
+        out.push_back(static_cast<uint8_t>(c + 1));
+        out.push_back(static_cast<uint8_t>(sampling));
+        out.push_back(static_cast<uint8_t>(c == 0 ? 0 : 1));
+    }
+
+    for (int t = 0; t < tableCount; ++t) {
+        writeHuffmanTable(out, *dcTables[t]);
+        writeHuffmanTable(out, *acTables[t]);
+    }
+
+    if (restartInterval > 0) {
+        putMarker(out, DRI);
+        putBigEndian16(out, 4);
+        putBigEndian16(out, restartInterval);
+    }
+
+    putMarker(out, SOS);
+    putBigEndian16(out, 6 + 2 * components);
+    out.push_back(static_cast<uint8_t>(components));
+    for (int c = 0; c < components; ++c) {
+        out.push_back(static_cast<uint8_t>(c + 1));
+        out.push_back(static_cast<uint8_t>(c == 0 ? 0x00 : 0x11));
+    }
+    out.push_back(0);   // Ss
+    out.push_back(63);  // Se
+    out.push_back(0);   // Ah/Al
+}
+
+// 定点正 DCT（LLM 算法，13 位定点常数），结果比正交 DCT 放大 8 倍，由量化除数吸收
+constexpr int CONST_BITS = 13;
+constexpr int PASS1_BITS = 2;
+constexpr int FIX_0_298631336 = 2446;
+constexpr int FIX_0_390180644 = 3196;
+constexpr int FIX_0_541196100 = 4433;
+constexpr int FIX_0_765366865 = 6270;
+constexpr int FIX_0_899976223 = 7373;
+constexpr int FIX_1_175875602 = 9633;
+constexpr int FIX_1_501321110 = 12299;
+constexpr int FIX_1_847759065 = 15137;
+constexpr int FIX_1_961570560 = 16069;
+constexpr int FIX_2_053119869 = 16819;
+constexpr int FIX_2_562915447 = 20995;
+constexpr int FIX_3_072711026 = 25172;
+
+static inline int descale(int value, int bits) {
+    return (value + (1 << (bits - 1))) >> bits;
+}
+
+// 一维 8 点变换；pass 0 处理行（输出左移 PASS1_BITS 保留精度），pass 1 处理列
+static inline void fdct8(int *d, int stride, int pass) {
+    int tmp0 = d[0] + d[7 * stride];
+    int tmp7 = d[0] - d[7 * stride];
+    int tmp1 = d[stride] + d[6 * stride];
+    int tmp6 = d[stride] - d[6 * stride];
+    int tmp2 = d[2 * stride] + d[5 * stride];
+    int tmp5 = d[2 * stride] - d[5 * stride];
+    int tmp3 = d[3 * stride] + d[4 * stride];
+    int tmp4 = d[3 * stride] - d[4 * stride];
+
+    // 偶数部分
+    int tmp10 = tmp0 + tmp3;
+    int tmp13 = tmp0 - tmp3;
+    int tmp11 = tmp1 + tmp2;
+    int tmp12 = tmp1 - tmp2;
+    int shift = pass == 0 ? CONST_BITS - PASS1_BITS : CONST_BITS + PASS1_BITS;
+    if (pass == 0) {
+        d[0] = (tmp10 + tmp11) << PASS1_BITS;
+        d[4 * stride] = (tmp10 - tmp11) << PASS1_BITS;
+    } else {
+        d[0] = descale(tmp10 + tmp11, PASS1_BITS);
+        d[4 * stride] = descale(tmp10 - tmp11, PASS1_BITS);
+    }
+    int z1 = (tmp12 + tmp13) * FIX_0_541196100;
+    d[2 * stride] = descale(z1 + tmp13 * FIX_0_765366865, shift);
+    d[6 * stride] = descale(z1 - tmp12 * FIX_1_847759065, shift);
+
+    // 奇数部分
+    z1 = tmp4 + tmp7;
+    int z2 = tmp5 + tmp6;
+    int z3 = tmp4 + tmp6;
+    int z4 = tmp5 + tmp7;
+    int z5 = (z3 + z4) * FIX_1_175875602;
+    tmp4 *= FIX_0_298631336;
+    tmp5 *= FIX_2_053119869;
+    tmp6 *= FIX_3_072711026;
+    tmp7 *= FIX_1_501321110;
+    z1 *= -FIX_0_899976223;
+    z2 *= -FIX_2_562915447;
+    z3 = z3 * -FIX_1_961570560 + z5;
+    z4 = z4 * -FIX_0_390180644 + z5;
+    d[7 * stride] = descale(tmp4 + z1 + z3, shift);
+    d[5 * stride] = descale(tmp5 + z2 + z4, shift);
+    d[3 * stride] = descale(tmp6 + z2 + z3, shift);
+    d[stride] = descale(tmp7 + z1 + z4, shift);
+}
+
+static void forwardDCT(int *data) {
+    for (int row = 0; row < 8; ++row) fdct8(data + row * 8, 1, 0);
+    for (int col = 0; col < 8; ++col) fdct8(data + col, 8, 1);
+}
+
+// 量化除数（含 DCT 的 8 倍放大）及其 32 位定点倒数，用乘法和移位代替除法；
+// 对 |x| < 2^16 结果与整数除法完全一致
+struct QuantDivisors {
+    uint32_t half[64];
+    uint64_t reciprocal[64];
+};
+
+static QuantDivisors makeDivisors(const std::vector<int> &table) {
+    QuantDivisors divisors;
+    for (int i = 0; i < 64; ++i) {
+        uint32_t divisor = static_cast<uint32_t>(table[zigzagIndex[i]]) * 8;
+        divisors.half[i] = divisor / 2;
+        divisors.reciprocal[i] = ((uint64_t(1) << 32) + divisor - 1) / divisor;
+    }
+    return divisors;
+}
+
+// 量化自然顺序的 DCT 结果，同时写成 Zig-Zag 顺序
+static void quantizeBlock(const int *data, const QuantDivisors &divisors, Coefficient *block) {
+    for (int i = 0; i < 64; ++i) {
+        int value = data[i];
+        uint32_t magnitude = static_cast<uint32_t>(value < 0 ? -value : value);
+        int q = static_cast<int>(((magnitude + divisors.half[i]) * divisors.reciprocal[i]) >> 32);
+        block[zigzagIndex[i]] = static_cast<Coefficient>(value < 0 ? -q : q);
+    }
+}
+
+namespace {
+
+struct EncoderContext {
+    const RawImage &image;
+    bool color;
+    bool subsampled;
+    int mcuSize;
+    int mcuCols;
+    int mcuRows;
+    QuantDivisors divisors[2];
+    const HuffmanEncodeTable *dcTables[2];
+    const HuffmanEncodeTable *acTables[2];
+
+    EncoderContext(const RawImage &image, const EncodeOptions &options) : image(image) {
+        color = image.channels == 3;
+        subsampled = color && options.subsampling == ChromaSubsampling::Yuv420;
+        mcuSize = subsampled ? 16 : 8;
+        mcuCols = (image.width + mcuSize - 1) / mcuSize;
+        mcuRows = (image.height + mcuSize - 1) / mcuSize;
+    }
+};
+
+} // namespace
+
+// 变换、量化并熵编码一个 8x8 样本块（样本已减去 128）
+static void encodeSamples(JpegBitWriter &writer, int *samples, const EncoderContext &ctx, int table, int &previousDc) {
+    Coefficient block[64];
+    forwardDCT(samples);
+    quantizeBlock(samples, ctx.divisors[table], block);
+    encodeBlock(writer, block, previousDc, *ctx.dcTables[table], *ctx.acTables[table]);
+}
+
+// 编码 MCU [mcuBegin, mcuEnd)：一个重启间隔或整个扫描，DC 预测从 0 开始
+static void encodeMcuRange(const EncoderContext &ctx, int mcuBegin, int mcuEnd, std::vector<uint8_t> &out) {
+    JpegBitWriter writer(out);
+    int previousDc[3] = {0, 0, 0};
+    const RawImage &image = ctx.image;
+    int size = ctx.mcuSize;
+
+    // MCU 内的全分辨率 Y、Cb、Cr 样本（最大 16x16）
+    int ySamples[256], cbSamples[256], crSamples[256];
+    int block[64];
+
+    for (int mcu = mcuBegin; mcu < mcuEnd; ++mcu) {
+        int x0 = (mcu % ctx.mcuCols) * size;
+        int y0 = (mcu / ctx.mcuCols) * size;
+
+        // 取样并做颜色转换；超出边界的部分复制边缘像素
+        for (int row = 0; row < size; ++row) {
+            int sy = std::min(y0 + row, image.height - 1);
+            const uint8_t *line = &image.pixels[static_cast<size_t>(sy) * image.width * image.channels];
+            for (int col = 0; col < size; ++col) {
+                int sx = std::min(x0 + col, image.width - 1);
+                int index = row * size + col;
+                if (!ctx.color) {
+                    ySamples[index] = line[sx];
+                    continue;
+                }
+                int r = line[sx * 3], g = line[sx * 3 + 1], b = line[sx * 3 + 2];
+                ySamples[index] = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+                cbSamples[index] = (-11059 * r - 21709 * g + 32768 * b + (128 << 16) + 32767) >> 16;
+                crSamples[index] = (32768 * r - 27439 * g - 5329 * b + (128 << 16) + 32767) >> 16;
+            }
+        }
+
+        // Y 块：4:2:0 时依次为左上、右上、左下、右下
+        int yBlocks = ctx.subsampled ? 4 : 1;
+        for (int b = 0; b < yBlocks; ++b) {
+            int rowOffset = (b / 2) * 8, colOffset = (b % 2) * 8;
+            for (int row = 0; row < 8; ++row) {
+                for (int col = 0; col < 8; ++col) {
+                    block[row * 8 + col] = ySamples[(rowOffset + row) * size + colOffset + col] - 128;
+                }
+            }
+            encodeSamples(writer, block, ctx, 0, previousDc[0]);
+        }
+        if (!ctx.color) continue;
+
+        // Cb、Cr 块：4:2:0 时 2x2 平均下采样
+        int *chroma[2] = {cbSamples, crSamples};
+        for (int c = 0; c < 2; ++c) {
+            const int *src = chroma[c];
+            for (int row = 0; row < 8; ++row) {
+                for (int col = 0; col < 8; ++col) {
+                    int value;
+                    if (ctx.subsampled) {
+                        const int *p = &src[(row * 2) * size + col * 2];
+                        value = (p[0] + p[1] + p[size] + p[size + 1] + 2) >> 2;
+                    } else {
+                        value = src[row * size + col];
+                    }
+                    block[row * 8 + col] = value - 128;
+                }
+            }
+            encodeSamples(writer, block, ctx, 1, previousDc[c + 1]);
+        }
+    }
+    writer.flush();
+}
+
+bool encodeJPEG(const RawImage &image, const EncodeOptions &options, std::vector<uint8_t> &out) {
+    if (image.width <= 0 || image.height <= 0 || image.width > 65535 || image.height > 65535 ||
+        (image.channels != 1 && image.channels != 3) ||
+        image.pixels.size() < static_cast<size_t>(image.width) * image.height * image.channels) {
+        return false;
+    }
+
+    EncoderContext ctx(image, options);
+    std::vector<int> quantTables[2] = {scaledQuantTable(0, options.quality), scaledQuantTable(1, options.quality)};
+    const std::vector<int> *quantPointers[2] = {&quantTables[0], &quantTables[1]};
+    for (int t = 0; t < 2; ++t) {
+        ctx.divisors[t] = makeDivisors(quantTables[t]);
+        ctx.dcTables[t] = &standardDcTable(t);
+        ctx.acTables[t] = &standardAcTable(t);
+    }
+
+    int totalMcus = ctx.mcuCols * ctx.mcuRows;
+    int interval = options.restartInterval > 0 ? std::min(options.restartInterval, 65535) : totalMcus;
+    int intervalCount = (totalMcus + interval - 1) / interval;
+
+    out.clear();
+    out.reserve(static_cast<size_t>(image.width) * image.height * image.channels / 4 + 1024);
+    writeJPEGHeaders(out, image.width, image.height, image.channels, options.subsampling, quantPointers,
+                     ctx.dcTables, ctx.acTables, options.restartInterval > 0 ? interval : 0);
+
+    // 各重启间隔互不依赖（DC 预测重置、比特流按字节对齐），分别编码到独立缓冲区后按顺序拼接
+    std::vector<std::vector<uint8_t>> segments(intervalCount);
+    auto encodeInterval = [&](int i) {
+        encodeMcuRange(ctx, i * interval, std::min(totalMcus, (i + 1) * interval), segments[i]);
+    };
+
+    int workerCount = std::max(1, std::min(options.threadCount, intervalCount));
+    if (workerCount == 1) {
+        for (int i = 0; i < intervalCount; ++i) encodeInterval(i);
+    } else {
+        std::atomic<int> next(0);
+        std::vector<std::thread> workers;
+        for (int w = 0; w < workerCount; ++w) {
+            workers.emplace_back([&]() {
+                for (int i = next++; i < intervalCount; i = next++) encodeInterval(i);
+            });
+        }
+        for (auto &worker : workers) worker.join();
+    }
+
+    for (int i = 0; i < intervalCount; ++i) {
+        out.insert(out.end(), segments[i].begin(), segments[i].end());
+        if (i + 1 < intervalCount) putMarker(out, static_cast<uint8_t>(0xD0 + i % 8));  // RSTn
+    }
+    putMarker(out, EOI);
+    return true;
+}
+
+RawImage rawImageFromBMPRows(const std::vector<uint8_t> &pixelData, int width, int height, int channels) {
+    RawImage image;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize(static_cast<size_t>(width) * height * channels);
+    int rowSize = ((width * channels + 3) / 4) * 4;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *src = &pixelData[static_cast<size_t>(height - 1 - y) * rowSize];
+        uint8_t *dst = &image.pixels[static_cast<size_t>(y) * width * channels];
+        if (channels == 1) {
+            std::copy(src, src + width, dst);
+            continue;
+        }
+        for (int x = 0; x < width; ++x) {  // B,G,R -> R,G,B
+            dst[x * 3] = src[x * 3 + 2];
+            dst[x * 3 + 1] = src[x * 3 + 1];
+            dst[x * 3 + 2] = src[x * 3];
+        }
+    }
+    return image;
+}
+
+void bmpRowsFromRawImage(const RawImage &image, std::vector<uint8_t> &pixelData) {
+    int rowSize = ((image.width * image.channels + 3) / 4) * 4;
+    pixelData.assign(static_cast<size_t>(rowSize) * image.height, 0);
+    for (int y = 0; y < image.height; ++y) {
+        const uint8_t *src = &image.pixels[static_cast<size_t>(y) * image.width * image.channels];
+        uint8_t *dst = &pixelData[static_cast<size_t>(image.height - 1 - y) * rowSize];
+        if (image.channels == 1) {
+            std::copy(src, src + image.width, dst);
+            continue;
+        }
+        for (int x = 0; x < image.width; ++x) {  // R,G,B -> B,G,R
+            dst[x * 3] = src[x * 3 + 2];
+            dst[x * 3 + 1] = src[x * 3 + 1];
+            dst[x * 3 + 2] = src[x * 3];
+        }
+    }
+}
+
+static uint32_t readLittleEndian(const std::vector<uint8_t> &data, size_t pos, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) value = (value << 8) | data[pos + i];
+    return value;
+}
+
+// 头部中的偏移与尺寸都不可信：所有区域按 64 位无溢出地与文件大小比较，越界即拒绝
+bool loadBMP(const std::string &filename, RawImage &image) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 54 || data[0] != 'B' || data[1] != 'M') return false;
+
+    uint64_t pixelOffset = readLittleEndian(data, 10, 4);
+    uint64_t headerEnd = 14 + static_cast<uint64_t>(readLittleEndian(data, 14, 4));  // 文件头 + DIB 头
+    int32_t width = static_cast<int32_t>(readLittleEndian(data, 18, 4));
+    int32_t height = static_cast<int32_t>(readLittleEndian(data, 22, 4));
+    uint32_t bitsPerPixel = readLittleEndian(data, 28, 2);
+    uint32_t compression = readLittleEndian(data, 30, 4);
+    if (width <= 0 || height == 0 || height == INT32_MIN || compression != 0 ||
+        (bitsPerPixel != 24 && bitsPerPixel != 8)) {
+        return false;
+    }
+    bool topDown = height < 0;
+    height = std::abs(height);
+
+    uint64_t bytesPerPixel = bitsPerPixel / 8;
+    uint64_t rowSize = ((static_cast<uint64_t>(width) * bytesPerPixel + 3) / 4) * 4;
+    // width、height 都小于 2^31，rowSize * height 不会溢出 64 位
+    if (headerEnd < 54 || headerEnd > pixelOffset || pixelOffset > data.size() ||
+        rowSize * height > data.size() - pixelOffset) {
+        return false;
+    }
+
+    // 8 位 BMP 按调色板展开；调色板必须完整位于 DIB 头与像素数据之间，索引不能超出调色板
+    const uint8_t *palette = &data[headerEnd];
+    uint32_t paletteSize = 0;
+    if (bitsPerPixel == 8) {
+        paletteSize = readLittleEndian(data, 46, 4);  // biClrUsed，0 表示 256 项
+        if (paletteSize == 0) paletteSize = 256;
+        if (paletteSize > 256 || headerEnd + paletteSize * 4 > pixelOffset) return false;
+    }
+    bool grayPalette = bitsPerPixel == 8;
+    for (uint32_t i = 0; grayPalette && i < paletteSize; ++i) {
+        grayPalette = palette[i * 4] == palette[i * 4 + 1] && palette[i * 4 + 1] == palette[i * 4 + 2];
+    }
+    if (bitsPerPixel == 8) {
+        for (int32_t y = 0; y < height; ++y) {
+            const uint8_t *row = &data[pixelOffset + rowSize * y];
+            for (int32_t x = 0; x < width; ++x) {
+                if (row[x] >= paletteSize) return false;
+            }
+        }
+    }
+
+    image.width = width;
+    image.height = height;
+    image.channels = grayPalette ? 1 : 3;
+    image.pixels.resize(static_cast<size_t>(width) * height * image.channels);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *src = &data[pixelOffset + rowSize * (topDown ? y : height - 1 - y)];
+        uint8_t *dst = &image.pixels[static_cast<size_t>(y) * width * image.channels];
+        for (int x = 0; x < width; ++x) {
+            const uint8_t *bgr = bitsPerPixel == 24 ? &src[x * 3] : &palette[src[x] * 4];
+            if (grayPalette) {
+                dst[x] = bgr[0];
+            } else {
+                dst[x * 3] = bgr[2];
+                dst[x * 3 + 1] = bgr[1];
+                dst[x * 3 + 2] = bgr[0];
+            }
+        }
+    }
+    return true;
+}
+
+bool loadRawImage(const std::string &filename, int width, int height, int channels, RawImage &image) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file || width <= 0 || height <= 0) return false;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize(static_cast<size_t>(width) * height * channels);
+    file.read(reinterpret_cast<char *>(image.pixels.data()), image.pixels.size());
+    return static_cast<size_t>(file.gcount()) == image.pixels.size();
+}
+
+bool saveAsJPEG(const std::string &filename, const RawImage &image, const EncodeOptions &options) {
+    std::vector<uint8_t> out;
+    if (!encodeJPEG(image, options, out)) return false;
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    return static_cast<bool>(file);
+}
@@ -1,7 +1,7 @@
 #include "jpeg_parser_helpers.h"
 
 // 在实现文件中定义函数
-uint16_t readBigEndian16(std::ifstream &file) {
+uint16_t readBigEndian16(std::istream &file) {
     uint8_t highByte = file.get();
     uint8_t lowByte = file.get();
     return (highByte << 8) | lowByte;
@@ -1,17 +1,40 @@
 #include "jpeg_header_parser.h"
+#include "decode_trace.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <vector>
 
+// 只读的内存流缓冲区，让解析器直接读取内存中的帧而不复制
+namespace {
+struct MemoryStreamBuffer : std::streambuf {
+    MemoryStreamBuffer(const uint8_t *data, size_t size) {
+        char *begin = reinterpret_cast<char *>(const_cast<uint8_t *>(data));
+        setg(begin, begin, begin + size);
+    }
+};
+} // namespace
+
 // JPEG 解析函数
-ImageData parseJPEGHeader(const std::string &filename) {
-    ImageData imgData;
+ImageData parseJPEGHeader(const std::string &filename, bool verbose) {
     std::ifstream file(filename, std::ios::binary);
 
     if (!file) {
         std::cerr << "无法打开文件: " << filename << std::endl;
-        return imgData;
+        return ImageData();
     }
+    return parseJPEGStream(file, verbose);
+}
+
+ImageData parseJPEGMemory(const uint8_t *data, size_t size, bool verbose) {
+    MemoryStreamBuffer buffer(data, size);
+    std::istream stream(&buffer);
+    return parseJPEGStream(stream, verbose);
+}
+
+ImageData parseJPEGStream(std::istream &file, bool verbose) {
+    TraceScope trace("parse");
+    ImageData imgData;
 
     // 检查起始标记 (SOI)
     if (file.get() != 0xFF || file.get() != SOI) {
@@ -27,15 +50,20 @@ ImageData parseJPEGHeader(const std::string &filename) {
 
         uint8_t marker = file.get();
         uint16_t length = readBigEndian16(file) - 2;
-        if (marker == DRI) break;
-        if (marker == SOF0) {
+        if (marker == DRI) {
+            // 重启间隔：每隔 restartInterval 个 MCU 插入一个 RSTn 标记
+            imgData.restartInterval = readBigEndian16(file);
+            file.ignore(length - 2);
+        } else if (marker == SOF0) {
             file.get(); // 忽略精度
             imgData.height = readBigEndian16(file);
             imgData.width = readBigEndian16(file);
             
             // 获取颜色分量数
             imgData.colorComponents = file.get(); // 颜色分量数
-            std::cout << "Number of Color Components: " << static_cast<int>(imgData.colorComponents) << std::endl;
+            if (verbose) {
+                std::cout << "Number of Color Components: " << static_cast<int>(imgData.colorComponents) << std::endl;
+            }
             
             // 解析每个颜色分量的信息
             for (int i = 0; i < imgData.colorComponents; ++i) {
@@ -46,6 +74,17 @@ ImageData parseJPEGHeader(const std::string &filename) {
                 // 提取水平和垂直采样因子
                 int horizontalSamplingFactor = (samplingFactors >> 4) & 0xF;
                 int verticalSamplingFactor = samplingFactors & 0xF;
+                imgData.hSamplingFactors.push_back(horizontalSamplingFactor);
+                imgData.vSamplingFactors.push_back(verticalSamplingFactor);
+
+                // 第一个分量为 Y，其余分量共用色度量化表
+                if (i == 0) {
+                    imgData.yQuantTableId = quantizationTableID;
+                } else {
+                    imgData.crCbQuantTableId = quantizationTableID;
+                }
+
+                if (!verbose) continue;
 
                 // 输出颜色分量的信息
                 std::cout << "Component " << static_cast<int>(componentID) << ":\n";
@@ -66,7 +105,7 @@ ImageData parseJPEGHeader(const std::string &filename) {
             while (length > 0) {
                 uint8_t precisionAndTableId = file.get();
                 int tableId = precisionAndTableId & 0x0F;  // 获取量化表 ID
-                std::cout << "TableID" << " " << tableId << std::endl;
+                if (verbose) std::cout << "TableID" << " " << tableId << std::endl;
                 int precision = (precisionAndTableId >> 4) ? 16 : 8; // 获取精度
                 std::vector<int> quantTable(64);
 
@@ -81,28 +120,37 @@ ImageData parseJPEGHeader(const std::string &filename) {
                 length -= (precision == 8) ? 65 : 129;
             }
         } else if (marker == DHT) {
-            // 读取哈夫曼表
-            std::cout << "huffman data length: " << length << std::endl; 
-            HuffmanTable huffTable;
-            uint8_t tableClassAndId = file.get();
-            huffTable.tableClass = (tableClassAndId >> 4);
-            huffTable.tableId = tableClassAndId & 0x0F;
-
-            huffTable.lengths.resize(16);
-            for (int i = 0; i < 16; ++i) {
-                huffTable.lengths[i] = file.get();
-            }
+            // 读取哈夫曼表：一个 DHT 段可以包含多张表
+            if (verbose) std::cout << "huffman data length: " << length << std::endl;
+            while (length > 17 && file) {
+                HuffmanTable huffTable;
+                uint8_t tableClassAndId = file.get();
+                huffTable.tableClass = (tableClassAndId >> 4);
+                huffTable.tableId = tableClassAndId & 0x0F;
+
+                huffTable.lengths.resize(16);
+                for (int i = 0; i < 16; ++i) {
+                    huffTable.lengths[i] = file.get();
+                }
 
-            int totalSymbols = 0;
-            for (int len : huffTable.lengths) {
-                totalSymbols += len;
-            }
+                int totalSymbols = 0;
+                for (int len : huffTable.lengths) {
+                    totalSymbols += len;
+                }
+
+                huffTable.symbols.resize(totalSymbols);
+                for (int i = 0; i < totalSymbols; ++i) {
+                    huffTable.symbols[i] = file.get();
+                }
 
-            huffTable.symbols.resize(totalSymbols);
-            for (int i = 0; i < totalSymbols; ++i) {
-                huffTable.symbols[i] = file.get();
+                // 同一类别、同一 ID 的表后定义的覆盖先定义的
+                auto &tables = imgData.huffmanTables;
+                tables.erase(std::remove_if(tables.begin(), tables.end(), [&](const HuffmanTable &table) {
+                    return table.tableClass == huffTable.tableClass && table.tableId == huffTable.tableId;
+                }), tables.end());
+                tables.push_back(huffTable);
+                length -= 17 + totalSymbols;
             }
-            imgData.huffmanTables.push_back(huffTable);
         } else if (marker == SOS) {
             // 提取 SOS 段比特流数据
             uint8_t byte;
@@ -120,6 +168,7 @@ ImageData parseJPEGHeader(const std::string &filename) {
                         imgData.compressedData.push_back(0xFF);
                     } else if (nextByte == 0xD9) {
                         // 情况 2：0xFF 0xD9，表示 EOI 结束标记
+                        imgData.scanEndMarker = EOI;
                         break;
                     }
                     else if (nextByte >= 0xD0 && nextByte <= 0xD7) {
@@ -134,9 +183,8 @@ ImageData parseJPEGHeader(const std::string &filename) {
                     //     file.seekg(-1, std::ios::cur); // 回退文件指针一个字节
                     // }
                     else {
-                        // 情况 5：其他情况，保留 0xFF 和随后的字节
-                        // imgData.compressedData.push_back(0xFF);
-                        imgData.compressedData.push_back(nextByte);
+                        // 情况 5：其他标记出现在扫描数据中间，标记本身不属于比特流
+                        imgData.scanEndMarker = nextByte;
                         break;
                     }
                 } else {
@@ -150,7 +198,6 @@ ImageData parseJPEGHeader(const std::string &filename) {
         }
     }
 
-    file.close();
     return imgData;
 }
 
@@ -159,8 +206,7 @@ BitStreamReader::BitStreamReader(const std::vector<uint8_t> &data) : data(data),
 int BitStreamReader::readBit() {
     // 检查当前字节位置是否越界
     if (bytePos >= data.size()) {
-        std::cerr << "Reached end of data while reading bits." << std::endl;
-        return -1;  // 超出数据范围，返回错误码
+        return -1;  // 超出数据范围，返回错误码，由调用方决定如何报告
     }
 
     // 提取当前字节的第 bitPos 位，位移并进行位掩码
@@ -178,12 +224,18 @@ int BitStreamReader::readBit() {
     return bit;
 }
 
+void BitStreamReader::alignToByte() {
+    if (bitPos != 0) {
+        bitPos = 0;
+        bytePos++;
+    }
+}
+
 int BitStreamReader::readBits(int numBits) {
     int value = 0;
     while (numBits > 0) {
         int bit = readBit();
         if (bit == -1) {
-            std::cerr << "Error reading bit stream." << std::endl;
             return -1;
         }
         value = (value << 1) | bit;
@@ -0,0 +1,118 @@
+#include "jpeg_native.h"
+#include "jpeg_header_parser.h"
+#include "huffman_decoder.h"
+#include "jpeg_decoder.h"
+#include "pixel_output.h"
+#include <climits>
+#include <new>
+
+static_assert(static_cast<int>(DecodeStatus::UnsupportedSampling) == JPEG_NATIVE_UNSUPPORTED_SAMPLING,
+              "返回码 1~6 与 DecodeStatus 一一对应");
+
+struct jpeg_native_image {
+    ImageData imgData;  // 已构建哈夫曼码表；系数块只在 jpeg_native_decode 期间存在
+};
+
+namespace {
+
+// 释放系数块，句柄在两次解码之间只保留头部与熵编码数据
+void releaseCoefficients(ImageData &imgData) {
+    std::vector<std::vector<Coefficient>>().swap(imgData.Y);
+    std::vector<std::vector<Coefficient>>().swap(imgData.Cb);
+    std::vector<std::vector<Coefficient>>().swap(imgData.Cr);
+    std::vector<std::vector<std::vector<Coefficient>>>().swap(imgData.Y_blocks_2D);
+    std::vector<std::vector<std::vector<Coefficient>>>().swap(imgData.Cb_blocks_2D);
+    std::vector<std::vector<std::vector<Coefficient>>>().swap(imgData.Cr_blocks_2D);
+}
+
+int decodeInto(ImageData &imgData, int channels, uint8_t *out, size_t stride, size_t size) {
+    if (channels != 1 && channels != 3 && channels != 4) return JPEG_NATIVE_INVALID_ARGUMENT;
+    size_t rowBytes = static_cast<size_t>(imgData.width) * channels;
+    if (!out || stride < rowBytes || stride > INT_MAX) return JPEG_NATIVE_INVALID_ARGUMENT;
+    if (size / stride < static_cast<size_t>(imgData.height - 1) ||
+        size - stride * (imgData.height - 1) < rowBytes) {
+        return JPEG_NATIVE_INVALID_ARGUMENT;  // 最后一行不要求有行尾填充
+    }
+
+    imgData.lumaOnly = channels == 1;
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    DecodeStatus status = decodeJPEG(imgData, imgData.compressedData);
+    if (status == DecodeStatus::Ok) {
+        if (channels == 1) {
+            uint8_t *const planes[3] = {out, nullptr, nullptr};
+            const int strides[3] = {static_cast<int>(stride), 0, 0};
+            fillYuvPlanes(imgData, 0, imgData.mcuHeight, planes, strides);
+        } else {
+            fillPackedRows(imgData, 0, imgData.mcuHeight, channels == 4 ? OutputFormat::Rgba : OutputFormat::Rgb, out,
+                           static_cast<int>(stride));
+        }
+    }
+    releaseCoefficients(imgData);
+    return static_cast<int>(status);
+}
+
+} // namespace
+
+// 异常不能穿过 C 接口，分配失败统一转换为返回码
+int jpeg_native_open(const uint8_t *data, size_t size, uint64_t max_pixels, jpeg_native_image **image) {
+    if (!image) return JPEG_NATIVE_INVALID_ARGUMENT;
+    *image = nullptr;
+    if (!data) return JPEG_NATIVE_INVALID_ARGUMENT;
+    try {
+        jpeg_native_image *handle = new jpeg_native_image{parseJPEGMemory(data, size)};
+        ImageData &imgData = handle->imgData;
+        int status = JPEG_NATIVE_OK;
+        if (!imgData.width || !imgData.height || !imgData.hasRequiredQuantTables()) {
+            status = JPEG_NATIVE_INVALID_HEADER;
+        } else if (!imgData.hasSupportedSampling()) {
+            status = JPEG_NATIVE_UNSUPPORTED_SAMPLING;
+        } else if (!imgData.hasPlausibleSize(max_pixels ? max_pixels : DEFAULT_MAX_PIXELS)) {
+            status = JPEG_NATIVE_TOO_LARGE;
+        }
+        if (status != JPEG_NATIVE_OK) {
+            delete handle;
+            return status;
+        }
+        imgData.initializeHuffmanTables();
+        *image = handle;
+        return JPEG_NATIVE_OK;
+    } catch (const std::bad_alloc &) {
+        return JPEG_NATIVE_OUT_OF_MEMORY;
+    }
+}
+
+void jpeg_native_info(const jpeg_native_image *image, int *width, int *height, int *channels) {
+    if (width) *width = image ? image->imgData.width : 0;
+    if (height) *height = image ? image->imgData.height : 0;
+    if (channels) *channels = image ? (image->imgData.isGrayscale() ? 1 : 3) : 0;
+}
+
+int jpeg_native_decode(jpeg_native_image *image, int channels, uint8_t *out, size_t stride, size_t size) {
+    if (!image) return JPEG_NATIVE_INVALID_ARGUMENT;
+    try {
+        return decodeInto(image->imgData, channels, out, stride, size);
+    } catch (const std::bad_alloc &) {
+        releaseCoefficients(image->imgData);
+        return JPEG_NATIVE_OUT_OF_MEMORY;
+    }
+}
+
+void jpeg_native_close(jpeg_native_image *image) {
+    delete image;
+}
+
+const char *jpeg_native_status_message(int status) {
+    switch (status) {
+    case JPEG_NATIVE_INVALID_ARGUMENT:
+        return "参数无效";
+    case JPEG_NATIVE_OUT_OF_MEMORY:
+        return "内存不足";
+    case JPEG_NATIVE_TOO_LARGE:
+        return "图像尺寸超过上限或与数据长度不符";
+    default:
+        if (status >= JPEG_NATIVE_OK && status <= JPEG_NATIVE_UNSUPPORTED_SAMPLING) {
+            return decodeStatusMessage(static_cast<DecodeStatus>(status));
+        }
+        return "unknown";
+    }
+}
@@ -0,0 +1,139 @@
+"""进程内解码 JPEG：通过 ctypes 调用共享库 libjpeg_native（C 接口见 include/jpeg_native.h）。
+
+decode() 直接解码内存中的 bytes，像素由 C++ 写入 Python 侧分配的缓冲区，不经过临时文件，也没有额外的复制。
+有 NumPy 时返回形状为 (高, 宽) 或 (高, 宽, 通道) 的 uint8 数组，否则返回同形状的 memoryview
+（numpy.asarray 可零复制转换）。ctypes 调用 C 函数期间释放 GIL，多个 Python 线程可以同时解码。
+
+像素数超过 max_pixels（默认 MAX_PIXELS），或头部尺寸与数据长度不符的图像在分配输出之前就被拒绝。
+共享库默认从仓库的 build 目录加载，可用环境变量 JPEG_NATIVE_LIBRARY 指定路径。
+"""
+import ctypes
+import os
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+JPEG_NATIVE_OK = 0
+JPEG_NATIVE_TOO_LARGE = 9
+
+MAX_PIXELS = 100_000_000
+
+
+class JPEGDecodeError(Exception):
+    def __init__(self, status, message):
+        super().__init__(message)
+        self.status = status
+
+
+def _load_library():
+    path = os.environ.get("JPEG_NATIVE_LIBRARY")
+    if not path:
+        root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+        path = os.path.join(root, "build", "libjpeg_native.so")
+    lib = ctypes.CDLL(path)  # CDLL（而非 PyDLL）在调用期间释放 GIL
+    lib.jpeg_native_open.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_uint64,
+                                     ctypes.POINTER(ctypes.c_void_p)]
+    lib.jpeg_native_open.restype = ctypes.c_int
+    lib.jpeg_native_info.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int),
+                                     ctypes.POINTER(ctypes.c_int)]
+    lib.jpeg_native_info.restype = None
+    lib.jpeg_native_decode.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p, ctypes.c_size_t,
+                                       ctypes.c_size_t]
+    lib.jpeg_native_decode.restype = ctypes.c_int
+    lib.jpeg_native_close.argtypes = [ctypes.c_void_p]
+    lib.jpeg_native_close.restype = None
+    lib.jpeg_native_status_message.argtypes = [ctypes.c_int]
+    lib.jpeg_native_status_message.restype = ctypes.c_char_p
+    return lib
+
+
+_lib = _load_library()
+
+
+def _check(status):
+    if status != JPEG_NATIVE_OK:
+        raise JPEGDecodeError(status, _lib.jpeg_native_status_message(status).decode("utf-8"))
+
+
+def _input_buffer(data):
+    """返回 (ctypes 参数, 字节数)：bytes 直接传内部缓冲区的指针，其他缓冲区对象尽量不复制"""
+    if isinstance(data, bytes):
+        return data, len(data)
+    view = memoryview(data)
+    if view.contiguous and not view.readonly:
+        return (ctypes.c_char * view.nbytes).from_buffer(view), view.nbytes
+    if view.contiguous and numpy is not None:
+        array = numpy.frombuffer(view, dtype=numpy.uint8)  # 只读缓冲区（如只读 mmap）也不复制
+        return array.ctypes.data_as(ctypes.c_void_p), view.nbytes
+    data = view.tobytes()
+    return data, len(data)
+
+
+def _open(data, max_pixels):
+    pointer, size = _input_buffer(data)
+    image = ctypes.c_void_p()
+    _check(_lib.jpeg_native_open(pointer, size, max_pixels or MAX_PIXELS, ctypes.byref(image)))
+    return image
+
+
+def _image_info(image):
+    width, height, channels = ctypes.c_int(), ctypes.c_int(), ctypes.c_int()
+    _lib.jpeg_native_info(image, ctypes.byref(width), ctypes.byref(height), ctypes.byref(channels))
+    return width.value, height.value, channels.value
+
+
+def info(data, max_pixels=None):
+    """返回 (宽, 高, 原生通道数)，灰度为 1，彩色为 3"""
+    image = _open(data, max_pixels)
+    try:
+        return _image_info(image)
+    finally:
+        _lib.jpeg_native_close(image)
+
+
+def _output_buffer(out, height, width, channels):
+    """返回 (结果对象, 目标地址, 行跨度, 字节数)；out 为 None 时新分配"""
+    shape = (height, width) if channels == 1 else (height, width, channels)
+    if out is None:
+        if numpy is not None:
+            array = numpy.empty(shape, dtype=numpy.uint8)
+            return array, array.ctypes.data, width * channels, array.nbytes
+        buffer = bytearray(height * width * channels)
+        address = ctypes.addressof((ctypes.c_char * len(buffer)).from_buffer(buffer))
+        return memoryview(buffer).cast("B", shape), address, width * channels, len(buffer)
+
+    # 调用方提供的缓冲区（如批次数组中的一项）：须可写、C 连续；二维以上时按第一维的步长作为行跨度，
+    # 行可以比图像宽（多出的部分不写）
+    view = memoryview(out)
+    if view.readonly or not view.c_contiguous:
+        raise ValueError("out must be a writable C-contiguous buffer")
+    stride = view.strides[0] if view.ndim >= 2 else width * channels
+    if view.ndim >= 2 and view.shape[0] < height:
+        raise ValueError("out has fewer rows than the image")
+    address = ctypes.addressof((ctypes.c_char * view.nbytes).from_buffer(view))
+    return out, address, stride, view.nbytes
+
+
+def decode(data, channels=0, out=None, max_pixels=None):
+    """解码内存中的 JPEG（bytes 或其他缓冲区对象）。
+
+    channels 为 0 时使用原生通道数；1 只输出亮度（彩色图像跳过色度重建），3 为 RGB，4 为 RGBA（alpha 为 255）。
+    out 可以是预先分配的可写缓冲区，像素直接写入其中并返回 out。max_pixels 为像素数上限（默认 MAX_PIXELS）。
+    解码失败或图像超过上限时抛出 JPEGDecodeError。
+    """
+    if channels not in (0, 1, 3, 4):
+        raise ValueError("channels must be 0, 1, 3 or 4")
+    image = _open(data, max_pixels)
+    try:
+        # 分配输出之前再按 info 的尺寸核对一次上限
+        width, height, native = _image_info(image)
+        if width <= 0 or height <= 0 or width * height > (max_pixels or MAX_PIXELS):
+            _check(JPEG_NATIVE_TOO_LARGE)
+        channels = channels or native
+        result, address, stride, size = _output_buffer(out, height, width, channels)
+        _check(_lib.jpeg_native_decode(image, channels, address, stride, size))
+        return result
+    finally:
+        _lib.jpeg_native_close(image)
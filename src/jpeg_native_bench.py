@@ -0,0 +1,91 @@
+"""进程内解码（jpeg_native）与基于文件的解码路径的吞吐对比。
+
+用法: python3 jpeg_native_bench.py [--threads N] [--iterations N] [--parser <jpeg_parser>] <JPEG...>
+
+文件路径：把 JPEG 字节写入临时文件，运行 jpeg_parser --format rgb 写出像素文件，再读回内存；
+进程内路径：jpeg_native.decode 直接从 bytes 解码到 NumPy 数组 / memoryview，分别用 1 个和 N 个 Python 线程。
+开始前逐个核对两条路径的像素完全相同，无法解码的文件跳过。
+"""
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import jpeg_native
+
+
+def decode_via_file(parser, data, directory):
+    source = os.path.join(directory, "input.jpg")
+    target = os.path.join(directory, "output.rgb")
+    with open(source, "wb") as f:
+        f.write(data)
+    subprocess.run([parser, "--format", "rgb", source, target], stdout=subprocess.DEVNULL,
+                   stderr=subprocess.DEVNULL, check=True)
+    with open(target, "rb") as f:
+        return f.read()
+
+
+def run(name, count, pixel_bytes, fn):
+    start = time.perf_counter()
+    fn()
+    seconds = time.perf_counter() - start
+    print(f"{name:<24} {count / seconds:8.1f} images/s {pixel_bytes / seconds / 2**20:8.1f} MB/s")
+    return seconds
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    options = argparse.ArgumentParser()
+    options.add_argument("--threads", type=int, default=4)
+    options.add_argument("--iterations", type=int, default=3)
+    options.add_argument("--parser", default=os.path.join(root, "build", "jpeg_parser"))
+    options.add_argument("images", nargs="+")
+    args = options.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        images = []
+        for filename in args.images:
+            with open(filename, "rb") as f:
+                data = f.read()
+            try:
+                pixels = bytes(jpeg_native.decode(data, 3))
+            except jpeg_native.JPEGDecodeError as error:
+                print(f"{filename}: 跳过（{error}）", file=sys.stderr)
+                continue
+            if pixels != decode_via_file(args.parser, data, directory):
+                print(f"{filename}: 两条路径的像素不一致", file=sys.stderr)
+                return 1
+            images.append((data, len(pixels)))
+        if not images:
+            return 1
+
+        work = [data for data, _ in images] * args.iterations
+        pixel_bytes = sum(size for _, size in images) * args.iterations
+        print(f"{len(images)} images x {args.iterations} iterations, RGB output")
+
+        def file_path():
+            for data in work:
+                decode_via_file(args.parser, data, directory)
+
+        def native_serial():
+            for data in work:
+                jpeg_native.decode(data, 3)
+
+        def native_threads():
+            with ThreadPoolExecutor(args.threads) as pool:
+                for _ in pool.map(lambda data: jpeg_native.decode(data, 3), work):
+                    pass
+
+        file_seconds = run("file + jpeg_parser", len(work), pixel_bytes, file_path)
+        serial_seconds = run("in-process, 1 thread", len(work), pixel_bytes, native_serial)
+        thread_seconds = run(f"in-process, {args.threads} threads", len(work), pixel_bytes, native_threads)
+        print(f"in-process speedup: {file_seconds / serial_seconds:.2f}x (1 thread), "
+              f"{file_seconds / thread_seconds:.2f}x ({args.threads} threads)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,244 @@
+#include "jpeg_probe.h"
+#include "jpeg_header_parser.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// FNV-1a 64 位哈希，可在多个段之间累加
+static uint64_t fnv1a(uint64_t hash, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+// IJG 标准亮度量化表（质量 50），用于反推质量因子
+static const int standardLuminanceTable[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,
+    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,
+    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,
+    24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99
+};
+
+// 按 IJG 的缩放规则由量化表反推质量因子；只比较表的总和，与系数顺序无关
+static int estimateQuality(const std::vector<int> &quantTable) {
+    long sum = 0, standardSum = 0;
+    for (int i = 0; i < 64; ++i) {
+        sum += quantTable[i];
+        standardSum += standardLuminanceTable[i];
+    }
+    double scale = 100.0 * sum / standardSum;
+    double quality = scale <= 100.0 ? (200.0 - scale) / 2.0 : 5000.0 / scale;
+    return std::max(1, std::min(100, static_cast<int>(quality + 0.5)));
+}
+
+bool probeJPEG(const std::string &filename, JpegProbeInfo &info) {
+    info = JpegProbeInfo();
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+
+    // 检查起始标记 (SOI)
+    if (file.get() != 0xFF || file.get() != SOI) return false;
+
+    info.quantTableHash = FNV_OFFSET;
+    info.huffmanTableHash = FNV_OFFSET;
+    std::vector<int> luminanceTable;
+    std::vector<uint8_t> segment;
+
+    while (file) {
+        // 跳过填充字节 0xFF
+        int byte = file.get();
+        if (byte != 0xFF) return false;
+        int marker = file.get();
+        while (marker == 0xFF) marker = file.get();
+        if (marker < 0) return false;
+
+        int high = file.get();
+        int low = file.get();
+        if (low < 0) return false;
+        int length = ((high << 8) | low) - 2;
+        if (length < 0) return false;
+
+        bool isSof = marker == 0xC0 || marker == 0xC1 || marker == 0xC2;
+        if (!isSof && marker != DQT && marker != DHT && marker != DRI && marker != SOS) {
+            file.seekg(length, std::ios::cur);  // 不需要的段直接跳过，不读取内容
+            continue;
+        }
+
+        // 段长最多 65533 字节，读取量有界
+        segment.resize(length);
+        if (!file.read(reinterpret_cast<char*>(segment.data()), length)) return false;
+
+        if (isSof) {
+            if (length < 6) return false;
+            info.sofMarker = marker;
+            info.precision = segment[0];
+            info.height = (segment[1] << 8) | segment[2];
+            info.width = (segment[3] << 8) | segment[4];
+            info.components = segment[5];
+            for (int i = 0; i < info.components && 6 + i * 3 + 2 < length; ++i) {
+                const uint8_t *component = &segment[6 + i * 3];
+                info.componentIds.push_back(component[0]);
+                info.hSamplingFactors.push_back(component[1] >> 4);
+                info.vSamplingFactors.push_back(component[1] & 0xF);
+                info.quantTableIds.push_back(component[2]);
+            }
+        } else if (marker == DQT) {
+            info.quantTableHash = fnv1a(info.quantTableHash, segment.data(), segment.size());
+            // 记下第一张 0 号表作为亮度表
+            size_t pos = 0;
+            while (pos < segment.size()) {
+                int tableId = segment[pos] & 0x0F;
+                bool sixteenBit = (segment[pos] >> 4) != 0;
+                size_t tableSize = sixteenBit ? 128 : 64;
+                if (pos + 1 + tableSize > segment.size()) break;
+                if (tableId == 0 && luminanceTable.empty()) {
+                    for (int i = 0; i < 64; ++i) {
+                        luminanceTable.push_back(sixteenBit ? (segment[pos + 1 + i * 2] << 8) | segment[pos + 2 + i * 2]
+                                                            : segment[pos + 1 + i]);
+                    }
+                }
+                pos += 1 + tableSize;
+            }
+        } else if (marker == DHT) {
+            info.huffmanTableHash = fnv1a(info.huffmanTableHash, segment.data(), segment.size());
+        } else if (marker == DRI) {
+            if (length >= 2) info.restartInterval = (segment[0] << 8) | segment[1];
+        } else {
+            // SOS：熵编码数据从这里开始，到此为止
+            info.scanOffset = static_cast<int64_t>(file.tellg());
+            if (!luminanceTable.empty()) info.estimatedQuality = estimateQuality(luminanceTable);
+            return info.width > 0 && info.height > 0;
+        }
+    }
+    return false;
+}
+
+// 采样因子写成 "2x2/1x1/1x1"
+static std::string samplingString(const JpegProbeInfo &info) {
+    std::string result;
+    for (size_t i = 0; i < info.hSamplingFactors.size(); ++i) {
+        if (i) result += '/';
+        result += std::to_string(info.hSamplingFactors[i]) + "x" + std::to_string(info.vSamplingFactors[i]);
+    }
+    return result;
+}
+
+// 路径中含逗号或引号时按 CSV 规则加引号
+static std::string csvField(const std::string &value) {
+    if (value.find_first_of(",\"\n") == std::string::npos) return value;
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static std::string csvRecord(const std::string &path, const JpegProbeInfo &info) {
+    char hashes[40];
+    std::snprintf(hashes, sizeof(hashes), "%016llx,%016llx",
+                  static_cast<unsigned long long>(info.quantTableHash),
+                  static_cast<unsigned long long>(info.huffmanTableHash));
+    return csvField(path) + "," + std::to_string(info.width) + "," + std::to_string(info.height) + "," +
+           std::to_string(info.components) + "," + samplingString(info) + "," +
+           std::to_string(info.restartInterval) + "," + hashes + "," + std::to_string(info.estimatedQuality) + "," +
+           std::to_string(info.scanOffset) + "\n";
+}
+
+static bool isJPEGPath(const std::filesystem::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".jpg" || extension == ".jpeg";
+}
+
+int indexJPEGTree(const std::string &root, const std::string &csvFilename, int threadCount) {
+    std::ofstream csv(csvFilename);
+    if (!csv) {
+        std::cerr << "无法创建文件: " << csvFilename << std::endl;
+        return 0;
+    }
+    csv << "path,width,height,components,sampling,restart_interval,dqt_hash,dht_hash,quality,scan_offset\n";
+
+    if (threadCount < 1) threadCount = 1;
+    std::error_code error;
+    auto it = std::filesystem::recursive_directory_iterator(
+        root, std::filesystem::directory_options::skip_permission_denied, error);
+    if (error) {
+        std::cerr << "无法打开目录: " << root << std::endl;
+        return 0;
+    }
+
+    // 分批处理：每批路径并行探测后按顺序写出，内存占用与文件总数无关
+    constexpr size_t BATCH_SIZE = 4096;
+    int indexed = 0;
+    std::vector<std::string> paths;
+    std::vector<std::string> records;
+    auto flushBatch = [&]() {
+        records.assign(paths.size(), std::string());
+        std::atomic<size_t> next(0);
+        std::atomic<int> succeeded(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threadCount; ++t) {
+            workers.emplace_back([&]() {
+                JpegProbeInfo info;
+                for (size_t i = next++; i < paths.size(); i = next++) {
+                    if (probeJPEG(paths[i], info)) {
+                        records[i] = csvRecord(paths[i], info);
+                        succeeded++;
+                    }
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        for (const auto &record : records) {
+            csv << record;
+        }
+        indexed += succeeded;
+        paths.clear();
+    };
+
+    // 无法读取的子目录报告后跳过，不进入；其余部分照常索引
+    int skippedDirectories = 0;
+    for (auto end = std::filesystem::recursive_directory_iterator(); it != end; it.increment(error)) {
+        if (error) {
+            // 遍历本身出错（如目录在遍历中被删除）时迭代器已失效，只能停止
+            std::cerr << "目录遍历中断: " << error.message() << std::endl;
+            skippedDirectories++;
+            break;
+        }
+        std::error_code entryError;
+        if (!it->is_symlink(entryError) && it->is_directory(entryError)) {  // 不跟随目录符号链接
+            std::filesystem::directory_iterator probe(it->path(), entryError);
+            if (entryError) {
+                std::cerr << "跳过无法读取的目录: " << it->path().string() << " (" << entryError.message() << ")"
+                          << std::endl;
+                skippedDirectories++;
+                it.disable_recursion_pending();
+            }
+        } else if (it->is_regular_file(entryError) && isJPEGPath(it->path())) {
+            paths.push_back(it->path().string());
+            if (paths.size() == BATCH_SIZE) flushBatch();
+        }
+    }
+    if (!paths.empty()) flushBatch();
+    if (skippedDirectories > 0) {
+        std::cerr << "有 " << skippedDirectories << " 个目录未能索引" << std::endl;
+    }
+    return indexed;
+}
@@ -0,0 +1,83 @@
+#include "jpeg_verify.h"
+
+// 跳过一个块：符号必须存在于码表中，DC 幅值位数不超过 11，AC 幅值位数不超过 10，
+// 游程不能越过块尾
+static DecodeStatus skipBlock(BitStreamReader &reader, const HuffmanTable &dcTable, const HuffmanTable &acTable) {
+    int symbol = getHuffmanSymbol(reader, dcTable);
+    if (symbol == HUFFMAN_TRUNCATED) return DecodeStatus::Truncated;
+    if (symbol < 0 || symbol > 11) return DecodeStatus::InvalidCode;
+    if (reader.readBits(symbol) < 0) return DecodeStatus::Truncated;
+
+    int index = 1;
+    while (index < 64) {
+        symbol = getHuffmanSymbol(reader, acTable);
+        if (symbol == HUFFMAN_TRUNCATED) return DecodeStatus::Truncated;
+        if (symbol < 0) return DecodeStatus::InvalidCode;
+        if (symbol == 0) break;  // EOB
+
+        int runLength = (symbol >> 4) & 0xF;
+        int size = symbol & 0xF;
+        // size 为 0 时只有 ZRL（0xF0）合法
+        if (size > 10 || (size == 0 && runLength != 15)) return DecodeStatus::InvalidCode;
+
+        index += runLength;
+        if (index >= 64) return DecodeStatus::InvalidCode;
+        if (reader.readBits(size) < 0) return DecodeStatus::Truncated;
+        index++;
+    }
+    return DecodeStatus::Ok;
+}
+
+VerifyReport verifyEntropyData(const ImageData &imgData) {
+    VerifyReport report;
+    report.endMarker = imgData.scanEndMarker;
+    report.totalMcus = imgData.totalBlocks;
+
+    // 与 decodeMcu 使用相同的表和 MCU 布局，但不写入任何系数
+    HuffmanDecodeState state(imgData.compressedData);
+    report.status = initHuffmanDecodeState(state, imgData);
+    if (report.status != DecodeStatus::Ok) return report;
+
+    int components = imgData.isGrayscale() ? 1 : 3;
+    int blocksPerComponent[3] = {imgData.isGrayscale() ? 1 : 4, 1, 1};
+    for (int mcu = 0; mcu < imgData.totalBlocks; ++mcu) {
+        if (imgData.restartInterval > 0 && mcu > 0 && mcu % imgData.restartInterval == 0) {
+            state.reader.alignToByte();
+        }
+        for (int c = 0; c < components; ++c) {
+            for (int b = 0; b < blocksPerComponent[c]; ++b) {
+                DecodeStatus status = skipBlock(state.reader, *state.dcTables[c], *state.acTables[c]);
+                if (status == DecodeStatus::Ok) continue;
+
+                // 数据耗尽时，若扫描是被其他标记打断的，则归为提前出现的标记
+                if (status == DecodeStatus::Truncated && report.endMarker != 0 && report.endMarker != EOI) {
+                    status = DecodeStatus::PrematureMarker;
+                }
+                report.status = status;
+                report.failedMcu = mcu;
+                return report;
+            }
+        }
+    }
+    return report;
+}
+
+VerifyReport verifyJPEG(const std::string &filename) {
+    ImageData imgData = parseJPEGHeader(filename, false);
+    if (!imgData.width || !imgData.height || imgData.compressedData.empty() ||
+        (imgData.colorComponents != 1 && imgData.colorComponents != 3)) {
+        VerifyReport report;
+        report.status = DecodeStatus::InvalidHeader;
+        return report;
+    }
+    if (!imgData.hasSupportedSampling()) {
+        // 4:4:4、4:2:2 等按 4:2:0 的 MCU 布局遍历会误报损坏，直接报告不支持
+        VerifyReport report;
+        report.status = DecodeStatus::UnsupportedSampling;
+        return report;
+    }
+    imgData.initializeHuffmanTables();
+    // 只需要 MCU 数量，不分配系数存储
+    imgData.initializeMcuLayout(imgData.width, imgData.height);
+    return verifyEntropyData(imgData);
+}
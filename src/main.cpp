@@ -1,9 +1,31 @@
 #include "jpeg_header_parser.h"
 #include "jpeg_decoder.h"
-#include "jpeg_decoder.h"
 #include "save_as_bmp.h"
+#include "pixel_output.h"
 #include "save_as_gray.h"
+#include "pipeline_decoder.h"
+#include "speculative_huffman.h"
+#include "jpeg_probe.h"
+#include "jpeg_verify.h"
+#include "dct_stats.h"
+#include "dct_transform.h"
+#include "huffman_optimizer.h"
+#include "mcu_index.h"
+#include "mjpeg_stream.h"
+#include "incremental_decoder.h"
+#include "decode_server.h"
+#include "pyramid_decoder.h"
+#include "perf_counters.h"
+#include "decode_trace.h"
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
+#include <thread>
 
 void saveCompressedData(const std::vector<uint8_t>& compressedData, const std::string& filename) {
     // 打开文件进行二进制写入
@@ -23,8 +45,529 @@ void saveCompressedData(const std::vector<uint8_t>& compressedData, const std::s
     std::cout << "数据已保存到文件: " << filename << std::endl;
 }
 
-int main() {
-    std::string filename = "../input/lena.jpg";
+// 打印探测到的元数据
+static int printProbe(const std::string &filename) {
+    JpegProbeInfo info;
+    if (!probeJPEG(filename, info)) {
+        std::cerr << "探测失败: " << filename << std::endl;
+        return -1;
+    }
+    std::cout << filename << ": " << info.width << "x" << info.height << ", " << info.components
+              << " components, SOF 0x" << std::hex << info.sofMarker << std::dec << std::endl;
+    for (int i = 0; i < info.components; ++i) {
+        std::cout << "  component " << info.componentIds[i] << ": sampling " << info.hSamplingFactors[i] << "x"
+                  << info.vSamplingFactors[i] << ", quant table " << info.quantTableIds[i] << std::endl;
+    }
+    std::cout << "  restart interval: " << info.restartInterval << std::endl;
+    std::cout << "  estimated quality: " << info.estimatedQuality << std::endl;
+    std::cout << "  scan offset: " << info.scanOffset << std::endl;
+    return 0;
+}
+
+// 逐个检查文件的熵编码数据，任一文件损坏时返回非零；不支持的采样方式只报告，不算损坏
+static int verifyFiles(const std::vector<std::string> &filenames) {
+    int failures = 0;
+    for (const auto &filename : filenames) {
+        VerifyReport report = verifyJPEG(filename);
+        std::cout << filename << ": ";
+        if (report.status == DecodeStatus::Ok) {
+            std::cout << "OK (" << report.totalMcus << " MCUs)" << std::endl;
+            continue;
+        }
+        if (report.status == DecodeStatus::UnsupportedSampling) {
+            std::cout << "UNSUPPORTED (" << decodeStatusMessage(report.status) << ", not checked)" << std::endl;
+            continue;
+        }
+        failures++;
+        std::cout << decodeStatusMessage(report.status);
+        if (report.failedMcu >= 0) {
+            std::cout << " at MCU " << report.failedMcu << "/" << report.totalMcus;
+        }
+        if (report.status == DecodeStatus::PrematureMarker) {
+            std::cout << " (marker 0xFF" << std::hex << report.endMarker << std::dec << ")";
+        }
+        std::cout << std::endl;
+    }
+    return failures ? 1 : 0;
+}
+
+// 只做熵解码，由 DCT 系数打印感知哈希与颜色统计
+static int printDctStats(const std::string &filename) {
+    ImageData imgData = parseJPEGHeader(filename, false);
+    if (!imgData.width || !imgData.height) {
+        std::cerr << "解析图像头部失败: " << filename << std::endl;
+        return -1;
+    }
+    imgData.initializeHuffmanTables();
+    imgData.initializeBlocks(imgData.width, imgData.height);
+
+    DctImageStats stats;
+    DecodeStatus status = decodeDctStats(imgData, stats);
+    if (status != DecodeStatus::Ok) {
+        std::cerr << "解码失败: " << decodeStatusMessage(status) << std::endl;
+        return -1;
+    }
+    std::cout << filename << ": phash " << std::hex << stats.perceptualHash << std::dec << std::endl;
+    std::cout << "  mean Y/Cb/Cr: " << stats.mean[0] << " " << stats.mean[1] << " " << stats.mean[2] << std::endl;
+    std::cout << "  mean R/G/B:   " << stats.meanRGB[0] << " " << stats.meanRGB[1] << " " << stats.meanRGB[2] << std::endl;
+    std::cout << "  1/8 luma map: " << stats.lumaMapWidth << "x" << stats.lumaMapHeight << std::endl;
+    return 0;
+}
+
+// 无损重新优化哈夫曼表，报告节省的字节数与吞吐
+static int optimizeFile(const std::string &inputFile, const std::string &outputFile) {
+    std::vector<uint8_t> output;
+    auto start = std::chrono::steady_clock::now();
+    OptimizeReport report = optimizeJPEG(inputFile, output);
+    auto end = std::chrono::steady_clock::now();
+    if (report.status != DecodeStatus::Ok) {
+        std::cerr << "优化失败: " << decodeStatusMessage(report.status) << std::endl;
+        return -1;
+    }
+    std::ofstream file(outputFile, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(output.data()), output.size());
+    if (!file) {
+        std::cerr << "无法写入文件: " << outputFile << std::endl;
+        return -1;
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    long saved = static_cast<long>(report.inputBytes) - static_cast<long>(report.outputBytes);
+    std::cout << inputFile << ": " << report.inputBytes << " -> " << report.outputBytes << " bytes, saved " << saved
+              << " (" << 100.0 * saved / report.inputBytes << " %), "
+              << report.inputBytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl;
+    return 0;
+}
+
+// 解码一个像素矩形并写成 BMP；有 MCU 索引时从最近的检查点开始熵解码
+static int cropFile(const std::string &inputFile, const std::string &outputFile, const std::string &rect,
+                    const std::string &indexFile) {
+    int x = 0, y = 0, w = 0, h = 0;
+    if (std::sscanf(rect.c_str(), "%d,%d,%d,%d", &x, &y, &w, &h) != 4) {
+        std::cerr << "无效的矩形: " << rect << "（格式 x,y,w,h）" << std::endl;
+        return -1;
+    }
+    ImageData imgData = parseJPEGHeader(inputFile, false);
+    if (!imgData.width || !imgData.height) {
+        std::cerr << "解析图像头部失败: " << inputFile << std::endl;
+        return -1;
+    }
+    imgData.initializeHuffmanTables();
+    imgData.initializeMcuLayout(imgData.width, imgData.height);
+
+    McuIndex index;
+    bool haveIndex = !indexFile.empty() && loadMcuIndex(indexFile, index) && mcuIndexMatches(index, imgData);
+    if (!indexFile.empty() && !haveIndex) {
+        std::cerr << "MCU 索引无效或与图像不匹配，从头解码: " << indexFile << std::endl;
+    }
+
+    RawImage region;
+    DecodeStatus status = decodeRegion(imgData, haveIndex ? &index : nullptr, x, y, w, h, region);
+    if (status != DecodeStatus::Ok) {
+        std::cerr << "解码失败: " << decodeStatusMessage(status) << std::endl;
+        return -1;
+    }
+    if (!region.width || !region.height) {
+        std::cerr << "矩形不在图像范围内" << std::endl;
+        return -1;
+    }
+
+    // 自上而下的 RGB 转为 BMP 的自下而上 BGR
+    ImageData output;
+    output.colorComponents = region.channels;
+    output.width = region.width;
+    output.height = region.height;
+    std::vector<uint8_t> pixelData;
+    bmpRowsFromRawImage(region, pixelData);
+    return writeBMP(outputFile, output, pixelData) ? 0 : -1;
+}
+
+// 解码 MJPEG 流（连续的 SOI…EOI 帧），outputPrefix 非空时把每帧写成 <前缀>_00000.bmp
+static int decodeMjpegFile(const std::string &inputFile, const std::string &outputPrefix, int threadCount) {
+    std::ifstream file(inputFile, std::ios::binary);
+    if (!file) {
+        std::cerr << "无法打开文件: " << inputFile << std::endl;
+        return -1;
+    }
+    std::vector<uint8_t> stream((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    MjpegDecodeOptions options;
+    options.threadCount = threadCount;
+    auto start = std::chrono::steady_clock::now();
+    MjpegStreamReport report = decodeMjpegStream(stream.data(), stream.size(), options, [&](const DecodedFrame &frame) {
+        if (frame.status != DecodeStatus::Ok) {
+            std::cerr << "帧 " << frame.index << " 解码失败: " << decodeStatusMessage(frame.status) << std::endl;
+            return;
+        }
+        if (outputPrefix.empty()) return;
+        std::ostringstream name;
+        name << outputPrefix << "_" << std::setw(5) << std::setfill('0') << frame.index << ".bmp";
+        ImageData output;
+        output.colorComponents = frame.channels;
+        output.width = frame.width;
+        output.height = frame.height;
+        writeBMP(name.str(), output, frame.pixelData);
+    });
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << inputFile << ": " << report.frames << " frames (" << report.defaultTableFrames
+              << " without DHT, " << report.failedFrames << " failed), " << report.frames / seconds << " frames/s"
+              << std::endl;
+    return report.failedFrames ? -1 : 0;
+}
+
+// 从标准输入分块读取并增量解码，数据到达的同时输出解码进度
+static int decodeFromStdin(const std::string &outputFile) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    IncrementalDecoder decoder([&](const DecodeEvent &event) {
+        if (event.type == DecodeEventType::HeaderParsed) {
+            std::cerr << "头部已解析: " << decoder.image().width << "x" << decoder.image().height << " ("
+                      << elapsedMs() << " ms)" << std::endl;
+        } else if (event.type == DecodeEventType::RowsReady && event.mcuRowBegin == 0) {
+            std::cerr << "第一行 MCU 就绪 (" << elapsedMs() << " ms)" << std::endl;
+        }
+    });
+
+    std::vector<uint8_t> chunk(65536);
+    size_t count;
+    while (!decoder.done() && (count = std::fread(chunk.data(), 1, chunk.size(), stdin)) > 0) {
+        decoder.feed(chunk.data(), count);
+    }
+    DecodeStatus status = decoder.finish();
+    if (status != DecodeStatus::Ok) {
+        std::cerr << "解码失败: " << decodeStatusMessage(status) << std::endl;
+        return -1;
+    }
+    std::cerr << "解码完成 (" << elapsedMs() << " ms)" << std::endl;
+    return writeBMP(outputFile, decoder.image(), decoder.pixelData()) ? 0 : -1;
+}
+
+// 逐个解码文件，打印各阶段的耗时与硬件计数器（IPC、每 MCU 的分支预测失败与缓存未命中）
+static int profileFiles(const std::vector<std::string> &filenames) {
+    PerfCounters counters;
+    if (!counters.available()) {
+        std::cerr << "硬件计数器不可用（" << counters.error() << "），只报告耗时" << std::endl;
+    }
+    int failures = 0;
+    for (const auto &filename : filenames) {
+        ImageData imgData = parseJPEGHeader(filename, false);
+        if (!imgData.width || !imgData.height || !imgData.hasSupportedSampling()) {
+            std::cerr << "解析图像头部失败: " << filename << std::endl;
+            failures++;
+            continue;
+        }
+        imgData.initializeHuffmanTables();
+        imgData.initializeBlocks(imgData.width, imgData.height);
+        std::vector<uint8_t> pixelData(static_cast<size_t>(bmpRowSize(imgData)) * imgData.height, 0);
+        DecodeStageProfile profile;
+        DecodeStatus status = decodeJPEGProfiled(imgData, pixelData, counters, profile);
+        if (status != DecodeStatus::Ok) {
+            std::cerr << filename << ": 解码失败: " << decodeStatusMessage(status) << std::endl;
+            failures++;
+            continue;
+        }
+        std::cout << filename << ": " << imgData.width << "x" << imgData.height << ", " << profile.mcus << " MCUs"
+                  << std::endl;
+        printDecodeStageProfile(std::cout, profile);
+    }
+    return failures ? 1 : 0;
+}
+
+// 一次解码输出多级缩小图像：<prefix>_<比例>.<格式>
+static int pyramidFile(const std::string &inputFile, const std::string &prefix, const std::string &scaleList,
+                       OutputFormat format, bool lumaOnly) {
+    std::vector<int> scales;
+    if (!parsePyramidScales(scaleList, scales)) {
+        std::cerr << "无效的比例列表: " << scaleList << "（1、2、4、8，以逗号分隔）" << std::endl;
+        return -1;
+    }
+    ImageData imgData = parseJPEGHeader(inputFile, false);
+    if (!imgData.width || !imgData.height || !imgData.hasSupportedSampling()) {
+        std::cerr << "解析图像头部失败: " << inputFile << std::endl;
+        return -1;
+    }
+    imgData.lumaOnly = lumaOnly;
+    imgData.initializeHuffmanTables();
+    imgData.initializeBlocks(imgData.width, imgData.height);
+
+    std::vector<std::string> filenames;
+    for (int scale : scales) filenames.push_back(prefix + "_" + std::to_string(scale) + "." + outputFormatName(format));
+    DecodeStatus status = DecodeStatus::Ok;
+    if (!savePyramid(imgData, scales, filenames, format, status)) {
+        if (status != DecodeStatus::Ok) std::cerr << "解码失败: " << decodeStatusMessage(status) << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// 常驻解码服务：在 Unix 域套接字上接受请求；socketPath 为 "-" 时通过标准输入/输出收发。
+// cacheOptions 的内存容量为 0 且没有磁盘目录时不启用缓存
+static int runDecodeServer(const std::string &socketPath, int threadCount, const DecodeCacheOptions &cacheOptions,
+                           const DecodeLimits &limits) {
+    if (!limits.rootDirectory.empty() && !std::filesystem::is_directory(limits.rootDirectory)) {
+        std::cerr << "根目录不存在: " << limits.rootDirectory << std::endl;
+        return -1;
+    }
+    std::unique_ptr<DecodeCache> cache;
+    if (cacheOptions.memoryBytes > 0 || !cacheOptions.diskDirectory.empty()) {
+        cache = std::make_unique<DecodeCache>(cacheOptions);
+    }
+    if (socketPath == "-") {
+        DecodeWorkerBuffers buffers;
+        serveDecodeConnection(0, 1, buffers, cache.get(), limits);
+        return 0;
+    }
+    DecodeServer server;
+    if (!server.listen(socketPath)) {
+        std::cerr << "无法监听: " << socketPath << std::endl;
+        return -1;
+    }
+    std::cerr << "解码服务已启动: " << socketPath << "（" << threadCount << " 个工作线程）" << std::endl;
+    server.run(threadCount, cache.get(), limits);
+    return 0;
+}
+
+// 解析 --cache-mb、--max-megapixels 等以 unit 为单位的非负整数，结果乘上 unit 后不得超过 maxValue
+static bool parseScaledCount(const std::string &text, uint64_t unit, uint64_t maxValue, uint64_t &value) {
+    if (text.empty()) return false;
+    uint64_t count = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        uint64_t digit = static_cast<uint64_t>(c - '0');
+        if (count > (UINT64_MAX - digit) / 10) return false;
+        count = count * 10 + digit;
+    }
+    if (count > maxValue / unit) return false;
+    value = count * unit;
+    return true;
+}
+
+// --trace：main 返回时把记录的时间线写成 Chrome trace JSON
+struct TraceOutput {
+    std::string filename;
+    ~TraceOutput() {
+        if (filename.empty()) return;
+        stopDecodeTrace();
+        if (writeDecodeTrace(filename)) {
+            std::cerr << "时间线已写入 " << filename << "（" << decodeTraceEventCount() << " 个事件）" << std::endl;
+        } else {
+            std::cerr << "无法写入时间线: " << filename << std::endl;
+        }
+    }
+};
+
+int main(int argc, char *argv[]) {
+    // 用法: jpeg_parser [--luma] [--threads N] [输入 JPEG] [输出 BMP]，默认解码 lena
+    // --luma: 仅解码亮度，输出 8 位灰度 BMP
+    // --threads N: 流水线解码，熵解码与 N 个重建线程并发
+    // --entropy-threads N: 没有重启间隔的图像用 N 个线程推测式并行熵解码，再整体重建
+    // --format <bmp|yuv420p|rgb|rgba|qoi>: 输出格式，yuv420p 直接写重建的 Y/Cb/Cr 平面，rgb/rgba 为自上而下的打包像素，
+    //     qoi 为按 MCU 行流式编码的无损 QOI
+    // --stride N: rgb/rgba 每行字节数（默认紧密排列）
+    //        jpeg_parser --probe <输入 JPEG>                    只读标记段，打印尺寸、采样等元数据
+    //        jpeg_parser --index <目录> <输出 CSV> [--threads N]  并行探测目录树中的所有 JPEG
+    //        jpeg_parser --verify <输入 JPEG...>                只检查熵编码数据的完整性
+    //        jpeg_parser --stats <输入 JPEG>                    由 DCT 系数计算感知哈希与颜色统计
+    //        jpeg_parser --optimize <输入 JPEG> <输出 JPEG>       无损重新优化哈夫曼表
+    //        jpeg_parser --crop x,y,w,h [--mcu-index <索引>] <输入 JPEG> <输出 BMP>  解码一个矩形区域
+    //        jpeg_parser --mjpeg [--threads N] <MJPEG 流> [输出前缀]  多线程解码 MJPEG 流，按帧序输出
+    //        jpeg_parser --stdin <输出 BMP>                    从标准输入边接收边解码
+    //        jpeg_parser --pyramid 1,2,4,8 [--luma] [--format bmp|rgb|rgba|qoi] <输入 JPEG> <输出前缀>
+    //                                                          一次熵解码输出多级缩小图像 <前缀>_<比例>.<格式>
+    //        jpeg_parser --serve <套接字|-> [--threads N]      常驻解码服务（协议见 decode_server.h）
+    //            [--cache-mb N] [--cache-dir <目录>] [--cache-disk-mb N]  解码结果缓存：内存层容量、磁盘层目录与容量
+    //            [--max-input-mb N] [--max-megapixels N]      单个请求的 JPEG 字节数与像素数上限
+    //            [--root <目录>]                              请求中的 JPEG 路径与 out= 路径限定在此目录内（不给出时不接受路径）
+    //        jpeg_parser --perf <输入 JPEG...>                  各解码阶段的耗时与硬件计数器（IPC、每 MCU 未命中）
+    // --save-mcu-index <索引> [--index-interval N]: 完整解码时记录 MCU 检查点（默认每个 MCU 行一个）
+    // --transform <flip-h|flip-v|transpose|rot90|rot180|rot270>: 在 DCT 域无损旋转/镜像后再重建
+    // --dump-scan <输出文件>: 把去除填充字节后的熵编码数据写入文件（调试用）
+    // --trace <输出 JSON>: 记录各线程的解析、熵解码、重建与输出事件，写成 Chrome trace-event JSON
+    bool lumaOnly = false;
+    bool probeMode = false;
+    bool indexMode = false;
+    bool verifyMode = false;
+    bool statsMode = false;
+    bool optimizeMode = false;
+    bool mjpegMode = false;
+    bool stdinMode = false;
+    bool perfMode = false;
+    std::string serveSocket;
+    DecodeCacheOptions cacheOptions;
+    cacheOptions.memoryBytes = 0;
+    DecodeLimits serveLimits;
+    TraceOutput traceOutput;
+    std::string cropRect;
+    std::string pyramidScales;
+    std::string mcuIndexFile;
+    std::string saveMcuIndexFile;
+    std::string dumpScanFile;
+    int indexInterval = 0;
+    int pipelineThreads = 0;
+    int entropyThreads = 0;
+    OutputFormat outputFormat = OutputFormat::Bmp;
+    int outputStride = 0;
+    DctTransform transform = DctTransform::None;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--luma") {
+            lumaOnly = true;
+        } else if (arg == "--probe") {
+            probeMode = true;
+        } else if (arg == "--index") {
+            indexMode = true;
+        } else if (arg == "--verify") {
+            verifyMode = true;
+        } else if (arg == "--stats") {
+            statsMode = true;
+        } else if (arg == "--optimize") {
+            optimizeMode = true;
+        } else if (arg == "--mjpeg") {
+            mjpegMode = true;
+        } else if (arg == "--stdin") {
+            stdinMode = true;
+        } else if (arg == "--perf") {
+            perfMode = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            traceOutput.filename = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            serveSocket = argv[++i];
+        } else if ((arg == "--cache-mb" || arg == "--cache-disk-mb" || arg == "--max-input-mb" ||
+                    arg == "--max-megapixels") && i + 1 < argc) {
+            bool megapixels = arg == "--max-megapixels";
+            uint64_t value = 0;
+            if (!parseScaledCount(argv[++i], megapixels ? 1000000 : uint64_t(1) << 20, megapixels ? UINT64_MAX : SIZE_MAX,
+                                  value)) {
+                std::cerr << "无效的 " << arg << ": " << argv[i] << "（0 到 "
+                          << (megapixels ? UINT64_MAX / 1000000 : SIZE_MAX >> 20) << " 之间的整数）" << std::endl;
+                return -1;
+            }
+            if (arg == "--cache-mb") {
+                cacheOptions.memoryBytes = static_cast<size_t>(value);
+            } else if (arg == "--cache-disk-mb") {
+                cacheOptions.diskBytes = value;
+            } else if (arg == "--max-input-mb") {
+                serveLimits.maxInputBytes = static_cast<size_t>(value);
+            } else {
+                serveLimits.maxPixels = value;
+            }
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            cacheOptions.diskDirectory = argv[++i];
+        } else if (arg == "--root" && i + 1 < argc) {
+            serveLimits.rootDirectory = argv[++i];
+        } else if (arg == "--crop" && i + 1 < argc) {
+            cropRect = argv[++i];
+        } else if (arg == "--pyramid" && i + 1 < argc) {
+            pyramidScales = argv[++i];
+        } else if (arg == "--mcu-index" && i + 1 < argc) {
+            mcuIndexFile = argv[++i];
+        } else if (arg == "--save-mcu-index" && i + 1 < argc) {
+            saveMcuIndexFile = argv[++i];
+        } else if (arg == "--dump-scan" && i + 1 < argc) {
+            dumpScanFile = argv[++i];
+        } else if (arg == "--index-interval" && i + 1 < argc) {
+            indexInterval = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            pipelineThreads = std::stoi(argv[++i]);
+        } else if (arg == "--entropy-threads" && i + 1 < argc) {
+            entropyThreads = std::stoi(argv[++i]);
+        } else if (arg == "--format" && i + 1 < argc) {
+            if (!parseOutputFormat(argv[++i], outputFormat)) {
+                std::cerr << "未知输出格式: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--stride" && i + 1 < argc) {
+            outputStride = std::stoi(argv[++i]);
+            if (outputStride <= 0) {
+                std::cerr << "无效的行跨度: " << outputStride << std::endl;
+                return -1;
+            }
+        } else if (arg == "--transform" && i + 1 < argc) {
+            if (!parseDctTransform(argv[++i], transform)) {
+                std::cerr << "未知变换: " << argv[i] << std::endl;
+                return -1;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (!traceOutput.filename.empty()) {
+        setTraceThreadName("main");
+        startDecodeTrace();
+    }
+
+    std::string filename = args.size() > 0 ? args[0] : "../input/lena.jpg";
+    if (verifyMode) {
+        return verifyFiles(args);
+    }
+    if (perfMode) {
+        if (args.empty()) args.push_back(filename);
+        return profileFiles(args);
+    }
+    if (statsMode) {
+        return printDctStats(filename);
+    }
+    if (!cropRect.empty()) {
+        if (args.size() < 2) {
+            std::cerr << "用法: jpeg_parser --crop x,y,w,h [--mcu-index <索引>] <输入 JPEG> <输出 BMP>" << std::endl;
+            return -1;
+        }
+        return cropFile(args[0], args[1], cropRect, mcuIndexFile);
+    }
+    if (!pyramidScales.empty()) {
+        if (args.size() < 2) {
+            std::cerr << "用法: jpeg_parser --pyramid 1,2,4,8 [--format bmp|rgb|rgba|qoi] <输入 JPEG> <输出前缀>"
+                      << std::endl;
+            return -1;
+        }
+        return pyramidFile(args[0], args[1], pyramidScales, outputFormat, lumaOnly);
+    }
+    if (!serveSocket.empty()) {
+        int threadCount = pipelineThreads > 0 ? pipelineThreads : static_cast<int>(std::thread::hardware_concurrency());
+        return runDecodeServer(serveSocket, std::max(threadCount, 1), cacheOptions, serveLimits);
+    }
+    if (stdinMode) {
+        if (args.empty()) {
+            std::cerr << "用法: jpeg_parser --stdin <输出 BMP>" << std::endl;
+            return -1;
+        }
+        return decodeFromStdin(args[0]);
+    }
+    if (mjpegMode) {
+        if (args.empty()) {
+            std::cerr << "用法: jpeg_parser --mjpeg [--threads N] <MJPEG 流> [输出前缀]" << std::endl;
+            return -1;
+        }
+        int threadCount = pipelineThreads > 0 ? pipelineThreads : static_cast<int>(std::thread::hardware_concurrency());
+        return decodeMjpegFile(args[0], args.size() > 1 ? args[1] : "", threadCount);
+    }
+    if (optimizeMode) {
+        if (args.size() < 2) {
+            std::cerr << "用法: jpeg_parser --optimize <输入 JPEG> <输出 JPEG>" << std::endl;
+            return -1;
+        }
+        return optimizeFile(args[0], args[1]);
+    }
+    if (probeMode) {
+        return printProbe(filename);
+    }
+    if (indexMode) {
+        if (args.size() < 2) {
+            std::cerr << "用法: jpeg_parser --index <目录> <输出 CSV> [--threads N]" << std::endl;
+            return -1;
+        }
+        int threadCount = pipelineThreads > 0 ? pipelineThreads : static_cast<int>(std::thread::hardware_concurrency());
+        int indexed = indexJPEGTree(args[0], args[1], threadCount);
+        std::cout << "已索引 " << indexed << " 个文件" << std::endl;
+        return 0;
+    }
+
     ImageData imgData = parseJPEGHeader(filename);
 
     if (imgData.width && imgData.height) {
@@ -69,19 +612,61 @@ int main() {
         std::cout << std::endl;
     }
 
-    saveCompressedData(imgData.compressedData, "../input/sos_compressed_data.bin");    
+    if (!dumpScanFile.empty()) saveCompressedData(imgData.compressedData, dumpScanFile);
     
     // 初始化图像数据块结构
-    imgData.initializeBlocks(imgData.width, imgData.width);
+    imgData.lumaOnly = lumaOnly;
+    if (outputFormat != OutputFormat::Bmp || transform != DctTransform::None || !saveMcuIndexFile.empty()) {
+        pipelineThreads = 0;  // 流水线直接生成 BMP 像素，且不保留整幅图像的系数
+    }
+    if (pipelineThreads > 0) {
+        imgData.initializeMcuLayout(imgData.width, imgData.height);  // 系数只存在于流水线的行缓冲中
+    } else {
+        imgData.initializeBlocks(imgData.width, imgData.height);
+    }
     std::cout << imgData.totalBlocks << std::endl;
     std::cout << imgData.compressedData.size() << std::endl;
 
     // 解码 JPEG
-    decodeJPEG(imgData, imgData.compressedData);
+    std::vector<uint8_t> pixelData;
+    DecodeStatus status;
+    if (transform != DctTransform::None) {
+        // 熵解码后先在系数上做几何变换，再重建像素（流水线模式不适用）
+        status = huffmanDecode(imgData.compressedData, imgData);
+        if (status == DecodeStatus::Ok) {
+            transformCoefficients(imgData, transform);
+            reconstructImage(imgData);
+        }
+    } else if (!saveMcuIndexFile.empty()) {
+        // 完整解码的同时记录检查点，之后的区域解码可直接从检查点开始
+        McuIndex index;
+        status = huffmanDecodeWithIndex(imgData.compressedData, imgData, indexInterval, index);
+        if (status == DecodeStatus::Ok) {
+            reconstructImage(imgData);
+            if (!saveMcuIndex(saveMcuIndexFile, index)) {
+                std::cerr << "无法写入 MCU 索引: " << saveMcuIndexFile << std::endl;
+            }
+        }
+    } else if (pipelineThreads > 0) {
+        status = decodeJPEGPipelined(imgData, imgData.compressedData, pixelData, pipelineThreads);
+    } else if (entropyThreads > 1) {
+        SpeculativeDecodeStats stats;
+        status = speculativeHuffmanDecode(imgData.compressedData, imgData, entropyThreads, &stats);
+        std::cout << "推测式熵解码: " << stats.chunks << " 段, " << stats.syncedChunks << " 段同步, 重新解码 "
+                  << stats.redecodedBlocks << " / " << stats.blocks << " 块" << std::endl;
+        if (status == DecodeStatus::Ok) reconstructImage(imgData);
+    } else {
+        status = decodeJPEG(imgData, imgData.compressedData);
+    }
+    if (status != DecodeStatus::Ok) {
+        std::cerr << "解码失败: " << decodeStatusMessage(status) << std::endl;
+        return -1;
+    }
 
     // 输出解码后的信息以检查正确性（示例输出前5个块的亮度值）
     int count = 0;
-    for (int id = 0; id < 6; id++)
+    int storedYBlocks = static_cast<int>(imgData.Y.size());  // 流水线解码不保留整幅图像的系数
+    for (int id = 0; id < 6 && id < storedYBlocks; id++)
     {
         std::cout << "Block " << id << " Y values (8x8):" << std::endl;
         for (int row = 0; row < 8; row++)
@@ -94,7 +679,7 @@ int main() {
         }
         std::cout << std::endl;
     }
-    for (int block = 0; block < imgData.totalYBlocks; ++block) {
+    for (int block = 0; block < storedYBlocks; ++block) {
         bool flag = false;
         for (int row = 0; row < 8; ++row) {
             for (int col = 0; col < 8; ++col) {
@@ -123,11 +708,19 @@ int main() {
 
 
     // 指定 BMP 输出文件路径
-    std::string outputFilename = "../output/lena_decoded.bmp";
+    std::string outputFilename = args.size() > 1 ? args[1] : "../output/lena_decoded.bmp";
     
-    // 保存解码后的图像为 BMP 文件
+    // 保存解码后的图像为 BMP 文件：灰度图像或仅亮度模式直接写 8 位调色板 BMP
     // saveAsImage(outputFilename, imgData);
-    saveAsBMP(outputFilename, imgData);
+    if (pipelineThreads > 0) {
+        writeBMP(outputFilename, imgData, pixelData);  // 流水线已生成像素
+    } else if (outputFormat != OutputFormat::Bmp) {
+        if (!saveDecodedImage(outputFilename, imgData, outputFormat, outputStride)) return -1;
+    } else if (imgData.isGrayscale() || imgData.lumaOnly) {
+        saveAsGrayBMP(outputFilename, imgData);
+    } else {
+        saveAsBMP(outputFilename, imgData);
+    }
     
     return 0;
 }
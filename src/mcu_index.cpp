@@ -0,0 +1,225 @@
+#include "mcu_index.h"
+#include "jpeg_decoder.h"
+#include "save_as_bmp.h"
+#include <algorithm>
+#include <fstream>
+
+static int checkpointInterval(const ImageData &imgData, int interval) {
+    return interval > 0 ? interval : std::max(imgData.mcuWidth, 1);
+}
+
+static void startIndex(const ImageData &imgData, int interval, McuIndex &index) {
+    index.width = imgData.width;
+    index.height = imgData.height;
+    index.interval = interval;
+    index.dataSize = imgData.compressedData.size();
+    index.checkpoints.clear();
+    index.checkpoints.reserve(imgData.totalBlocks / interval + 1);
+}
+
+static void recordCheckpoint(const HuffmanDecodeState &state, McuIndex &index) {
+    McuCheckpoint checkpoint;
+    checkpoint.bitOffset = state.reader.bitOffset();
+    std::copy(state.previousDc, state.previousDc + 3, checkpoint.previousDc);
+    index.checkpoints.push_back(checkpoint);
+}
+
+DecodeStatus huffmanDecodeWithIndex(const std::vector<uint8_t> &compressedData, ImageData &imgData, int interval,
+                                    McuIndex &index) {
+    interval = checkpointInterval(imgData, interval);
+    startIndex(imgData, interval, index);
+
+    HuffmanDecodeState state(compressedData);
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    for (int mcu = 0; status == DecodeStatus::Ok && mcu < imgData.totalBlocks; ++mcu) {
+        if (mcu % interval == 0) recordCheckpoint(state, index);
+        status = decodeMcu(state, imgData, mcu);
+    }
+    return status;
+}
+
+DecodeStatus buildMcuIndex(const ImageData &imgData, int interval, McuIndex &index) {
+    interval = checkpointInterval(imgData, interval);
+    startIndex(imgData, interval, index);
+
+    HuffmanDecodeState state(imgData.compressedData);
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    Coefficient *const skip[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    for (int mcu = 0; status == DecodeStatus::Ok && mcu < imgData.totalBlocks; ++mcu) {
+        if (mcu % interval == 0) recordCheckpoint(state, index);
+        status = decodeMcuBlocks(state, imgData, mcu, skip);
+    }
+    return status;
+}
+
+static void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static bool getVarint(const std::vector<uint8_t> &data, size_t &pos, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+        uint8_t byte = data[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// 有符号数映射为无符号：0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+static uint64_t zigzagEncode(int value) {
+    return value < 0 ? (static_cast<uint64_t>(-(value + 1)) << 1) | 1 : static_cast<uint64_t>(value) << 1;
+}
+
+static int zigzagDecode(uint64_t value) {
+    return (value & 1) ? -static_cast<int>(value >> 1) - 1 : static_cast<int>(value >> 1);
+}
+
+static const char INDEX_MAGIC[4] = {'J', 'M', 'C', 'I'};
+static const int INDEX_VERSION = 1;
+
+bool saveMcuIndex(const std::string &filename, const McuIndex &index) {
+    std::vector<uint8_t> out(INDEX_MAGIC, INDEX_MAGIC + 4);
+    putVarint(out, INDEX_VERSION);
+    putVarint(out, index.width);
+    putVarint(out, index.height);
+    putVarint(out, index.interval);
+    putVarint(out, index.dataSize);
+    putVarint(out, index.checkpoints.size());
+    uint64_t previousOffset = 0;
+    for (const McuCheckpoint &checkpoint : index.checkpoints) {
+        putVarint(out, checkpoint.bitOffset - previousOffset);
+        previousOffset = checkpoint.bitOffset;
+        for (int dc : checkpoint.previousDc) putVarint(out, zigzagEncode(dc));
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    return static_cast<bool>(file);
+}
+
+bool loadMcuIndex(const std::string &filename, McuIndex &index) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 4 || !std::equal(INDEX_MAGIC, INDEX_MAGIC + 4, data.begin())) return false;
+
+    size_t pos = 4;
+    uint64_t version, width, height, interval, dataSize, count;
+    if (!getVarint(data, pos, version) || version != INDEX_VERSION || !getVarint(data, pos, width) ||
+        !getVarint(data, pos, height) || !getVarint(data, pos, interval) || !getVarint(data, pos, dataSize) ||
+        !getVarint(data, pos, count) || interval == 0 || count > data.size()) {
+        return false;
+    }
+    index.width = static_cast<int>(width);
+    index.height = static_cast<int>(height);
+    index.interval = static_cast<int>(interval);
+    index.dataSize = dataSize;
+    index.checkpoints.assign(count, McuCheckpoint());
+
+    uint64_t offset = 0;
+    for (McuCheckpoint &checkpoint : index.checkpoints) {
+        uint64_t delta, dc;
+        if (!getVarint(data, pos, delta)) return false;
+        offset += delta;
+        checkpoint.bitOffset = offset;
+        for (int &previousDc : checkpoint.previousDc) {
+            if (!getVarint(data, pos, dc)) return false;
+            previousDc = zigzagDecode(dc);
+        }
+    }
+    return true;
+}
+
+bool mcuIndexMatches(const McuIndex &index, const ImageData &imgData) {
+    return index.width == imgData.width && index.height == imgData.height &&
+           index.dataSize == imgData.compressedData.size() && index.interval > 0 &&
+           index.checkpoints.size() == static_cast<size_t>((imgData.totalBlocks + index.interval - 1) / index.interval);
+}
+
+DecodeStatus decodeRegion(const ImageData &imgData, const McuIndex *index, int x, int y, int width, int height,
+                          RawImage &region) {
+    // 裁剪到图像范围内
+    int x1 = std::min(x + width, imgData.width), y1 = std::min(y + height, imgData.height);
+    x = std::max(x, 0);
+    y = std::max(y, 0);
+    int channels = imgData.hasChroma() ? 3 : 1;
+    region = RawImage();
+    region.channels = channels;
+    if (x >= x1 || y >= y1) return DecodeStatus::Ok;
+
+    int size = imgData.mcuSize();
+    int col0 = x / size, col1 = (x1 - 1) / size;
+    int row0 = y / size, row1 = (y1 - 1) / size;
+
+    // 只覆盖矩形所在 MCU 的小图像，重建时复用完整图像的逆量化、IDCT 与像素转换
+    ImageData tile;
+    tile.colorComponents = imgData.colorComponents;
+    tile.lumaOnly = imgData.lumaOnly;
+    tile.yQuantTableId = imgData.yQuantTableId;
+    tile.crCbQuantTableId = imgData.crCbQuantTableId;
+    tile.quantizationTables = imgData.quantizationTables;
+    tile.initializeBlocks((col1 - col0 + 1) * size, (row1 - row0 + 1) * size);
+
+    HuffmanDecodeState state(imgData.compressedData);
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    if (status != DecodeStatus::Ok) return status;
+    if (index && !mcuIndexMatches(*index, imgData)) index = nullptr;
+
+    Coefficient *const skip[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    int nextMcu = 0;  // 熵解码器当前所在的 MCU
+    for (int row = row0; row <= row1; ++row) {
+        int first = row * imgData.mcuWidth + col0;
+        int last = row * imgData.mcuWidth + col1;
+
+        // 最近的检查点在当前位置之后时直接跳过去
+        if (index) {
+            int checkpoint = first / index->interval;
+            int checkpointMcu = checkpoint * index->interval;
+            if (checkpointMcu > nextMcu) {
+                state.reader.seekBit(index->checkpoints[checkpoint].bitOffset);
+                std::copy(index->checkpoints[checkpoint].previousDc, index->checkpoints[checkpoint].previousDc + 3,
+                          state.previousDc);
+                nextMcu = checkpointMcu;
+            }
+        }
+
+        for (; nextMcu <= last; ++nextMcu) {
+            if (nextMcu < first) {
+                status = decodeMcuBlocks(state, imgData, nextMcu, skip);
+            } else {
+                int t = (row - row0) * tile.mcuWidth + (nextMcu - first);
+                if (tile.isGrayscale()) {
+                    Coefficient *const blocks[6] = {&tile.Y[t][0], nullptr, nullptr, nullptr, nullptr, nullptr};
+                    status = decodeMcuBlocks(state, imgData, nextMcu, blocks);
+                } else {
+                    Coefficient *const blocks[6] = {&tile.Y[t * 4][0], &tile.Y[t * 4 + 1][0], &tile.Y[t * 4 + 2][0],
+                                                    &tile.Y[t * 4 + 3][0], tile.hasChroma() ? &tile.Cb[t][0] : nullptr,
+                                                    tile.hasChroma() ? &tile.Cr[t][0] : nullptr};
+                    status = decodeMcuBlocks(state, imgData, nextMcu, blocks);
+                }
+            }
+            if (status != DecodeStatus::Ok) return status;
+        }
+    }
+
+    reconstructImage(tile);
+    std::vector<uint8_t> pixelData(bmpRowSize(tile) * tile.height, 0);
+    fillBMPRows(tile, 0, tile.mcuHeight, pixelData);
+    RawImage tilePixels = rawImageFromBMPRows(pixelData, tile.width, tile.height, channels);
+
+    // 从 MCU 对齐的小图像中取出请求的矩形
+    int offsetX = x - col0 * size, offsetY = y - row0 * size;
+    region.width = x1 - x;
+    region.height = y1 - y;
+    region.pixels.resize(static_cast<size_t>(region.width) * region.height * channels);
+    for (int row = 0; row < region.height; ++row) {
+        const uint8_t *src = &tilePixels.pixels[(static_cast<size_t>(offsetY + row) * tile.width + offsetX) * channels];
+        std::copy(src, src + region.width * channels, &region.pixels[static_cast<size_t>(row) * region.width * channels]);
+    }
+    return DecodeStatus::Ok;
+}
@@ -0,0 +1,225 @@
+#include "mjpeg_stream.h"
+#include "jpeg_decoder.h"
+#include "decode_trace.h"
+#include "jpeg_encoder.h"
+#include "save_as_bmp.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// 从 SOI 之后扫描一帧，返回帧的结束位置（EOI 之后，或截断处）
+static size_t scanFrame(const uint8_t *data, size_t size, size_t pos, MjpegFrame &frame) {
+    // 头部：逐段按长度跳过，直到 SOS
+    while (true) {
+        while (pos + 1 < size && data[pos] == 0xFF && data[pos + 1] == 0xFF) pos++;  // 标记前的填充字节
+        if (pos + 1 >= size) return size;
+        if (data[pos] != 0xFF) return pos;  // 格式错误，本帧到此为止
+        uint8_t marker = data[pos + 1];
+        if (marker == EOI) {
+            frame.complete = true;
+            return pos + 2;
+        }
+        if (marker == SOI) return pos;  // 上一帧没有扫描数据就开始了新帧
+        if (pos + 4 > size) return size;
+        size_t length = (data[pos + 2] << 8) | data[pos + 3];
+        if (length < 2) return pos + 2;
+        if (marker == DHT) frame.hasHuffmanTables = true;
+        if (marker == DQT) frame.hasQuantTables = true;
+        pos += 2 + length;
+        if (pos > size) return size;
+        if (marker == SOS) {
+            frame.headerSize = pos - frame.offset;
+            break;
+        }
+    }
+
+    // 熵编码数据：跳过填充的 0xFF00 与 RSTn，遇到其他标记即结束
+    while (pos + 1 < size) {
+        const void *found = std::memchr(data + pos, 0xFF, size - pos - 1);
+        if (!found) return size;
+        pos = static_cast<const uint8_t *>(found) - data;
+        uint8_t next = data[pos + 1];
+        if (next == 0xFF) {
+            pos++;
+        } else if (next == 0x00 || (next >= 0xD0 && next <= 0xD7)) {
+            pos += 2;
+        } else if (next == EOI) {
+            frame.complete = true;
+            return pos + 2;
+        } else {
+            return pos;  // 其他标记（如下一帧的 SOI）：本帧被截断
+        }
+    }
+    return size;
+}
+
+std::vector<MjpegFrame> splitMjpegFrames(const uint8_t *data, size_t size) {
+    std::vector<MjpegFrame> frames;
+    size_t pos = 0;
+    while (pos + 1 < size) {
+        const void *found = std::memchr(data + pos, 0xFF, size - pos - 1);
+        if (!found) break;
+        pos = static_cast<const uint8_t *>(found) - data;
+        if (data[pos + 1] != SOI) {
+            pos++;
+            continue;
+        }
+        MjpegFrame frame;
+        frame.offset = pos;
+        size_t end = scanFrame(data, size, pos + 2, frame);
+        frame.size = end - frame.offset;
+        frames.push_back(frame);
+        pos = end;
+    }
+    return frames;
+}
+
+// 一帧解码时使用的量化表与哈夫曼表，在表没有变化的帧之间共享（只读）
+struct FrameTables {
+    std::map<int, std::vector<int>> quantizationTables;
+    std::vector<HuffmanTable> huffmanTables;
+};
+
+// 顺序解析各帧头部，得到每帧生效的表：标准哈夫曼表打底，帧内定义的表覆盖之前的表
+static std::vector<std::shared_ptr<const FrameTables>> resolveFrameTables(const uint8_t *data,
+                                                                          const std::vector<MjpegFrame> &frames) {
+    auto current = std::make_shared<FrameTables>();
+    for (int id = 0; id < 2; ++id) {
+        current->huffmanTables.push_back(standardDcTable(id).spec);
+        current->huffmanTables.push_back(standardAcTable(id).spec);
+    }
+    for (HuffmanTable &table : current->huffmanTables) table.buildHuffmanCodes();
+
+    std::vector<std::shared_ptr<const FrameTables>> result;
+    result.reserve(frames.size());
+    std::shared_ptr<const FrameTables> shared = current;
+    for (const MjpegFrame &frame : frames) {
+        if (frame.headerSize && (frame.hasHuffmanTables || frame.hasQuantTables)) {
+            ImageData header = parseJPEGMemory(data + frame.offset, frame.headerSize);
+            auto next = std::make_shared<FrameTables>(*shared);
+            for (const auto &[id, table] : header.quantizationTables) {
+                next->quantizationTables[id] = table;
+            }
+            for (HuffmanTable &table : header.huffmanTables) {
+                table.buildHuffmanCodes();
+                auto existing = std::find_if(next->huffmanTables.begin(), next->huffmanTables.end(),
+                                             [&](const HuffmanTable &other) {
+                                                 return other.tableClass == table.tableClass &&
+                                                        other.tableId == table.tableId;
+                                             });
+                if (existing != next->huffmanTables.end()) {
+                    *existing = std::move(table);
+                } else {
+                    next->huffmanTables.push_back(std::move(table));
+                }
+            }
+            shared = next;
+        }
+        result.push_back(shared);
+    }
+    return result;
+}
+
+// 解码一帧并转换为 BMP 像素
+static DecodedFrame decodeFrame(const uint8_t *data, const MjpegFrame &frame, const FrameTables &tables,
+                                size_t index) {
+    TraceScope trace("frame", static_cast<int>(index));
+    DecodedFrame decoded;
+    decoded.index = index;
+    decoded.defaultHuffmanTables = !frame.hasHuffmanTables;
+
+    ImageData imgData = parseJPEGMemory(data + frame.offset, frame.size);
+    imgData.quantizationTables = tables.quantizationTables;
+    imgData.huffmanTables = tables.huffmanTables;
+    if (!frame.headerSize || !imgData.width || !imgData.height || !imgData.hasSupportedSampling() ||
+        !imgData.hasRequiredQuantTables()) {
+        decoded.status = DecodeStatus::InvalidHeader;
+        return decoded;
+    }
+
+    imgData.initializeBlocks(imgData.width, imgData.height);
+    decoded.status = decodeJPEG(imgData, imgData.compressedData);
+    if (decoded.status != DecodeStatus::Ok) return decoded;
+
+    decoded.width = imgData.width;
+    decoded.height = imgData.height;
+    decoded.channels = imgData.isGrayscale() ? 1 : 3;
+    decoded.pixelData.assign(static_cast<size_t>(bmpRowSize(imgData)) * imgData.height, 0);
+    fillBMPRows(imgData, 0, imgData.mcuHeight, decoded.pixelData);
+    return decoded;
+}
+
+MjpegStreamReport decodeMjpegStream(const uint8_t *data, size_t size, const MjpegDecodeOptions &options,
+                                    const MjpegFrameCallback &onFrame) {
+    std::vector<MjpegFrame> frames = splitMjpegFrames(data, size);
+    std::vector<std::shared_ptr<const FrameTables>> tables = resolveFrameTables(data, frames);
+
+    MjpegStreamReport report;
+    report.frames = frames.size();
+    auto deliver = [&](const DecodedFrame &decoded) {
+        if (decoded.status != DecodeStatus::Ok) report.failedFrames++;
+        if (decoded.defaultHuffmanTables) report.defaultTableFrames++;
+        onFrame(decoded);
+    };
+
+    int threadCount = std::max(options.threadCount, 1);
+    if (threadCount == 1) {
+        for (size_t i = 0; i < frames.size(); ++i) {
+            deliver(decodeFrame(data, frames[i], *tables[i], i));
+        }
+        return report;
+    }
+
+    // 工作线程按帧序号领取任务；领先已交付帧超过 window 的线程先等待，限制缓存的帧数
+    size_t window = options.maxFramesInFlight > 0 ? options.maxFramesInFlight : 2 * threadCount;
+    std::atomic<size_t> nextFrame{0};
+    std::mutex mutex;
+    std::condition_variable frameReady;   // 有帧解码完成
+    std::condition_variable windowMoved;  // 有帧被交付
+    std::map<size_t, DecodedFrame> pending;
+    size_t delivered = 0;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t]() {
+            setTraceThreadName("mjpeg worker " + std::to_string(t));
+            while (true) {
+                size_t index = nextFrame.fetch_add(1);
+                if (index >= frames.size()) break;
+                {
+                    TraceScope trace("wait for window", static_cast<int>(index));
+                    std::unique_lock<std::mutex> lock(mutex);
+                    windowMoved.wait(lock, [&]() { return index < delivered + window; });
+                }
+                DecodedFrame decoded = decodeFrame(data, frames[index], *tables[index], index);
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.emplace(index, std::move(decoded));
+                frameReady.notify_one();
+            }
+        });
+    }
+
+    // 调用线程按顺序交付；回调期间不持有锁，工作线程可以继续解码
+    for (size_t i = 0; i < frames.size(); ++i) {
+        DecodedFrame decoded;
+        {
+            TraceScope trace("wait for frame", static_cast<int>(i));
+            std::unique_lock<std::mutex> lock(mutex);
+            frameReady.wait(lock, [&]() { return pending.count(i) > 0; });
+            auto it = pending.find(i);
+            decoded = std::move(it->second);
+            pending.erase(it);
+            delivered = i + 1;
+        }
+        windowMoved.notify_all();
+        TraceScope trace("deliver frame", static_cast<int>(i));
+        deliver(decoded);
+    }
+    for (std::thread &worker : workers) worker.join();
+    return report;
+}
@@ -0,0 +1,221 @@
+#include "perf_counters.h"
+#include "inverse_dct.h"
+#include "inverse_quantize.h"
+#include "inverse_zigzag.h"
+#include "save_as_bmp.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static constexpr int eventCount = static_cast<int>(PerfEvent::Count);
+static constexpr int stageCount = static_cast<int>(DecodeStage::Count);
+
+const char *perfEventName(PerfEvent event) {
+    switch (event) {
+    case PerfEvent::Cycles: return "cycles";
+    case PerfEvent::Instructions: return "instructions";
+    case PerfEvent::BranchMisses: return "branch-misses";
+    case PerfEvent::L1dMisses: return "L1d-misses";
+    case PerfEvent::LlcMisses: return "LLC-misses";
+    default: return "?";
+    }
+}
+
+PerfSample &PerfSample::operator+=(const PerfSample &other) {
+    // 只要有一次采样缺失，合计值就没有意义
+    for (int i = 0; i < eventCount; ++i) {
+        valid[i] = valid[i] && other.valid[i];
+        values[i] += other.values[i];
+    }
+    return *this;
+}
+
+#ifdef __linux__
+static int openEvent(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;   // perf_event_paranoid = 2 时只允许统计用户态
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+PerfCounters::PerfCounters() {
+    for (int &fd : fds) fd = -1;
+#ifdef __linux__
+    const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const std::pair<uint32_t, uint64_t> events[eventCount] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, l1dReadMiss},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    };
+    for (int i = 0; i < eventCount; ++i) {
+        fds[i] = openEvent(events[i].first, events[i].second);
+        if (fds[i] < 0 && openError.empty()) openError = std::strerror(errno);
+    }
+#else
+    openError = "perf_event_open is Linux only";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+// 计数器打开后一直在计数，start/stop 只读取当前值求差，不需要 ioctl
+void PerfCounters::start() {
+#ifdef __linux__
+    for (int i = 0; i < eventCount; ++i) {
+        if (fds[i] < 0 || read(fds[i], startValues[i], sizeof(startValues[i])) != sizeof(startValues[i])) {
+            std::memset(startValues[i], 0, sizeof(startValues[i]));
+        }
+    }
+#endif
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+#ifdef __linux__
+    for (int i = 0; i < eventCount; ++i) {
+        uint64_t now[3];  // 计数值、启用时间、实际运行时间
+        if (fds[i] < 0 || read(fds[i], now, sizeof(now)) != sizeof(now)) continue;
+        uint64_t value = now[0] - startValues[i][0];
+        uint64_t enabled = now[1] - startValues[i][1];
+        uint64_t running = now[2] - startValues[i][2];
+        if (running == 0) {
+            // 这段时间内没有被调度到 PMU 上（计数器被其他进程占满）
+            sample.valid[i] = enabled == 0;
+            continue;
+        }
+        if (running < enabled) {
+            value = static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+        }
+        sample.values[i] = value;
+        sample.valid[i] = true;
+    }
+#endif
+    return sample;
+}
+
+const char *decodeStageName(DecodeStage stage) {
+    switch (stage) {
+    case DecodeStage::Huffman: return "huffman";
+    case DecodeStage::Dequantize: return "dequantize";
+    case DecodeStage::ZigZag: return "zigzag";
+    case DecodeStage::IDCT: return "idct";
+    case DecodeStage::ColorConvert: return "color+bmp";
+    default: return "?";
+    }
+}
+
+DecodeStageProfile &DecodeStageProfile::operator+=(const DecodeStageProfile &other) {
+    if (images == 0) return *this = other;
+    for (int s = 0; s < stageCount; ++s) {
+        milliseconds[s] += other.milliseconds[s];
+        counters[s] += other.counters[s];
+    }
+    mcus += other.mcus;
+    images += other.images;
+    return *this;
+}
+
+DecodeStatus decodeJPEGProfiled(ImageData &imgData, std::vector<uint8_t> &pixelData, PerfCounters &counters,
+                                DecodeStageProfile &profile) {
+    profile = DecodeStageProfile();
+    profile.mcus = imgData.totalBlocks;
+    profile.images = 1;
+    auto runStage = [&](DecodeStage stage, auto &&body) {
+        auto start = std::chrono::steady_clock::now();
+        counters.start();
+        auto result = body();
+        profile.counters[static_cast<int>(stage)] = counters.stop();
+        profile.milliseconds[static_cast<int>(stage)] =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    };
+
+    DecodeStatus status = runStage(DecodeStage::Huffman, [&]() { return huffmanDecode(imgData.compressedData, imgData); });
+    if (status != DecodeStatus::Ok) return status;
+    runStage(DecodeStage::Dequantize, [&]() { inverseQuantize(imgData); return 0; });
+    runStage(DecodeStage::ZigZag, [&]() { inverseZigZag(imgData); return 0; });
+    runStage(DecodeStage::IDCT, [&]() { inverseDCT(imgData); return 0; });
+    runStage(DecodeStage::ColorConvert, [&]() {
+        fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+        return 0;
+    });
+    return DecodeStatus::Ok;
+}
+
+// 计数器不可用时打印 n/a
+static void printRatio(std::ostream &out, int width, bool valid, double numerator, double denominator) {
+    if (valid && denominator > 0) {
+        out << std::setw(width) << numerator / denominator;
+    } else {
+        out << std::setw(width) << "n/a";
+    }
+}
+
+void printDecodeStageProfile(std::ostream &out, const DecodeStageProfile &profile) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::left << std::setw(12) << "  stage" << std::right << std::setw(10) << "ms" << std::setw(8) << "IPC"
+        << std::setw(14) << "cycles/MCU" << std::setw(16) << "br-miss/MCU" << std::setw(14) << "L1d-miss/MCU"
+        << std::setw(14) << "LLC-miss/MCU" << std::endl;
+    out << std::fixed;
+
+    PerfSample totalCounters = profile.counters[0];
+    double totalMs = 0;
+    for (int s = 0; s < stageCount; ++s) {
+        if (s > 0) totalCounters += profile.counters[s];
+        totalMs += profile.milliseconds[s];
+    }
+    auto printRow = [&](const char *name, double ms, const PerfSample &sample) {
+        double mcus = static_cast<double>(profile.mcus);
+        out << "  " << std::left << std::setw(10) << name << std::right << std::setprecision(3) << std::setw(10) << ms
+            << std::setprecision(2);
+        printRatio(out, 8, sample.has(PerfEvent::Cycles) && sample.has(PerfEvent::Instructions),
+                   static_cast<double>(sample.value(PerfEvent::Instructions)),
+                   static_cast<double>(sample.value(PerfEvent::Cycles)));
+        printRatio(out, 14, sample.has(PerfEvent::Cycles), static_cast<double>(sample.value(PerfEvent::Cycles)), mcus);
+        printRatio(out, 16, sample.has(PerfEvent::BranchMisses),
+                   static_cast<double>(sample.value(PerfEvent::BranchMisses)), mcus);
+        printRatio(out, 14, sample.has(PerfEvent::L1dMisses), static_cast<double>(sample.value(PerfEvent::L1dMisses)),
+                   mcus);
+        printRatio(out, 14, sample.has(PerfEvent::LlcMisses), static_cast<double>(sample.value(PerfEvent::LlcMisses)),
+                   mcus);
+        out << std::endl;
+    };
+    for (int s = 0; s < stageCount; ++s) {
+        printRow(decodeStageName(static_cast<DecodeStage>(s)), profile.milliseconds[s], profile.counters[s]);
+    }
+    printRow("total", totalMs, totalCounters);
+    out.flags(flags);
+    out.precision(precision);
+}
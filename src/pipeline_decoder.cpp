@@ -0,0 +1,151 @@
+#include "pipeline_decoder.h"
+#include "mcu_row_ring.h"
+#include "decode_trace.h"
+#include "inverse_dct.h"
+#include "inverse_quantize.h"
+#include "inverse_zigzag.h"
+#include "save_as_bmp.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+// 重建线程收到该槽号时退出
+constexpr int END_OF_ROWS = -1;
+
+namespace {
+
+// 一个 MCU 行的系数与像素缓冲。layout 描述只有这一行高的子图像（mcuHeight 为 1），
+// 逐行的逆量化、逆 Zig-Zag、逆 DCT 与 fillBMPRows 都直接作用在它上面
+struct RowSlot {
+    ImageData layout;
+    std::vector<uint8_t> pixels;  // 该行的 BMP 像素（自下而上，行宽同整幅图像）
+    int mcuRow = 0;
+};
+
+// 复制重建所需的头部字段（不复制熵编码数据与系数），并为一个 MCU 行分配系数块
+void initializeRowSlot(const ImageData &imgData, RowSlot &slot) {
+    ImageData &layout = slot.layout;
+    layout.colorComponents = imgData.colorComponents;
+    layout.yQuantTableId = imgData.yQuantTableId;
+    layout.crCbQuantTableId = imgData.crCbQuantTableId;
+    layout.hSamplingFactors = imgData.hSamplingFactors;
+    layout.vSamplingFactors = imgData.vSamplingFactors;
+    layout.quantizationTables = imgData.quantizationTables;
+    layout.lumaOnly = imgData.lumaOnly;
+    layout.initializeBlocks(imgData.width, std::min(imgData.mcuSize(), imgData.height));
+    slot.pixels.resize(static_cast<size_t>(bmpRowSize(layout)) * layout.height);
+}
+
+// 把第 mcuRow 行熵解码到槽中；解码前清零系数（AC 只写入非零系数）
+DecodeStatus decodeRowIntoSlot(HuffmanDecodeState &state, const ImageData &imgData, int mcuRow, RowSlot &slot) {
+    TraceScope trace("entropy row", mcuRow);
+    ImageData &layout = slot.layout;
+    for (auto *component : {&layout.Y, &layout.Cb, &layout.Cr}) {
+        for (auto &block : *component) std::fill(block.begin(), block.end(), 0);
+    }
+    // 最后一行可能不满一个 MCU 高，像素只按实际行数输出
+    layout.initializeMcuLayout(imgData.width, std::min(imgData.mcuSize(), imgData.height - mcuRow * imgData.mcuSize()));
+    slot.mcuRow = mcuRow;
+
+    int first = mcuRow * imgData.mcuWidth;
+    for (int i = 0; i < imgData.mcuWidth; ++i) {
+        Coefficient *blocks[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+        if (imgData.isGrayscale()) {
+            blocks[0] = &layout.Y[i][0];
+        } else {
+            for (int b = 0; b < 4; ++b) blocks[b] = &layout.Y[i * 4 + b][0];
+            if (layout.hasChroma()) {
+                blocks[4] = &layout.Cb[i][0];
+                blocks[5] = &layout.Cr[i][0];
+            }
+        }
+        DecodeStatus status = decodeMcuBlocks(state, imgData, first + i, blocks);
+        if (status != DecodeStatus::Ok) return status;
+    }
+    return DecodeStatus::Ok;
+}
+
+// 对一行 MCU 完成熵解码之后的全部工作，像素复制到整幅图像中对应的位置
+void reconstructSlot(const ImageData &imgData, RowSlot &slot, std::vector<uint8_t> &pixelData) {
+    ImageData &layout = slot.layout;
+    {
+        TraceScope trace("reconstruct row", slot.mcuRow);
+        inverseQuantize(layout, 0, 1);
+        inverseZigZag(layout, 0, 1);
+        inverseDCT(layout, 0, 1);
+    }
+    TraceScope trace("output row", slot.mcuRow);
+    fillBMPRows(layout, 0, 1, slot.pixels);
+    // BMP 自下而上：图像第 y0 行起的 rows 行在整幅缓冲区中连续存放，顺序与槽内相同
+    size_t rowSize = bmpRowSize(layout);
+    int y0 = slot.mcuRow * imgData.mcuSize();
+    std::memcpy(&pixelData[(imgData.height - y0 - layout.height) * rowSize], slot.pixels.data(),
+                rowSize * layout.height);
+}
+
+// 队列满或空时阻塞等待（短暂自旋后睡眠），并记录等待事件
+void pushSlot(McuRowRing &ring, int slot, const char *waitName) {
+    if (ring.tryPush(slot)) return;
+    TraceScope trace(waitName);
+    ring.push(slot);
+}
+
+int popSlot(McuRowRing &ring, const char *waitName) {
+    int slot;
+    if (ring.tryPop(slot)) return slot;
+    TraceScope trace(waitName);
+    return ring.pop();
+}
+
+} // namespace
+
+DecodeStatus decodeJPEGPipelined(ImageData &imgData, const std::vector<uint8_t> &compressedData,
+                                 std::vector<uint8_t> &pixelData, int workerCount, int ringDepth) {
+    pixelData.assign(bmpRowSize(imgData) * imgData.height, 0);
+
+    HuffmanDecodeState state(compressedData);
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    if (status != DecodeStatus::Ok) return status;
+
+    if (workerCount < 1) workerCount = 1;
+    if (ringDepth < 1) ringDepth = 1;
+
+    // 槽数 = 队列中等待的行数 + 每个重建线程正在处理的一行，系数内存与图像高度无关
+    int slotCount = std::min(ringDepth + workerCount, imgData.mcuHeight);
+    std::vector<RowSlot> slots(slotCount);
+    for (auto &slot : slots) initializeRowSlot(imgData, slot);
+
+    // freeSlots：可写入的空槽；readyRows：已完成熵解码、等待重建的槽
+    McuRowRing freeSlots(slotCount);
+    McuRowRing readyRows(slotCount + workerCount);
+    for (int i = 0; i < slotCount; ++i) freeSlots.tryPush(i);
+
+    // 各槽的系数与各 MCU 行的像素区域互不重叠，重建线程之间无需同步
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back([&, i]() {
+            setTraceThreadName("reconstruct " + std::to_string(i));
+            for (;;) {
+                // 队列空：重建线程空闲，等待熵解码
+                int slot = popSlot(readyRows, "wait for row");
+                if (slot == END_OF_ROWS) return;
+                reconstructSlot(imgData, slots[slot], pixelData);
+                pushSlot(freeSlots, slot, "wait for ring");
+            }
+        });
+    }
+
+    // 熵解码无法并行，在调用线程中串行进行；没有空槽时等待重建线程追上
+    for (int mcuRow = 0; mcuRow < imgData.mcuHeight; ++mcuRow) {
+        int slot = popSlot(freeSlots, "wait for ring");
+        status = decodeRowIntoSlot(state, imgData, mcuRow, slots[slot]);
+        if (status != DecodeStatus::Ok) break;
+        pushSlot(readyRows, slot, "wait for ring");
+    }
+
+    for (int i = 0; i < workerCount; ++i) pushSlot(readyRows, END_OF_ROWS, "wait for ring");
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return status;
+}
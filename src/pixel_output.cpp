@@ -0,0 +1,174 @@
+#include "pixel_output.h"
+#include "save_as_bmp.h"
+#include "save_as_qoi.h"
+#include "decode_trace.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+YccTables::YccTables() {
+    for (int i = 0; i < 256; ++i) {
+        red[i] = static_cast<int16_t>(std::floor(1.402 * (i - 128)));
+        blue[i] = static_cast<int16_t>(std::floor(1.772 * (i - 128)));
+        greenCb[i] = static_cast<int32_t>(std::lround(-0.344136 * (i - 128) * (1 << GREEN_SHIFT)));
+        greenCr[i] = static_cast<int32_t>(std::lround(-0.714136 * (i - 128) * (1 << GREEN_SHIFT)));
+    }
+}
+
+const YccTables yccTables;
+
+bool parseOutputFormat(const std::string &name, OutputFormat &format) {
+    for (OutputFormat candidate : {OutputFormat::Bmp, OutputFormat::Yuv420p, OutputFormat::Rgb, OutputFormat::Rgba,
+                                     OutputFormat::Qoi}) {
+        if (name == outputFormatName(candidate)) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *outputFormatName(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::Bmp: return "bmp";
+    case OutputFormat::Yuv420p: return "yuv420p";
+    case OutputFormat::Rgb: return "rgb";
+    case OutputFormat::Rgba: return "rgba";
+    case OutputFormat::Qoi: return "qoi";
+    }
+    return "?";
+}
+
+int yuvPlaneCount(const ImageData &imgData) {
+    return imgData.hasChroma() ? 3 : 1;
+}
+
+void yuvPlaneSize(const ImageData &imgData, int plane, int &width, int &height) {
+    width = plane == 0 ? imgData.width : (imgData.width + 1) / 2;
+    height = plane == 0 ? imgData.height : (imgData.height + 1) / 2;
+}
+
+// 把一个 8x8 块裁剪到平面边界后写入
+static void storeBlock(const std::vector<std::vector<Coefficient>> &block, int strow, int stcol, int width,
+                       int height, uint8_t *plane, int stride) {
+    for (int row = 0; row < 8 && strow + row < height; row++) {
+        uint8_t *dst = plane + static_cast<size_t>(strow + row) * stride + stcol;
+        const std::vector<Coefficient> &src = block[row];
+        for (int col = 0; col < 8 && stcol + col < width; col++) {
+            dst[col] = clampToByte(src[col] + 128);
+        }
+    }
+}
+
+void fillYuvPlanes(const ImageData &imgData, int mcuRowBegin, int mcuRowEnd, uint8_t *const planes[3],
+                   const int strides[3]) {
+    int yBegin, yEnd, crCbBegin, crCbEnd;
+    imgData.mcuRowBlockRange(mcuRowBegin, mcuRowEnd, yBegin, yEnd, crCbBegin, crCbEnd);
+
+    for (int block = yBegin; block < yEnd; block++) {
+        int strow = 0, stcol = 0;
+        imgData.yBlockPosition(block, strow, stcol);
+        storeBlock(imgData.Y_blocks_2D[block], strow, stcol, imgData.width, imgData.height, planes[0], strides[0]);
+    }
+
+    // 4:2:0 的每个 MCU 只有一个 Cb、一个 Cr 块，对应色度平面上的 8x8 区域
+    int chromaWidth = 0, chromaHeight = 0;
+    yuvPlaneSize(imgData, 1, chromaWidth, chromaHeight);
+    for (int mcu = crCbBegin; mcu < crCbEnd; mcu++) {
+        int strow = (mcu / imgData.mcuWidth) * 8;
+        int stcol = (mcu % imgData.mcuWidth) * 8;
+        storeBlock(imgData.Cb_blocks_2D[mcu], strow, stcol, chromaWidth, chromaHeight, planes[1], strides[1]);
+        storeBlock(imgData.Cr_blocks_2D[mcu], strow, stcol, chromaWidth, chromaHeight, planes[2], strides[2]);
+    }
+}
+
+int packedBytesPerPixel(OutputFormat format) {
+    return format == OutputFormat::Rgba ? 4 : 3;
+}
+
+void fillPackedRows(const ImageData &imgData, int mcuRowBegin, int mcuRowEnd, OutputFormat format, uint8_t *pixels,
+                    int stride, int firstRow) {
+    int yBegin, yEnd, crCbBegin, crCbEnd;
+    imgData.mcuRowBlockRange(mcuRowBegin, mcuRowEnd, yBegin, yEnd, crCbBegin, crCbEnd);
+    int bytesPerPixel = packedBytesPerPixel(format);
+    bool alpha = format == OutputFormat::Rgba;
+    bool color = imgData.hasChroma();
+
+    for (int block = yBegin; block < yEnd; block++) {
+        int strow = 0, stcol = 0;
+        imgData.yBlockPosition(block, strow, stcol);
+
+        // 该 Y 块在 MCU 中对应的色度块区域（右半、下半各偏移 4），同 fillBMPRows
+        int crRowOffset = (block % 4 / 2) * 4;
+        int crColOffset = (block % 2) * 4;
+
+        // 行指针先取出来：经 uint8_t* 写像素会让编译器每次重新读取各层 vector 的数据指针
+        int cols = std::min(8, imgData.width - stcol);
+        for (int row = 0; row < 8 && strow + row < imgData.height; row++) {
+            uint8_t *dst = pixels + static_cast<size_t>(strow + row - firstRow) * stride + static_cast<size_t>(stcol) * bytesPerPixel;
+            const Coefficient *luma = imgData.Y_blocks_2D[block][row].data();
+            if (!color) {
+                for (int col = 0; col < cols; col++, dst += bytesPerPixel) {
+                    dst[0] = dst[1] = dst[2] = clampToByte(luma[col] + 128);
+                    if (alpha) dst[3] = 255;
+                }
+                continue;
+            }
+            const Coefficient *cb = imgData.Cb_blocks_2D[block / 4][crRowOffset + row / 2].data() + crColOffset;
+            const Coefficient *cr = imgData.Cr_blocks_2D[block / 4][crRowOffset + row / 2].data() + crColOffset;
+            for (int col = 0; col < cols; col++, dst += bytesPerPixel) {
+                ycbcrToRgb(luma[col], cb[col / 2], cr[col / 2], dst[0], dst[1], dst[2]);
+                if (alpha) dst[3] = 255;
+            }
+        }
+    }
+}
+
+static bool writeFile(const std::string &filename, const std::vector<uint8_t> &data) {
+    TraceScope trace("write raw");
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "无法创建输出文件: " << filename << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+bool saveDecodedImage(const std::string &filename, const ImageData &imgData, OutputFormat format, int stride) {
+    if (format == OutputFormat::Bmp) {
+        return imgData.hasChroma() ? saveAsBMP(filename, imgData) : saveAsGrayBMP(filename, imgData);
+    }
+    if (format == OutputFormat::Qoi) return saveAsQOI(filename, imgData);
+
+    std::vector<uint8_t> data;
+    if (format == OutputFormat::Yuv420p) {
+        uint8_t *planes[3] = {nullptr, nullptr, nullptr};
+        int strides[3] = {0, 0, 0};
+        size_t offsets[3] = {0, 0, 0};
+        size_t size = 0;
+        for (int c = 0; c < yuvPlaneCount(imgData); ++c) {
+            int height = 0;
+            yuvPlaneSize(imgData, c, strides[c], height);
+            offsets[c] = size;
+            size += static_cast<size_t>(strides[c]) * height;
+        }
+        data.assign(size, 0);
+        for (int c = 0; c < yuvPlaneCount(imgData); ++c) planes[c] = data.data() + offsets[c];
+        TraceScope trace("planar copy");
+        fillYuvPlanes(imgData, 0, imgData.mcuHeight, planes, strides);
+    } else {
+        int rowBytes = imgData.width * packedBytesPerPixel(format);
+        if (stride != 0 && stride < rowBytes) {
+            std::cerr << "行跨度 " << stride << " 小于每行像素字节数 " << rowBytes << std::endl;
+            return false;
+        }
+        if (stride == 0) stride = rowBytes;
+        data.assign(static_cast<size_t>(stride) * imgData.height, 0);
+        TraceScope trace("color convert");
+        fillPackedRows(imgData, 0, imgData.mcuHeight, format, data.data(), stride);
+    }
+    return writeFile(filename, data);
+}
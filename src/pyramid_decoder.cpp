@@ -0,0 +1,294 @@
+#include "pyramid_decoder.h"
+#include "inverse_dct.h"
+#include "inverse_quantize.h"
+#include "inverse_zigzag.h"
+#include "save_as_bmp.h"
+#include "save_as_qoi.h"
+#include "decode_trace.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+namespace {
+
+// N x 8 的缩小逆 DCT 矩阵（N = 8 / scale）：v[r][k] 为 8 点正交 DCT 第 k 个基函数（定义同 inverse_dct.cpp）
+// 在第 r 组 scale 个相邻样本上的平均值。同 IJG jidctred.c，对完整的 8x8 系数两个方向各乘一次，
+// 结果正好是完整逆 DCT 输出的 scale x scale 块平均，不会因截断高频系数而产生振铃
+struct ReducedMat {
+    double v[8][8];
+};
+
+ReducedMat makeReducedMat(int scale) {
+    ReducedMat mat{};
+    for (int r = 0; r < 8 / scale; r++) {
+        for (int k = 0; k < 8; k++) {
+            double a = std::sqrt((k == 0 ? 1.0 : 2.0) / 8);
+            double sum = 0.0;
+            for (int j = r * scale; j < (r + 1) * scale; j++) sum += a * std::cos((j + 0.5) * M_PI * k / 8);
+            mat.v[r][k] = sum / scale;
+        }
+    }
+    return mat;
+}
+
+const ReducedMat reducedMat1 = makeReducedMat(1);
+const ReducedMat reducedMat2 = makeReducedMat(2);
+const ReducedMat reducedMat4 = makeReducedMat(4);
+
+// 一个缩小级在当前 MCU 行上的样本平面（电平偏移后，未裁剪）与输出像素。
+// 4:2:0 的色度块按 scale / 2 缩小，色度平面与亮度平面分辨率相同，转换时不需要上采样
+struct ScaledBand {
+    int scale = 1;
+    int chromaScale = 1;
+    int width = 0;       // 该级图像尺寸
+    int height = 0;
+    int rows = 0;        // 每个 MCU 行对应的行数
+    int lumaStride = 0;
+    int chromaStride = 0;
+    std::vector<Coefficient> luma, cb, cr;
+    std::vector<uint8_t> pixels;
+    int pixelStride = 0;
+};
+
+// 把当前 MCU 行的 Y 块与色度块缩小重建到 band 的样本平面
+void reconstructScaledRow(const ImageData &imgData, int mcuRow, ScaledBand &band) {
+    int yBegin, yEnd, crCbBegin, crCbEnd;
+    imgData.mcuRowBlockRange(mcuRow, mcuRow + 1, yBegin, yEnd, crCbBegin, crCbEnd);
+    int mcuSize = imgData.mcuSize();
+    int n = 8 / band.chromaScale;
+    for (int block = yBegin; block < yEnd; block++) {
+        int strow = 0, stcol = 0;
+        imgData.yBlockPosition(block, strow, stcol);
+        Coefficient *out = &band.luma[static_cast<size_t>(strow % mcuSize / band.scale) * band.lumaStride +
+                                      stcol / band.scale];
+        reducedInverseDCT(imgData.Y_blocks_2D[block], band.scale, out, band.lumaStride);
+    }
+    for (int mcu = crCbBegin; mcu < crCbEnd; mcu++) {
+        int col = (mcu % imgData.mcuWidth) * n;
+        reducedInverseDCT(imgData.Cb_blocks_2D[mcu], band.chromaScale, &band.cb[col], band.chromaStride);
+        reducedInverseDCT(imgData.Cr_blocks_2D[mcu], band.chromaScale, &band.cr[col], band.chromaStride);
+    }
+}
+
+// 样本平面转换为打包像素
+void convertScaledRows(const ImageData &imgData, ScaledBand &band, int rowCount, int bytesPerPixel) {
+    bool color = imgData.hasChroma();
+    bool alpha = bytesPerPixel == 4;
+    for (int y = 0; y < rowCount; y++) {
+        const Coefficient *luma = &band.luma[static_cast<size_t>(y) * band.lumaStride];
+        uint8_t *dst = &band.pixels[static_cast<size_t>(y) * band.pixelStride];
+        if (!color) {
+            for (int x = 0; x < band.width; x++, dst += bytesPerPixel) {
+                dst[0] = dst[1] = dst[2] = clampToByte(luma[x] + 128);
+                if (alpha) dst[3] = 255;
+            }
+            continue;
+        }
+        const Coefficient *cb = &band.cb[static_cast<size_t>(y) * band.chromaStride];
+        const Coefficient *cr = &band.cr[static_cast<size_t>(y) * band.chromaStride];
+        for (int x = 0; x < band.width; x++, dst += bytesPerPixel) {
+            ycbcrToRgb(luma[x], cb[x], cr[x], dst[0], dst[1], dst[2]);
+            if (alpha) dst[3] = 255;
+        }
+    }
+}
+
+// 一个级别的输出文件，按行段追加（BMP 定位到自下而上的位置写入）
+class LevelFile {
+public:
+    LevelFile(const std::string &filename, int width, int height, bool gray, OutputFormat format)
+        : file(filename, std::ios::binary), format(format), width(width), height(height), gray(gray) {
+        if (!file) {
+            std::cerr << "无法创建输出文件: " << filename << std::endl;
+            return;
+        }
+        if (format == OutputFormat::Bmp) {
+            layout.width = width;
+            layout.height = height;
+            layout.colorComponents = gray ? 1 : 3;
+            std::vector<uint8_t> header;
+            bmpHeaderBytes(layout, header);
+            headerSize = header.size();
+            file.write(reinterpret_cast<const char *>(header.data()), header.size());
+        } else if (format == OutputFormat::Qoi) {
+            qoi = std::make_unique<QoiEncoder>(width, height, 3, encoded);
+        }
+    }
+
+    void write(const uint8_t *pixels, int firstRow, int rowCount, int stride) {
+        if (!file) return;
+        if (format == OutputFormat::Bmp) {
+            // 第 firstRow .. firstRow + rowCount - 1 行在文件中连续存放，顺序相反
+            int rowSize = bmpRowSize(layout);
+            encoded.assign(static_cast<size_t>(rowSize) * rowCount, 0);
+            for (int y = 0; y < rowCount; y++) {
+                const uint8_t *src = pixels + static_cast<size_t>(y) * stride;
+                uint8_t *dst = &encoded[static_cast<size_t>(rowCount - 1 - y) * rowSize];
+                for (int x = 0; x < width; x++, src += 3) {
+                    if (gray) {
+                        dst[x] = src[0];
+                    } else {
+                        dst[x * 3] = src[2];
+                        dst[x * 3 + 1] = src[1];
+                        dst[x * 3 + 2] = src[0];
+                    }
+                }
+            }
+            file.seekp(headerSize + static_cast<std::streamoff>(height - firstRow - rowCount) * rowSize);
+        } else if (format == OutputFormat::Qoi) {
+            encoded.clear();
+            qoi->encodeRows(pixels, rowCount, stride);
+        } else {
+            file.write(reinterpret_cast<const char *>(pixels), static_cast<std::streamsize>(stride) * rowCount);
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(encoded.data()), encoded.size());
+    }
+
+    bool finish() {
+        if (qoi && file) {
+            encoded.clear();
+            qoi->finish();
+            file.write(reinterpret_cast<const char *>(encoded.data()), encoded.size());
+        }
+        file.close();
+        return static_cast<bool>(file);
+    }
+
+private:
+    std::ofstream file;
+    OutputFormat format;
+    int width;
+    int height;
+    bool gray;
+    ImageData layout;
+    std::streamoff headerSize = 0;
+    std::vector<uint8_t> encoded;
+    std::unique_ptr<QoiEncoder> qoi;
+};
+
+} // namespace
+
+int pyramidLevelSize(int size, int scale) {
+    return (size + scale - 1) / scale;
+}
+
+bool parsePyramidScales(const std::string &text, std::vector<int> &scales) {
+    scales.clear();
+    std::istringstream fields(text);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        if (field != "1" && field != "2" && field != "4" && field != "8") return false;
+        int scale = std::stoi(field);
+        if (std::find(scales.begin(), scales.end(), scale) != scales.end()) return false;
+        scales.push_back(scale);
+    }
+    return !scales.empty();
+}
+
+void reducedInverseDCT(const std::vector<std::vector<Coefficient>> &block, int scale, Coefficient *out, int stride) {
+    int n = 8 / scale;
+    if (n == 1) {
+        // 块均值只与直流系数有关：直流系数 / 8
+        out[0] = saturateCoefficient(static_cast<int>(std::round(block[0][0] / 8.0)));
+        return;
+    }
+    const ReducedMat &mat = scale == 1 ? reducedMat1 : scale == 2 ? reducedMat2 : reducedMat4;
+    // 先在垂直方向把 8 行系数变换为 N 行，再在水平方向变换为 N 列
+    double temp[8][8];
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 8; j++) {
+            double sum = 0.0;
+            for (int k = 0; k < 8; k++) sum += mat.v[i][k] * block[k][j];
+            temp[i][j] = sum;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            double sum = 0.0;
+            for (int k = 0; k < 8; k++) sum += temp[i][k] * mat.v[j][k];
+            out[i * stride + j] = saturateCoefficient(static_cast<int>(std::round(sum)));
+        }
+    }
+}
+
+DecodeStatus decodePyramid(ImageData &imgData, const std::vector<int> &scales, OutputFormat packedFormat,
+                           const PyramidRowSink &sink) {
+    DecodeStatus status = huffmanDecode(imgData.compressedData, imgData);
+    if (status != DecodeStatus::Ok) return status;
+
+    int mcuSize = imgData.mcuSize();
+    int bytesPerPixel = packedBytesPerPixel(packedFormat);
+    std::vector<ScaledBand> bands(scales.size());
+    for (size_t level = 0; level < scales.size(); ++level) {
+        ScaledBand &band = bands[level];
+        band.scale = scales[level];
+        band.width = pyramidLevelSize(imgData.width, band.scale);
+        band.height = pyramidLevelSize(imgData.height, band.scale);
+        band.chromaScale = std::max(band.scale / 2, 1);
+        band.rows = mcuSize / band.scale;
+        band.lumaStride = imgData.mcuWidth * band.rows;
+        band.chromaStride = imgData.mcuWidth * (8 / band.chromaScale);
+        band.pixelStride = band.width * bytesPerPixel;
+        band.pixels.resize(static_cast<size_t>(band.pixelStride) * band.rows);
+        if (band.scale > 1) {
+            band.luma.resize(static_cast<size_t>(band.lumaStride) * band.rows);
+            if (imgData.hasChroma()) {
+                band.cb.resize(static_cast<size_t>(band.chromaStride) * (8 / band.chromaScale));
+                band.cr.resize(band.cb.size());
+            }
+        }
+    }
+    bool fullSize = std::find(scales.begin(), scales.end(), 1) != scales.end();
+
+    for (int mcuRow = 0; mcuRow < imgData.mcuHeight; ++mcuRow) {
+        TraceScope trace("pyramid row");
+        inverseQuantize(imgData, mcuRow, mcuRow + 1);
+        inverseZigZag(imgData, mcuRow, mcuRow + 1);
+        // 缩小级先用系数重建，完整逆 DCT 会原地覆盖系数
+        for (ScaledBand &band : bands) {
+            if (band.scale > 1) reconstructScaledRow(imgData, mcuRow, band);
+        }
+        if (fullSize) inverseDCT(imgData, mcuRow, mcuRow + 1);
+
+        for (size_t level = 0; level < bands.size(); ++level) {
+            ScaledBand &band = bands[level];
+            int firstRow = mcuRow * band.rows;
+            int rowCount = std::min(band.rows, band.height - firstRow);
+            if (band.scale == 1) {
+                fillPackedRows(imgData, mcuRow, mcuRow + 1, packedFormat, band.pixels.data(), band.pixelStride,
+                               firstRow);
+            } else {
+                convertScaledRows(imgData, band, rowCount, bytesPerPixel);
+            }
+            sink(static_cast<int>(level), band.pixels.data(), firstRow, rowCount, band.pixelStride);
+        }
+    }
+    return DecodeStatus::Ok;
+}
+
+bool savePyramid(ImageData &imgData, const std::vector<int> &scales, const std::vector<std::string> &filenames,
+                 OutputFormat format, DecodeStatus &status) {
+    if (format == OutputFormat::Yuv420p || filenames.size() != scales.size()) {
+        std::cerr << "多级输出只支持 bmp、rgb、rgba、qoi 格式" << std::endl;
+        status = DecodeStatus::Ok;
+        return false;
+    }
+    bool gray = !imgData.hasChroma();
+    std::vector<std::unique_ptr<LevelFile>> files;
+    for (size_t level = 0; level < scales.size(); ++level) {
+        files.push_back(std::make_unique<LevelFile>(filenames[level], pyramidLevelSize(imgData.width, scales[level]),
+                                                    pyramidLevelSize(imgData.height, scales[level]), gray, format));
+    }
+    OutputFormat packedFormat = format == OutputFormat::Rgba ? OutputFormat::Rgba : OutputFormat::Rgb;
+    status = decodePyramid(imgData, scales, packedFormat,
+                           [&](int level, const uint8_t *pixels, int firstRow, int rowCount, int stride) {
+                               files[level]->write(pixels, firstRow, rowCount, stride);
+                           });
+    bool written = true;
+    for (auto &file : files) written = file->finish() && written;
+    return status == DecodeStatus::Ok && written;
+}
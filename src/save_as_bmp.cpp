@@ -1,4 +1,6 @@
 #include "save_as_bmp.h"
+#include "pixel_output.h"
+#include "decode_trace.h"
 #include <fstream>
 #include <vector>
 #include <iostream>
@@ -10,28 +12,99 @@ T clamp(T value, T min, T max) {
     return value;
 }
 
-bool saveAsBMP(const std::string &filename, const ImageData &imgData) {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file) {
-        std::cerr << "无法创建 BMP 文件: " << filename << std::endl;
-        return false;
+// 输出 8 位灰度 BMP（灰度图像或仅亮度模式）还是 24 位彩色 BMP
+static bool isGrayOutput(const ImageData &imgData) {
+    return imgData.isGrayscale() || imgData.lumaOnly;
+}
+
+int bmpRowSize(const ImageData &imgData) {
+    int bytesPerPixel = isGrayOutput(imgData) ? 1 : 3;
+    return ((imgData.width * bytesPerPixel + 3) / 4) * 4; // 每行按 4 字节对齐
+}
+
+// 将 Y 块映射为 8 位灰度像素
+static void fillGrayRows(const ImageData &imgData, int yBegin, int yEnd, std::vector<uint8_t> &pixelData) {
+    int width = imgData.width;
+    int height = imgData.height;
+    int rowSize = bmpRowSize(imgData);
+
+    // 遍历每个 Y 块，裁掉超出图像边界的填充像素
+    for (int block = yBegin; block < yEnd; block++) {
+        int strow = 0, stcol = 0;
+        imgData.yBlockPosition(block, strow, stcol);
+
+        for (int row = 0; row < 8 && strow + row < height; row++) {
+            uint8_t *dst = &pixelData[(height - 1 - strow - row) * rowSize]; // 从下往上存储
+            for (int col = 0; col < 8 && stcol + col < width; col++) {
+                dst[stcol + col] = static_cast<uint8_t>(clamp(imgData.Y_blocks_2D[block][row][col] + 128, 0, 255));
+            }
+        }
+    }
+}
+
+// 将 4:2:0 的 Y、Cr、Cb 块转换为 24 位像素
+static void fillColorRows(const ImageData &imgData, int yBegin, int yEnd, std::vector<uint8_t> &pixelData) {
+    int width = imgData.width;
+    int height = imgData.height;
+    int rowSize = bmpRowSize(imgData);
+
+    // 遍历每个 Y 块，将其值填充到像素数据缓冲区中
+    for (int block = yBegin; block < yEnd; block++) {
+        int strow = 0, stcol = 0;
+        imgData.yBlockPosition(block, strow, stcol);
+
+        // 该 Y 块在 MCU 中对应的色度块区域（右半、下半各偏移 4）
+        int crRowOffset = (block % 4 / 2) * 4;
+        int crColOffset = (block % 2) * 4;
+
+        for (int row = 0; row < 8 && strow + row < height; row++) {
+            for (int col = 0; col < 8 && stcol + col < width; col++) {
+                int Crrow = crRowOffset + row / 2;
+                int Crcol = crColOffset + col / 2;
+
+                int tmprow = strow + row;
+                int tmpcol = stcol + col;
+                int pixelIndex = (height - 1 - tmprow) * rowSize + tmpcol * 3; // 从下往上存储
+
+                // BMP 像素按 B、G、R 顺序存储
+                ycbcrToRgb(imgData.Y_blocks_2D[block][row][col], imgData.Cb_blocks_2D[block / 4][Crrow][Crcol],
+                           imgData.Cr_blocks_2D[block / 4][Crrow][Crcol], pixelData[pixelIndex + 2],
+                           pixelData[pixelIndex + 1], pixelData[pixelIndex]);
+            }
+        }
+    }
+}
+
+void fillBMPRows(const ImageData &imgData, int mcuRowBegin, int mcuRowEnd, std::vector<uint8_t> &pixelData) {
+    int yBegin, yEnd, crCbBegin, crCbEnd;
+    imgData.mcuRowBlockRange(mcuRowBegin, mcuRowEnd, yBegin, yEnd, crCbBegin, crCbEnd);
+
+    if (isGrayOutput(imgData)) {
+        fillGrayRows(imgData, yBegin, yEnd, pixelData);
+    } else {
+        fillColorRows(imgData, yBegin, yEnd, pixelData);
     }
+}
 
+void bmpHeaderBytes(const ImageData &imgData, std::vector<uint8_t> &header) {
+    bool gray = isGrayOutput(imgData);
     int width = imgData.width;
     int height = imgData.height;
-    int mcuPerRow = width / 16; // 每行的 MCU 数量
-    int rowSize = ((width * 3 + 3) / 4) * 4; // 每行按 4 字节对齐
-    int dataSize = rowSize * height;
-    int fileSize = 54 + dataSize;
+    int dataSize = bmpRowSize(imgData) * height;
+    int paletteSize = gray ? 256 * 4 : 0;  // 8 位图像带 256 级灰度调色板，每项 BGRA 4 字节
+    int dataOffset = 54 + paletteSize;
+    int fileSize = dataOffset + dataSize;
+    uint8_t bitsPerPixel = gray ? 8 : 24;
+    uint8_t paletteColors = gray ? 1 : 0;   // 调色板颜色数的第二个字节：256 = 0x100
 
     // BMP 文件头
     uint8_t fileHeader[14] = {
         'B', 'M',                          // 文件类型
         static_cast<uint8_t>(fileSize), static_cast<uint8_t>(fileSize >> 8), static_cast<uint8_t>(fileSize >> 16), static_cast<uint8_t>(fileSize >> 24), // 文件大小
         0, 0, 0, 0,                        // 保留字段
-        54, 0, 0, 0                        // 像素数据偏移量
+        static_cast<uint8_t>(dataOffset), static_cast<uint8_t>(dataOffset >> 8), 0, 0 // 像素数据偏移量
     };
-    file.write(reinterpret_cast<char*>(fileHeader), sizeof(fileHeader));
+    header.assign(fileHeader, fileHeader + sizeof(fileHeader));
 
     // BMP 信息头
     uint8_t infoHeader[40] = {
@@ -39,77 +112,60 @@ bool saveAsBMP(const std::string &filename, const ImageData &imgData) {
         static_cast<uint8_t>(width), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width >> 16), static_cast<uint8_t>(width >> 24), // 宽度
         static_cast<uint8_t>(height), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 24), // 高度
         1, 0,                              // 色平面数
-        24, 0,                             // 位深 (24 位)
+        bitsPerPixel, 0,                   // 位深 (24 位彩色或 8 位索引色)
         0, 0, 0, 0,                        // 无压缩
         static_cast<uint8_t>(dataSize), static_cast<uint8_t>(dataSize >> 8), static_cast<uint8_t>(dataSize >> 16), static_cast<uint8_t>(dataSize >> 24), // 图像数据大小
         0, 0, 0, 0,                        // 水平分辨率
         0, 0, 0, 0,                        // 垂直分辨率
-        0, 0, 0, 0                         // 色彩数
+        0, paletteColors, 0, 0,            // 调色板颜色数
+        0, 0, 0, 0                         // 重要颜色数
     };
-    file.write(reinterpret_cast<char*>(infoHeader), sizeof(infoHeader));
-
-    // 创建缓冲区来存储像素数据
-    std::vector<uint8_t> pixelData(dataSize, 0);
+    header.insert(header.end(), infoHeader, infoHeader + sizeof(infoHeader));
 
-    // 遍历每个 Y 块，将其值填充到像素数据缓冲区中
-    for (int block = 0; block < imgData.totalYBlocks; block++) {
-        int strow = 0, stcol = 0;
-        if (block % 4 == 0) {
-            strow = (block / 4 / mcuPerRow) * 16;
-            stcol = (block / 4 % mcuPerRow) * 16;
-        } else if (block % 4 == 1) {
-            strow = (block / 4 / mcuPerRow) * 16;
-            stcol = (block / 4 % mcuPerRow) * 16 + 8;
-        } else if (block % 4 == 2) {
-            strow = (block / 4 / mcuPerRow) * 16 + 8;
-            stcol = (block / 4 % mcuPerRow) * 16;
-        } else if (block % 4 == 3) {
-            strow = (block / 4 / mcuPerRow) * 16 + 8;
-            stcol = (block / 4 % mcuPerRow) * 16 + 8;
+    if (gray) {
+        // 灰度调色板：索引 i 对应 (i, i, i)
+        for (int i = 0; i < 256; i++) {
+            uint8_t entry[4] = {static_cast<uint8_t>(i), static_cast<uint8_t>(i), static_cast<uint8_t>(i), 0};
+            header.insert(header.end(), entry, entry + 4);
         }
+    }
+}
 
-        for (int row = 0; row < 8; row++) {
-            for (int col = 0; col < 8; col++) {
-                int Crrow = 0, Crcol = 0;
-                if (block % 4 == 0) {
-                    Crrow = row / 2;
-                    Crcol = col / 2;
-                } else if (block % 4 == 1) {
-                    Crrow = row / 2;
-                    Crcol = 4 + col / 2;
-                } else if (block % 4 == 2) {
-                    Crrow = 4 + row / 2;
-                    Crcol = col / 2;
-                } else if (block % 4 == 3) {
-                    Crrow = 4 + row / 2;
-                    Crcol = 4 + col / 2;
-                }
-
-                int Y = imgData.Y_blocks_2D[block][row][col];
-                int Cr = imgData.Cr_blocks_2D[block / 4][Crrow][Crcol];
-                int Cb = imgData.Cb_blocks_2D[block / 4][Crrow][Crcol];
-
-                Y = clamp(Y + 128, 0, 255);
-                Cr = clamp(Cr + 128, 0, 255);
-                Cb = clamp(Cb + 128, 0, 255);
-
-                int R = clamp(int(Y + 1.402 * (Cr - 128)), 0, 255);
-                int G = clamp(int(Y - 0.344136 * (Cb - 128) - 0.714136 * (Cr - 128)), 0, 255);
-                int B = clamp(int(Y + 1.772 * (Cb - 128)), 0, 255);
-
-                int tmprow = strow + row;
-                int tmpcol = stcol + col;
-                int pixelIndex = (height - 1 - tmprow) * rowSize + tmpcol * 3; // 从下往上存储
-
-                pixelData[pixelIndex] = static_cast<uint8_t>(R);
-                pixelData[pixelIndex + 1] = static_cast<uint8_t>(G);
-                pixelData[pixelIndex + 2] = static_cast<uint8_t>(B);
-            }
-        }
+bool writeBMP(const std::string &filename, const ImageData &imgData, const std::vector<uint8_t> &pixelData) {
+    TraceScope trace("write bmp");
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "无法创建 BMP 文件: " << filename << std::endl;
+        return false;
     }
 
+    std::vector<uint8_t> header;
+    bmpHeaderBytes(imgData, header);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
     // 写入像素数据
-    file.write(reinterpret_cast<char*>(pixelData.data()), dataSize);
+    file.write(reinterpret_cast<const char*>(pixelData.data()), bmpRowSize(imgData) * imgData.height);
     file.close();
     return true;
 }
+
+bool saveAsBMP(const std::string &filename, const ImageData &imgData) {
+    // 创建缓冲区来存储像素数据
+    std::vector<uint8_t> pixelData(bmpRowSize(imgData) * imgData.height, 0);
+    {
+        TraceScope trace("color convert");
+        fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+    }
+    return writeBMP(filename, imgData, pixelData);
+}
+
+// 将 Y 分量保存为 8 位调色板 BMP，像素数据只有 24 位 BMP 的三分之一
+// 适用于单分量（灰度）图像以及仅亮度模式解码的彩色图像
+bool saveAsGrayBMP(const std::string &filename, const ImageData &imgData) {
+    std::vector<uint8_t> pixelData(bmpRowSize(imgData) * imgData.height, 0);
+    {
+        TraceScope trace("color convert");
+        fillBMPRows(imgData, 0, imgData.mcuHeight, pixelData);
+    }
+    return writeBMP(filename, imgData, pixelData);
+}
@@ -80,7 +80,7 @@ void mapBlocksToGrayImage(const ImageData &imgData, cv::Mat &colorImage) {
                 int tmprow = strow + row;
                 int tmpcol = stcol + col;
                 // 将 Y 值填充到灰度图像中
-                colorImage.at<cv::Vec3b>(tmprow, tmpcol) = cv::Vec3b(R, G, B);
+                colorImage.at<cv::Vec3b>(tmprow, tmpcol) = cv::Vec3b(B, G, R); // OpenCV 按 BGR 存储
             }
         }
     }
@@ -0,0 +1,204 @@
+#include "save_as_qoi.h"
+#include "pixel_output.h"
+#include "decode_trace.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace {
+constexpr uint8_t QOI_OP_INDEX = 0x00;
+constexpr uint8_t QOI_OP_DIFF = 0x40;
+constexpr uint8_t QOI_OP_LUMA = 0x80;
+constexpr uint8_t QOI_OP_RUN = 0xC0;
+constexpr uint8_t QOI_OP_RGB = 0xFE;
+constexpr uint8_t QOI_OP_RGBA = 0xFF;
+constexpr uint8_t QOI_MASK = 0xC0;
+constexpr uint8_t QOI_END[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+inline int channel(uint32_t pixel, int c) {
+    return static_cast<int>((pixel >> (c * 8)) & 0xFF);
+}
+
+inline int colorHash(uint32_t pixel) {
+    return (channel(pixel, 0) * 3 + channel(pixel, 1) * 5 + channel(pixel, 2) * 7 + channel(pixel, 3) * 11) % 64;
+}
+
+void putBigEndian32(std::vector<uint8_t> &out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+uint32_t getBigEndian32(const uint8_t *p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+} // namespace
+
+QoiEncoder::QoiEncoder(int width, int height, int channels, std::vector<uint8_t> &out)
+    : out(out), width(width), height(height), channels(channels) {
+    static const uint8_t magic[4] = {'q', 'o', 'i', 'f'};
+    out.insert(out.end(), magic, magic + 4);
+    putBigEndian32(out, static_cast<uint32_t>(width));
+    putBigEndian32(out, static_cast<uint32_t>(height));
+    out.push_back(static_cast<uint8_t>(channels));
+    out.push_back(0);  // sRGB，alpha 未预乘
+}
+
+void QoiEncoder::encodeRows(const uint8_t *pixels, int rowCount, int stride) {
+    rowCount = std::min(rowCount, height - rows);
+    if (rowCount <= 0) return;
+
+    // 先按最坏情况（每像素一个操作码加全部通道）扩容，再用指针写入，最后截到实际长度。
+    // 编码状态放在局部变量里：经 uint8_t* 写出会让编译器每次重新读取成员
+    size_t start = out.size();
+    out.resize(start + static_cast<size_t>(rowCount) * width * (channels + 1));
+    uint8_t *dst = out.data() + start;
+    uint32_t prev = previous;
+    int pending = run;
+    uint32_t table[64];
+    std::copy(index, index + 64, table);
+
+    for (int y = 0; y < rowCount; ++y) {
+        const uint8_t *src = pixels + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < width; ++x, src += channels) {
+            uint8_t r = src[0], g = src[1], b = src[2], a = channels == 4 ? src[3] : 255;
+            uint32_t pixel = r | uint32_t(g) << 8 | uint32_t(b) << 16 | uint32_t(a) << 24;
+            if (pixel == prev) {
+                if (++pending == 62) {
+                    *dst++ = QOI_OP_RUN | (pending - 1);
+                    pending = 0;
+                }
+                continue;
+            }
+            if (pending > 0) {
+                *dst++ = QOI_OP_RUN | (pending - 1);
+                pending = 0;
+            }
+
+            int hash = (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+            if (table[hash] == pixel) {
+                *dst++ = QOI_OP_INDEX | hash;
+            } else {
+                table[hash] = pixel;
+                if ((pixel >> 24) == (prev >> 24)) {
+                    // 差值按 8 位回绕计算
+                    int dr = static_cast<int8_t>(r - channel(prev, 0));
+                    int dg = static_cast<int8_t>(g - channel(prev, 1));
+                    int db = static_cast<int8_t>(b - channel(prev, 2));
+                    int drg = dr - dg;
+                    int dbg = db - dg;
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        *dst++ = static_cast<uint8_t>(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    } else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 && dbg >= -8 && dbg <= 7) {
+                        *dst++ = static_cast<uint8_t>(QOI_OP_LUMA | (dg + 32));
+                        *dst++ = static_cast<uint8_t>((drg + 8) << 4 | (dbg + 8));
+                    } else {
+                        *dst++ = QOI_OP_RGB;
+                        *dst++ = r;
+                        *dst++ = g;
+                        *dst++ = b;
+                    }
+                } else {
+                    *dst++ = QOI_OP_RGBA;
+                    *dst++ = r;
+                    *dst++ = g;
+                    *dst++ = b;
+                    *dst++ = a;
+                }
+            }
+            prev = pixel;
+        }
+    }
+    previous = prev;
+    run = pending;
+    std::copy(table, table + 64, index);
+    out.resize(dst - out.data());
+    rows += rowCount;
+}
+
+void QoiEncoder::finish() {
+    if (run > 0) {
+        out.push_back(QOI_OP_RUN | (run - 1));
+        run = 0;
+    }
+    out.insert(out.end(), QOI_END, QOI_END + sizeof(QOI_END));
+}
+
+bool decodeQOI(const std::vector<uint8_t> &data, RawImage &image) {
+    if (data.size() < 14 + sizeof(QOI_END) || data[0] != 'q' || data[1] != 'o' || data[2] != 'i' || data[3] != 'f') {
+        return false;
+    }
+    image.width = static_cast<int>(getBigEndian32(&data[4]));
+    image.height = static_cast<int>(getBigEndian32(&data[8]));
+    image.channels = data[12];
+    if (image.width <= 0 || image.height <= 0 || (image.channels != 3 && image.channels != 4)) return false;
+    size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    image.pixels.assign(pixelCount * image.channels, 0);
+
+    uint32_t index[64] = {};
+    uint32_t pixel = 0xFF000000u;
+    size_t pos = 14, end = data.size() - sizeof(QOI_END);
+    int run = 0;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        if (run > 0) {
+            --run;
+        } else {
+            if (pos >= end) return false;
+            uint8_t op = data[pos++];
+            if (op == QOI_OP_RGB || op == QOI_OP_RGBA) {
+                int count = op == QOI_OP_RGB ? 3 : 4;
+                if (pos + count > end) return false;
+                for (int c = 0; c < count; ++c) {
+                    pixel = (pixel & ~(0xFFu << (c * 8))) | uint32_t(data[pos++]) << (c * 8);
+                }
+            } else if ((op & QOI_MASK) == QOI_OP_INDEX) {
+                pixel = index[op];
+            } else if ((op & QOI_MASK) == QOI_OP_DIFF) {
+                int delta[3] = {((op >> 4) & 3) - 2, ((op >> 2) & 3) - 2, (op & 3) - 2};
+                for (int c = 0; c < 3; ++c) {
+                    uint32_t value = (channel(pixel, c) + delta[c]) & 0xFF;
+                    pixel = (pixel & ~(0xFFu << (c * 8))) | value << (c * 8);
+                }
+            } else if ((op & QOI_MASK) == QOI_OP_LUMA) {
+                if (pos >= end) return false;
+                int dg = (op & 0x3F) - 32;
+                int delta[3] = {dg + ((data[pos] >> 4) & 0x0F) - 8, dg, dg + (data[pos] & 0x0F) - 8};
+                ++pos;
+                for (int c = 0; c < 3; ++c) {
+                    uint32_t value = (channel(pixel, c) + delta[c]) & 0xFF;
+                    pixel = (pixel & ~(0xFFu << (c * 8))) | value << (c * 8);
+                }
+            } else {
+                run = op & 0x3F;
+            }
+            index[colorHash(pixel)] = pixel;
+        }
+        for (int c = 0; c < image.channels; ++c) {
+            image.pixels[i * image.channels + c] = static_cast<uint8_t>(channel(pixel, c));
+        }
+    }
+    return true;
+}
+
+bool saveAsQOI(const std::string &filename, const ImageData &imgData) {
+    TraceScope trace("write qoi");
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "无法创建 QOI 文件: " << filename << std::endl;
+        return false;
+    }
+
+    int bandRows = imgData.mcuSize();
+    int stride = imgData.width * 3;
+    std::vector<uint8_t> band(static_cast<size_t>(bandRows) * stride);
+    std::vector<uint8_t> out;
+    QoiEncoder encoder(imgData.width, imgData.height, 3, out);
+    for (int mcuRow = 0; mcuRow < imgData.mcuHeight; ++mcuRow) {
+        int firstRow = mcuRow * bandRows;
+        fillPackedRows(imgData, mcuRow, mcuRow + 1, OutputFormat::Rgb, band.data(), stride, firstRow);
+        encoder.encodeRows(band.data(), std::min(bandRows, imgData.height - firstRow), stride);
+        file.write(reinterpret_cast<const char *>(out.data()), out.size());
+        out.clear();
+    }
+    encoder.finish();
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    return static_cast<bool>(file);
+}
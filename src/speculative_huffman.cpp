@@ -0,0 +1,224 @@
+#include "speculative_huffman.h"
+#include "decode_trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+// 每段至少这么多字节，段太短时同步开销相对过大
+constexpr size_t MIN_CHUNK_BYTES = 4096;
+
+// 推测序列中的一个块
+struct GuessedBlock {
+    size_t bit;
+    size_t endBit;
+    int dcDiff;
+    int blockInMcu;
+};
+
+// 一段的真实起点
+struct ChunkStart {
+    size_t bit = 0;
+    long block = 0;  // 全局块号：MCU 号 * 每 MCU 块数 + 块在 MCU 中的位置
+    int previousDc[3] = {0, 0, 0};
+};
+
+// 扫描中第 blockInMcu 个块使用的哈夫曼表与 DC 预测分量（顺序同 decodeMcuBlocks）
+struct ScanLayout {
+    int blocksPerMcu = 1;
+    int component[6] = {0, 0, 0, 0, 1, 2};
+    const HuffmanTable *dcTables[6] = {};
+    const HuffmanTable *acTables[6] = {};
+    // equivalent[a][b]：从 a、b 开始的哈夫曼表序列相同，两者解码同一段比特得到相同的块边界
+    bool equivalent[6][6] = {};
+
+    explicit ScanLayout(const HuffmanDecodeState &state, const ImageData &imgData) {
+        blocksPerMcu = imgData.isGrayscale() ? 1 : 6;
+        for (int b = 0; b < blocksPerMcu; ++b) {
+            if (blocksPerMcu == 1) component[b] = 0;
+            dcTables[b] = state.dcTables[component[b]];
+            acTables[b] = state.acTables[component[b]];
+        }
+        for (int a = 0; a < blocksPerMcu; ++a) {
+            for (int b = 0; b < blocksPerMcu; ++b) {
+                bool same = true;
+                for (int i = 0; i < blocksPerMcu && same; ++i) {
+                    int x = (a + i) % blocksPerMcu, y = (b + i) % blocksPerMcu;
+                    same = dcTables[x] == dcTables[y] && acTables[x] == acTables[y];
+                }
+                equivalent[a][b] = same;
+            }
+        }
+    }
+
+    // 与 decodeMcu 相同的存储位置，仅亮度模式下色度块为 nullptr
+    Coefficient *target(ImageData &imgData, long block) const {
+        long mcu = block / blocksPerMcu;
+        int b = static_cast<int>(block % blocksPerMcu);
+        if (blocksPerMcu == 1) return imgData.Y[mcu].data();
+        if (b < 4) return imgData.Y[mcu * 4 + b].data();
+        if (imgData.lumaOnly) return nullptr;
+        return b == 4 ? imgData.Cb[mcu].data() : imgData.Cr[mcu].data();
+    }
+};
+
+DecodeStatus decodeBlockDiff(BitStreamReader &reader, const ScanLayout &layout, int b, Coefficient *block,
+                             int &dcDiff, HuffmanDecodeMode mode) {
+    DecodeStatus status = decodeHuffmanDC(reader, *layout.dcTables[b], dcDiff, mode);
+    if (status != DecodeStatus::Ok) return status;
+    return decodeHuffmanAC(reader, *layout.acTables[b], block, mode);
+}
+
+// 第一阶段：从段首推测解码到块起点越过段尾（或块数达到上限）。错位的解码遇到无效码字时
+// 跳过一个比特、重新假定位于 MCU 的第一个块继续，因此相邻的两个块不一定首尾相接
+void guessChunk(const std::vector<uint8_t> &data, const ScanLayout &layout, size_t begin, size_t end,
+                long maxBlocks, HuffmanDecodeMode mode, std::vector<GuessedBlock> &guess) {
+    TraceScope trace("guess chunk");
+    BitStreamReader reader(data);
+    reader.seekBit(begin);
+    Coefficient scratch[64];
+    int b = 0;
+    while (reader.bitOffset() < end && static_cast<long>(guess.size()) < maxBlocks) {
+        GuessedBlock block{reader.bitOffset(), 0, 0, b};
+        if (decodeBlockDiff(reader, layout, b, scratch, block.dcDiff, mode) != DecodeStatus::Ok) {
+            reader.seekBit(block.bit + 1);
+            b = 0;
+            continue;
+        }
+        block.endBit = reader.bitOffset();
+        guess.push_back(block);
+        b = (b + 1) % layout.blocksPerMcu;
+    }
+}
+
+// 第三阶段：从已知的真实起点解码 [start.block, endBlock) 到 imgData，出错时与串行解码一样停在出错的块
+void decodeChunk(const std::vector<uint8_t> &data, const ScanLayout &layout, const ChunkStart &start, long endBlock,
+                 HuffmanDecodeMode mode, ImageData &imgData) {
+    TraceScope trace("decode chunk");
+    BitStreamReader reader(data);
+    reader.seekBit(start.bit);
+    int previousDc[3] = {start.previousDc[0], start.previousDc[1], start.previousDc[2]};
+    Coefficient scratch[64];
+    for (long block = start.block; block < endBlock; ++block) {
+        int b = static_cast<int>(block % layout.blocksPerMcu);
+        Coefficient *coefficients = layout.target(imgData, block);
+        if (!coefficients) coefficients = scratch;
+        int dcDiff = 0;
+        if (decodeHuffmanDC(reader, *layout.dcTables[b], dcDiff, mode) != DecodeStatus::Ok) return;
+        int &predictor = previousDc[layout.component[b]];
+        coefficients[0] = saturateCoefficient(dcDiff + predictor);
+        predictor = coefficients[0];
+        if (decodeHuffmanAC(reader, *layout.acTables[b], coefficients, mode) != DecodeStatus::Ok) return;
+    }
+}
+
+template <typename Task>
+void runParallel(int taskCount, int threadCount, Task task) {
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < std::min(threadCount, taskCount); ++w) {
+        workers.emplace_back([&]() {
+            for (int i = next++; i < taskCount; i = next++) task(i);
+        });
+    }
+    for (auto &worker : workers) worker.join();
+}
+} // namespace
+
+DecodeStatus speculativeHuffmanDecode(const std::vector<uint8_t> &compressedData, ImageData &imgData,
+                                      int threadCount, SpeculativeDecodeStats *stats, HuffmanDecodeMode mode) {
+    SpeculativeDecodeStats localStats;
+    SpeculativeDecodeStats &result = stats ? *stats : localStats;
+    result = SpeculativeDecodeStats();
+
+    long totalBlocks = static_cast<long>(imgData.mcuWidth) * imgData.mcuHeight * (imgData.isGrayscale() ? 1 : 6);
+    int chunkCount = static_cast<int>(std::min<size_t>(std::max(threadCount, 1), compressedData.size() / MIN_CHUNK_BYTES));
+    if (chunkCount <= 1 || imgData.restartInterval > 0) {
+        result.chunks = 1;
+        result.blocks = totalBlocks;
+        return huffmanDecode(compressedData, imgData, mode);
+    }
+
+    HuffmanDecodeState state(compressedData);
+    DecodeStatus status = initHuffmanDecodeState(state, imgData);
+    if (status != DecodeStatus::Ok) return status;
+    const ScanLayout layout(state, imgData);
+
+    // 段边界按比特均分，最后一段延伸到数据末尾
+    size_t totalBits = compressedData.size() * 8;
+    std::vector<size_t> chunkEnd(chunkCount);
+    for (int k = 0; k < chunkCount; ++k) chunkEnd[k] = totalBits / chunkCount * (k + 1);
+    chunkEnd.back() = totalBits;
+
+    auto elapsedMs = [](std::chrono::steady_clock::time_point &since) {
+        auto now = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - since).count();
+        since = now;
+        return ms;
+    };
+    auto phaseStart = std::chrono::steady_clock::now();
+    std::vector<std::vector<GuessedBlock>> guesses(chunkCount);
+    runParallel(chunkCount, threadCount, [&](int k) {
+        guessChunk(compressedData, layout, k == 0 ? 0 : chunkEnd[k - 1], chunkEnd[k], totalBlocks, mode, guesses[k]);
+    });
+    result.guessMs = elapsedMs(phaseStart);
+
+    // 第二阶段：串行确定每段的真实起点
+    std::vector<ChunkStart> starts;
+    long block = 0;
+    long errorBlocks = 0;  // 出错时包含出错的块，第三阶段要把它解码到同样的中间状态
+    {
+        TraceScope trace("sync chunks");
+        ChunkStart current;
+        BitStreamReader reader(compressedData);
+        Coefficient scratch[64];
+        for (int k = 0; k < chunkCount && block < totalBlocks && status == DecodeStatus::Ok; ++k) {
+            current.block = block;
+            starts.push_back(current);
+            const std::vector<GuessedBlock> &guessed = guesses[k];
+            size_t j = 0;
+            bool synced = false;
+            while (block < totalBlocks) {
+                if (k + 1 < chunkCount && current.bit >= chunkEnd[k]) break;
+                while (j < guessed.size() && guessed[j].bit < current.bit) ++j;
+                int b = static_cast<int>(block % layout.blocksPerMcu);
+                if (j < guessed.size() && guessed[j].bit == current.bit && layout.equivalent[guessed[j].blockInMcu][b]) {
+                    // 采用推测的块，只需按真实的块位置累加 DC 差分
+                    synced = true;
+                    int &predictor = current.previousDc[layout.component[b]];
+                    predictor = saturateCoefficient(guessed[j].dcDiff + predictor);
+                    current.bit = guessed[j].endBit;
+                    ++block;
+                    ++j;
+                    continue;
+                }
+
+                // 真实状态不在推测序列上：逐块解码，直到与推测序列重合
+                reader.seekBit(current.bit);
+                int dcDiff = 0;
+                status = decodeBlockDiff(reader, layout, b, scratch, dcDiff, mode);
+                result.redecodedBlocks++;
+                if (status != DecodeStatus::Ok) {
+                    errorBlocks = 1;
+                    break;
+                }
+                int &predictor = current.previousDc[layout.component[b]];
+                predictor = saturateCoefficient(dcDiff + predictor);
+                current.bit = reader.bitOffset();
+                ++block;
+            }
+            if (synced) result.syncedChunks++;
+        }
+    }
+    result.chunks = chunkCount;
+    result.blocks = block;
+    result.syncMs = elapsedMs(phaseStart);
+
+    runParallel(static_cast<int>(starts.size()), threadCount, [&](int k) {
+        long endBlock = k + 1 < static_cast<int>(starts.size()) ? starts[k + 1].block : block + errorBlocks;
+        decodeChunk(compressedData, layout, starts[k], endBlock, mode, imgData);
+    });
+    result.decodeMs = elapsedMs(phaseStart);
+    return status;
+}